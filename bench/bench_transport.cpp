@@ -0,0 +1,144 @@
+#include "http2_client.h"
+#include "loopback_server.h"
+#include "uring.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace http2;
+
+struct RunResult {
+    size_t requests = 0;
+    size_t failures = 0;
+    double seconds = 0;
+    EventLoop::Stats stats;
+};
+
+static void report(const char* name, const RunResult& result) {
+    double per_second = result.requests / result.seconds;
+    double syscalls = static_cast<double>(result.stats.total()) / result.requests;
+    std::printf("  %-15s %9.0f req/s  %6.2f syscalls/req  (wait %.2f, ctl %.2f, io %.2f)%s\n",
+                name, per_second, syscalls,
+                static_cast<double>(result.stats.wait_calls) / result.requests,
+                static_cast<double>(result.stats.ctl_calls) / result.requests,
+                static_cast<double>(result.stats.io_calls) / result.requests,
+                result.failures ? "  FAILURES" : "");
+}
+
+static EventLoop::Stats difference(const EventLoop::Stats& end, const EventLoop::Stats& start) {
+    EventLoop::Stats stats;
+    stats.wait_calls = end.wait_calls - start.wait_calls;
+    stats.ctl_calls = end.ctl_calls - start.ctl_calls;
+    stats.io_calls = end.io_calls - start.io_calls;
+    return stats;
+}
+
+/**
+ * 同步路径：一个连接上依次 get()，每个请求等待响应后再发下一个
+ */
+static RunResult runSync(EventLoop::Backend backend, uint16_t port, size_t requests) {
+    RunResult result;
+    EventLoop loop(backend);
+    Http2Client client("127.0.0.1", port, &loop);
+    if (!client.connect()) {
+        result.failures = requests;
+        result.requests = requests;
+        result.seconds = 1;
+        return result;
+    }
+
+    EventLoop::Stats before = loop.stats();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < requests; ++i) {
+        if (client.get("/").status_code != 200) {
+            ++result.failures;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    result.requests = requests;
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    result.stats = difference(loop.stats(), before);
+    return result;
+}
+
+/**
+ * 异步路径：多个连接共享一个事件循环，每个连接保持 depth 个在途请求
+ */
+static RunResult runAsync(EventLoop::Backend backend, uint16_t port, size_t requests,
+                          size_t connections, size_t depth) {
+    RunResult result;
+    EventLoop loop(backend);
+    std::vector<std::unique_ptr<Http2Client>> clients;
+    size_t connected = 0;
+    for (size_t i = 0; i < connections; ++i) {
+        clients.push_back(std::make_unique<Http2Client>("127.0.0.1", port, &loop));
+        clients.back()->connectAsync([&connected](bool) { ++connected; });
+    }
+    while (connected < connections) {
+        loop.runOnce(1000);
+    }
+
+    size_t issued = 0;
+    size_t completed = 0;
+    std::function<void(Http2Client&)> issue = [&](Http2Client& client) {
+        ++issued;
+        client.submitAsync("GET", "/", {}, [&](Http2Client::Response&& response) {
+            ++completed;
+            if (response.status_code != 200) {
+                ++result.failures;
+            }
+            if (issued < requests) {
+                issue(client);
+            } else if (completed == requests) {
+                loop.stop();
+            }
+        });
+    };
+
+    EventLoop::Stats before = loop.stats();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t d = 0; d < depth; ++d) {
+        for (auto& client : clients) {
+            if (issued < requests) {
+                issue(*client);
+            }
+        }
+    }
+    loop.run();
+    auto end = std::chrono::steady_clock::now();
+    result.requests = completed;
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    result.stats = difference(loop.stats(), before);
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    size_t requests = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    size_t connections = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 4;
+    size_t depth = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 32;
+
+    LoopbackServer server;
+    bool uring = IoUring::supported();
+
+    std::cout << "== Sequential get() (" << requests / 4 << " requests, 1 connection) =="
+              << std::endl;
+    report("epoll", runSync(EventLoop::Backend::EPOLL, server.port(), requests / 4));
+    if (uring) {
+        report("io_uring", runSync(EventLoop::Backend::IO_URING, server.port(), requests / 4));
+    }
+
+    std::cout << "== Pipelined submitAsync() (" << requests << " requests, " << connections
+              << " connections x " << depth << " in flight) ==" << std::endl;
+    report("epoll", runAsync(EventLoop::Backend::EPOLL, server.port(), requests, connections, depth));
+    if (uring) {
+        report("io_uring",
+               runAsync(EventLoop::Backend::IO_URING, server.port(), requests, connections, depth));
+    } else {
+        std::cout << "  io_uring is not available on this kernel" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,105 @@
+#ifndef HTTP2_BATCH_DECODER_H
+#define HTTP2_BATCH_DECODER_H
+
+#include "hpack.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace http2 {
+
+/**
+ * @struct HeaderBlockJob
+ * @brief 批量解码中的一个头块
+ *
+ * decoder 是头块所属连接的解码器；同一个解码器的多个头块按它们在批次中的
+ * 顺序依次解码。头块数据在 BatchDecoder::decode 返回前必须保持有效。
+ */
+struct HeaderBlockJob {
+    HpackDecoder* decoder;
+    const uint8_t* data;
+    size_t length;
+    std::vector<std::pair<std::string, std::string>> headers;  // 输出
+};
+
+/**
+ * @class BatchDecoder
+ * @brief 用线程池并行解码多个连接的头块
+ *
+ * 同一连接（同一个 HpackDecoder）的头块组成一条链，在一个线程上按顺序解码，
+ * 保证动态表的更新顺序；不同连接的链并行执行。链按轮转分配到各线程的本地
+ * 队列，线程处理完自己的队列后从其他线程的队列尾部窃取，平衡负载不均的批次。
+ *
+ * 调用线程也参与解码，因此 thread_count 为 1 时不创建额外线程。
+ */
+class BatchDecoder {
+public:
+    /**
+     * @brief 构造函数
+     *
+     * @param thread_count 参与解码的线程数（含调用线程），0 表示使用硬件并发数
+     */
+    explicit BatchDecoder(size_t thread_count = 0);
+    ~BatchDecoder();
+
+    BatchDecoder(const BatchDecoder&) = delete;
+    BatchDecoder& operator=(const BatchDecoder&) = delete;
+
+    /**
+     * @brief 解码一批头块，全部完成后返回
+     *
+     * @param jobs 头块列表，解码结果写入各自的 headers
+     * @throws 任一头块解码时抛出的第一个异常（其余头块仍会解码完成）
+     */
+    void decode(std::vector<HeaderBlockJob>& jobs);
+
+    /**
+     * @brief 参与解码的线程数（含调用线程）
+     */
+    size_t threadCount() const;
+
+    /**
+     * @brief 最近一次 decode 中通过窃取执行的链数
+     */
+    size_t lastStealCount() const;
+
+private:
+    // 一条链：同一解码器的头块在 jobs 中的位置，按顺序排列
+    using Chain = std::vector<size_t>;
+
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Chain*> chains;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::vector<std::thread> threads_;
+
+    std::mutex mutex_;
+    std::condition_variable work_ready_;
+    std::condition_variable work_done_;
+    uint64_t generation_;        // 每个批次递增，唤醒工作线程
+    size_t active_workers_;      // 仍在处理当前批次的工作线程数
+    bool stopping_;
+
+    std::vector<HeaderBlockJob>* jobs_;
+    std::exception_ptr error_;
+    size_t steal_count_;
+
+    void workerLoop(size_t worker);
+    void runWorker(size_t worker);
+    Chain* nextChain(size_t worker);
+    void runChain(const Chain& chain);
+};
+
+} // namespace http2
+
+#endif // HTTP2_BATCH_DECODER_H
@@ -0,0 +1,170 @@
+#ifndef HTTP2_EVENT_LOOP_H
+#define HTTP2_EVENT_LOOP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace http2 {
+
+class IoUring;
+
+/**
+ * @class EventLoop
+ * @brief 基于 epoll 的单线程反应器
+ *
+ * 每个文件描述符注册一个回调，runOnce() 等待就绪事件并逐个分发。
+ * 一个线程上的一个 EventLoop 可以驱动任意数量的非阻塞连接。
+ * 回调中可以安全地注册、修改或移除任何描述符（包括自身），也可以嵌套
+ * 调用 runOnce()：嵌套的一轮分发其他就绪的描述符，外层随后继续分发
+ * 自己取回的事件（其中的描述符可能已被嵌套的一轮处理过，需要容忍
+ * EAGAIN）。
+ *
+ * 延迟任务（defer）在每一轮等待之前和分发之后运行，用于把一轮中
+ * 产生的多次写合并为一次。
+ *
+ * 事件掩码直接使用 EPOLLIN/EPOLLOUT 等 epoll 常量；回调收到的掩码中
+ * EPOLLERR/EPOLLHUP 总是可能出现。
+ *
+ * IO_URING 后端在同一线程上额外提供一个 IoUring：连接可以把 socket
+ * 读写直接提交到 uring()，由 runOnce() 的 io_uring_enter 批量提交并等待；
+ * 用 add() 注册的描述符仍然有效（epoll 实例本身以 multishot poll 挂在环上）。
+ */
+class EventLoop {
+public:
+    using Callback = std::function<void(uint32_t events)>;
+    using DeferredTask = std::function<void()>;
+
+    enum class Backend {
+        EPOLL,
+        IO_URING
+    };
+
+    // 系统调用计数，用于比较不同后端每个请求的开销
+    struct Stats {
+        uint64_t wait_calls = 0;  // epoll_wait 与 io_uring_enter
+        uint64_t ctl_calls = 0;   // epoll_ctl
+        uint64_t io_calls = 0;    // 通过 recordIo() 报告的 read/write
+
+        uint64_t total() const {
+            return wait_calls + ctl_calls + io_calls;
+        }
+    };
+
+    /**
+     * @brief 构造函数
+     *
+     * @param backend 事件后端
+     * @throws std::runtime_error 如果 epoll 实例或 io_uring 创建失败
+     */
+    explicit EventLoop(Backend backend = Backend::EPOLL);
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    /**
+     * @brief 注册描述符
+     *
+     * @param fd 非阻塞描述符
+     * @param events 关注的事件（EPOLLIN、EPOLLOUT 的组合）
+     * @param callback 事件回调
+     * @return true 如果成功，false 如果 epoll_ctl 失败
+     */
+    bool add(int fd, uint32_t events, Callback callback);
+
+    /**
+     * @brief 修改描述符关注的事件
+     *
+     * @return true 如果成功，false 如果描述符未注册或 epoll_ctl 失败
+     */
+    bool modify(int fd, uint32_t events);
+
+    /**
+     * @brief 移除描述符（不关闭它）
+     */
+    void remove(int fd);
+
+    /**
+     * @brief 登记一个延迟任务，在本轮分发结束时（或下一轮等待之前）运行一次
+     *
+     * @return 任务ID，用于 cancelDeferred()
+     */
+    uint64_t defer(DeferredTask task);
+
+    /**
+     * @brief 取消尚未运行的延迟任务
+     */
+    void cancelDeferred(uint64_t id);
+
+    /**
+     * @brief 等待并分发一轮事件
+     *
+     * @param timeout_ms 最长等待时间（毫秒），-1 表示无限等待
+     * @return 分发的事件数
+     */
+    size_t runOnce(int timeout_ms = -1);
+
+    /**
+     * @brief 循环分发事件直到 stop() 被调用，或者既没有注册的描述符、
+     *        延迟任务，也没有未完成的 io_uring 操作
+     */
+    void run();
+
+    /**
+     * @brief 让 run() 在当前一轮结束后返回
+     */
+    void stop();
+
+    /**
+     * @brief 已注册的描述符数量
+     */
+    size_t size() const;
+
+    Backend backend() const;
+
+    /**
+     * @brief IO_URING 后端的环，EPOLL 后端返回 nullptr
+     */
+    IoUring* uring();
+
+    /**
+     * @brief 报告在循环之外发生的 socket 读写系统调用
+     */
+    void recordIo(uint64_t calls = 1);
+
+    Stats stats() const;
+
+private:
+    struct Watch {
+        uint32_t events;
+        Callback callback;
+    };
+
+    int epoll_fd_;
+    bool stopping_;
+    // 回调按描述符查找：同一轮中先分发的回调可能移除后面的描述符
+    std::unordered_map<int, std::shared_ptr<Watch>> watches_;
+    Stats stats_;
+
+    // 延迟任务：按登记顺序运行；取消只需从表中删除
+    std::unordered_map<uint64_t, DeferredTask> deferred_;
+    std::vector<uint64_t> deferred_order_;
+    uint64_t next_deferred_;
+
+    // IO_URING 后端：epoll 实例可读时 poll 完成，下一轮再非阻塞地取回事件
+    std::unique_ptr<IoUring> uring_;
+    bool epoll_armed_;
+    bool epoll_ready_;
+
+    size_t dispatchReady(int timeout_ms);
+    size_t dispatchRing(int timeout_ms);
+    void runDeferred();
+};
+
+} // namespace http2
+
+#endif // HTTP2_EVENT_LOOP_H
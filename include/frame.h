@@ -0,0 +1,199 @@
+#ifndef HTTP2_FRAME_H
+#define HTTP2_FRAME_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace http2 {
+
+// HTTP/2帧头长度（RFC 9113 4.1）
+constexpr size_t FRAME_HEADER_SIZE = 9;
+
+// SETTINGS_MAX_FRAME_SIZE 的默认值与上限
+constexpr uint32_t DEFAULT_MAX_FRAME_SIZE = 16384;
+constexpr uint32_t MAX_ALLOWED_FRAME_SIZE = 16777215;
+
+// 流量控制窗口的初始值与上限（RFC 9113 6.9）
+constexpr uint32_t DEFAULT_WINDOW_SIZE = 65535;
+constexpr uint32_t MAX_WINDOW_SIZE = 0x7FFFFFFF;
+
+// HTTP/2帧类型
+constexpr uint8_t FRAME_TYPE_DATA = 0x0;
+constexpr uint8_t FRAME_TYPE_HEADERS = 0x1;
+constexpr uint8_t FRAME_TYPE_PRIORITY = 0x2;
+constexpr uint8_t FRAME_TYPE_RST_STREAM = 0x3;
+constexpr uint8_t FRAME_TYPE_SETTINGS = 0x4;
+constexpr uint8_t FRAME_TYPE_PUSH_PROMISE = 0x5;
+constexpr uint8_t FRAME_TYPE_PING = 0x6;
+constexpr uint8_t FRAME_TYPE_GOAWAY = 0x7;
+constexpr uint8_t FRAME_TYPE_WINDOW_UPDATE = 0x8;
+constexpr uint8_t FRAME_TYPE_CONTINUATION = 0x9;
+
+// HTTP/2帧头标志
+constexpr uint8_t FLAG_ACK = 0x1;
+constexpr uint8_t FLAG_END_STREAM = 0x1;
+constexpr uint8_t FLAG_END_HEADERS = 0x4;
+constexpr uint8_t FLAG_PADDED = 0x8;
+constexpr uint8_t FLAG_PRIORITY = 0x20;
+
+/**
+ * @struct FrameHeader
+ * @brief HTTP/2帧头（9字节）的解析结果
+ */
+struct FrameHeader {
+    uint32_t length;     // 负载长度（24位）
+    uint8_t type;        // 帧类型
+    uint8_t flags;       // 帧标志
+    uint32_t stream_id;  // 流ID（31位）
+};
+
+/**
+ * @brief 将帧头写入9字节缓冲区
+ *
+ * @param out 输出位置（至少9字节）
+ * @param header 帧头
+ */
+void writeFrameHeader(uint8_t* out, const FrameHeader& header);
+
+/**
+ * @brief 从9字节缓冲区解析帧头
+ *
+ * @param data 输入位置（至少9字节）
+ * @return FrameHeader 解析结果（流ID最高保留位被清除）
+ */
+FrameHeader readFrameHeader(const uint8_t* data);
+
+/**
+ * @class HeaderFrameBuilder
+ * @brief 直接在发送缓冲区中构建 HEADERS + CONTINUATION 帧
+ *
+ * 构造时在缓冲区末尾预留帧头空间，编码器把头块直接追加到同一个缓冲区；
+ * finish() 就地填写帧头。头块超过 max_frame_size 时在原缓冲区内拆分为
+ * HEADERS 和若干 CONTINUATION 帧，每个字节最多移动一次，不需要额外的头块副本。
+ */
+class HeaderFrameBuilder {
+public:
+    /**
+     * @brief 构造函数
+     *
+     * @param out 发送缓冲区（追加写入）
+     * @param stream_id 流ID
+     * @param max_frame_size 对端的 SETTINGS_MAX_FRAME_SIZE
+     */
+    HeaderFrameBuilder(std::vector<uint8_t>& out, uint32_t stream_id,
+                       uint32_t max_frame_size = DEFAULT_MAX_FRAME_SIZE);
+
+    /**
+     * @brief 编码器写入头块的目标缓冲区
+     */
+    std::vector<uint8_t>& block();
+
+    /**
+     * @brief 填写帧头并按需拆分为 CONTINUATION 帧
+     *
+     * @param end_stream 是否在 HEADERS 帧上设置 END_STREAM
+     * @return 生成的帧数量
+     */
+    size_t finish(bool end_stream);
+
+private:
+    std::vector<uint8_t>& out_;
+    size_t frame_start_;
+    uint32_t stream_id_;
+    uint32_t max_frame_size_;
+};
+
+/**
+ * @struct FrameView
+ * @brief 引用接收缓冲区的完整帧
+ *
+ * payload 指向 FrameReader 的缓冲区，在下一次 next() 或 commit() 之前有效。
+ * 处理填充等字段时可以就地收窄 payload/length。
+ */
+struct FrameView {
+    FrameHeader header;
+    uint8_t* payload;
+    size_t length;
+};
+
+/**
+ * @class FrameReader
+ * @brief 接收环形缓冲区：大块写入，按帧就地解析
+ *
+ * 同一段共享内存被连续映射两次，环尾绕回时数据在虚拟地址上仍然连续：
+ * 写入方总能拿到一整段可写空间，跨越环尾的帧也能以单个视图返回，
+ * 不需要搬移未解析的尾部或复制负载。
+ *
+ * 容量不足以容纳一个完整帧时扩大到两个帧的大小（按页对齐），大帧在解析时
+ * 下一帧可以继续接收；其余时候不再分配内存。
+ */
+class FrameReader {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 65536;
+
+    /**
+     * @brief 构造函数
+     *
+     * @param capacity 缓冲区容量（向上取整到页大小）
+     * @throws std::runtime_error 如果共享内存创建或映射失败
+     */
+    explicit FrameReader(size_t capacity = DEFAULT_CAPACITY);
+    ~FrameReader();
+
+    FrameReader(const FrameReader&) = delete;
+    FrameReader& operator=(const FrameReader&) = delete;
+
+    /**
+     * @brief 可写空间的起始位置，连续 writable() 字节
+     */
+    uint8_t* writePointer();
+    size_t writable() const;
+
+    /**
+     * @brief 确认写入了 length 字节
+     */
+    void commit(size_t length);
+
+    /**
+     * @brief 读取下一个帧的帧头，不取出帧
+     *
+     * 用于在接收负载之前检查帧长度，拒绝超过本端 SETTINGS_MAX_FRAME_SIZE 的帧。
+     *
+     * @return true 如果已经收到完整的帧头
+     */
+    bool peek(FrameHeader& header) const;
+
+    /**
+     * @brief 取出下一个完整帧
+     *
+     * @param frame 输出的帧视图
+     * @return true 如果取出了一个帧，false 如果剩余数据还不是完整帧
+     */
+    bool next(FrameView& frame);
+
+    /**
+     * @brief 尚未被 next() 取出的字节数
+     */
+    size_t buffered() const;
+
+    size_t capacity() const;
+
+    /**
+     * @brief 丢弃所有数据（新连接）
+     */
+    void clear();
+
+private:
+    uint8_t* base_;     // 映射起点，[base_, base_ + 2 * capacity_) 有效
+    size_t capacity_;
+    size_t read_;       // 读位置（小于 capacity_）
+    size_t size_;       // 已写入未取出的字节数
+
+    void map(size_t capacity);
+    void grow(size_t capacity);
+};
+
+} // namespace http2
+
+#endif // HTTP2_FRAME_H
@@ -8,10 +8,67 @@
 
 namespace http2 {
 
+/**
+ * @struct HeaderValidation
+ * @brief Compact summary of a validated header list
+ *
+ * Pseudo-header presence is recorded as a bitmask so callers can check
+ * request/response shape without searching the header list again.
+ */
+struct HeaderValidation {
+    static constexpr uint8_t PSEUDO_METHOD    = 0x01;
+    static constexpr uint8_t PSEUDO_SCHEME    = 0x02;
+    static constexpr uint8_t PSEUDO_AUTHORITY = 0x04;
+    static constexpr uint8_t PSEUDO_PATH      = 0x08;
+    static constexpr uint8_t PSEUDO_STATUS    = 0x10;
+    static constexpr uint8_t PSEUDO_PROTOCOL  = 0x20;
+
+    uint8_t pseudo_headers = 0;     // Bitmask of PSEUDO_* flags seen
+    const char* error = nullptr;    // First violation found, nullptr if valid
+
+    bool valid() const { return error == nullptr; }
+    bool has(uint8_t pseudo) const { return (pseudo_headers & pseudo) == pseudo; }
+};
+
+/**
+ * @class HeaderValidator
+ * @brief Incremental RFC 9113 section 8 header list validator
+ *
+ * Fields are fed one at a time, either from an already decoded list or
+ * directly from the HPACK decoder, so validation never needs a second
+ * traversal. Checks performed per field:
+ * - name/value syntax per RFC 9113 section 8.2.1: lowercase names without
+ *   controls or spaces, values without NUL/CR/LF (empty values are allowed)
+ * - pseudo-headers are known, appear once, and precede regular fields
+ * - request and response pseudo-headers are not mixed
+ * - connection-specific fields are rejected, and `te` only allows "trailers"
+ */
+class HeaderValidator {
+public:
+    /**
+     * @brief Validate the next field of the header list
+     * @param name Header name
+     * @param value Header value
+     * @return false once the list is known to be malformed
+     */
+    bool addField(const std::string& name, const std::string& value);
+
+    /**
+     * @brief Summary of all fields seen so far
+     */
+    const HeaderValidation& result() const { return result_; }
+
+private:
+    HeaderValidation result_;
+    bool seen_regular_ = false;
+
+    bool fail(const char* reason);
+};
+
 /**
  * @class HeaderParser
  * @brief Parser for HTTP/2 headers
- * 
+ *
  * Handles parsing and validation of HTTP/2 headers according to RFC 7540
  */
 class HeaderParser {
@@ -20,19 +77,43 @@ public:
      * @brief Parse header block from buffer
      * @param buffer Raw header block bytes
      * @param length Length of header block
+     * @param join_cookies Rejoin cookie crumbs into a single "cookie" field
      * @return Parsed headers as key-value pairs
      */
     static std::vector<std::pair<std::string, std::string>> parseHeaders(
-        const uint8_t* buffer, 
-        size_t length
+        const uint8_t* buffer,
+        size_t length,
+        bool join_cookies = false
+    );
+
+    /**
+     * @brief Parse and validate header block in a single pass
+     *
+     * Each field is validated as soon as the HPACK decoder produces it.
+     * The whole block is still decoded on failure so the dynamic table
+     * stays in sync with the peer.
+     *
+     * @param buffer Raw header block bytes
+     * @param length Length of header block
+     * @param validation Output: validation summary
+     * @param join_cookies Rejoin cookie crumbs into a single "cookie" field
+     * @return Parsed headers, or empty if the header list is malformed
+     */
+    static std::vector<std::pair<std::string, std::string>> parseHeaders(
+        const uint8_t* buffer,
+        size_t length,
+        HeaderValidation& validation,
+        bool join_cookies = false
     );
 
     /**
      * @brief Validate header fields
      * @param headers Headers to validate
+     * @param summary Optional output: pseudo-header summary and first error
      * @return true if headers are valid, false otherwise
      */
-    static bool validateHeaders(const std::vector<std::pair<std::string, std::string>>& headers);
+    static bool validateHeaders(const std::vector<std::pair<std::string, std::string>>& headers,
+                                HeaderValidation* summary = nullptr);
 
     /**
      * @brief Check if header name is valid
@@ -6,6 +6,15 @@
 #include <cstdint>
 #include <utility>
 #include <stdexcept>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <list>
+#include <memory>
+#include <memory_resource>
+#include <string_view>
+#include <unordered_map>
 
 namespace http2 {
 
@@ -18,6 +27,14 @@ struct HeaderField {
     std::string value;
 };
 
+/**
+ * @brief Header list whose strings and storage come from one memory resource
+ *
+ * Used with a per-stream arena (see stream_arena.h) so decoding a header
+ * block does not allocate each string separately.
+ */
+using PmrHeaderList = std::pmr::vector<std::pair<std::pmr::string, std::pmr::string>>;
+
 /**
  * @class IntegerEncoder
  * @brief Encodes and decodes integers according to RFC 7541 section 6.1
@@ -80,7 +97,8 @@ public:
      * @param str The string to encode
      * @param use_huffman If true, use Huffman encoding; if false, use literal encoding
      * @return Encoded bytes
-     * @note Huffman encoding is not yet implemented; use_huffman=true will throw
+     * @note Huffman results for strings of at least HuffmanCache::MIN_CACHED_LENGTH
+     *       bytes are memoized in HuffmanCache::encodeCache()
      */
     static std::vector<uint8_t> encodeString(const std::string& str, bool use_huffman = false);
 
@@ -92,13 +110,139 @@ public:
      * @return Pair of (decoded_string, bytes_consumed)
      * @throws std::out_of_range if buffer is too short
      * @throws std::runtime_error if Huffman decoding encounters invalid padding
+     * @note Huffman results for strings of at least HuffmanCache::MIN_CACHED_LENGTH
+     *       encoded bytes are memoized in HuffmanCache::decodeCache()
      */
     static std::pair<std::string, size_t> decodeString(const uint8_t* data, size_t length);
 
+    /**
+     * @brief Exact length in bytes of the Huffman coding of a string
+     *
+     * Sums per-symbol code lengths without producing any output, using AVX2
+     * gathers over a 256-entry length table when the CPU supports them.
+     * Encoders use it to choose the H flag (Huffman only when shorter than
+     * the raw string) and to reserve the output buffer up front.
+     *
+     * @param str The string to measure
+     * @return Encoded length including EOS padding
+     */
+    static size_t huffmanEncodedLength(std::string_view str);
+
+    /**
+     * @brief Location of a Huffman-coded string payload (without length prefix)
+     */
+    struct HuffmanSpan {
+        const uint8_t* data;
+        size_t length;
+    };
+
+    /**
+     * @brief Decode several independent Huffman strings in one interleaved loop
+     *
+     * Up to four strings are decoded concurrently, one symbol per string per
+     * iteration, so the table lookups of different strings overlap instead of
+     * serializing. Long strings are served from HuffmanCache::decodeCache().
+     *
+     * @param spans Huffman payloads, usually found by a pre-scan of a header block
+     * @param count Number of spans
+     * @param out Output strings (count entries, overwritten)
+     */
+    static void decodeHuffmanBatch(const HuffmanSpan* spans, size_t count, std::string* out);
+
 private:
     // Huffman encoding/decoding is implemented in the cpp file
 };
 
+/**
+ * @class HuffmanCache
+ * @brief Small LRU cache of Huffman coding results
+ *
+ * Peers often resend the same large literals without indexing (set-cookie,
+ * authorization), and senders encode the same user-agent/authority values
+ * on every request. The cache maps the input bytes (Huffman-coded for the
+ * decode cache, raw for the encode cache) to the coded result so repeated
+ * literals skip the bit-level work. Entries are looked up by hash and the
+ * full key is compared, so collisions never return a wrong result.
+ *
+ * StringCoder uses one decode cache and one encode cache per thread, which
+ * needs no locking and covers every connection served by that thread.
+ */
+class HuffmanCache {
+public:
+    // Shorter strings are cheaper to code than to hash and look up
+    static constexpr size_t MIN_CACHED_LENGTH = 16;
+
+    /**
+     * @brief Lookup counters
+     */
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+
+        double hitRate() const {
+            uint64_t total = hits + misses;
+            return total == 0 ? 0.0 : static_cast<double>(hits) / total;
+        }
+    };
+
+    /**
+     * @brief Constructor
+     *
+     * @param capacity Maximum number of entries (0 disables the cache)
+     * @param max_entry_size Keys longer than this are never cached
+     */
+    explicit HuffmanCache(size_t capacity = 256, size_t max_entry_size = 4096);
+
+    /**
+     * @brief Look up a key and mark it most recently used
+     *
+     * @return Cached result, or nullptr on a miss. The pointer is valid until
+     *         the next insert() or clear().
+     */
+    const std::string* find(std::string_view key);
+
+    /**
+     * @brief Insert a result, evicting the least recently used entry if full
+     */
+    void insert(std::string_view key, std::string value);
+
+    void clear();
+    size_t size() const { return entries_.size(); }
+    size_t capacity() const { return capacity_; }
+
+    /**
+     * @brief Change the capacity, evicting entries as needed
+     */
+    void setCapacity(size_t capacity);
+
+    const Stats& stats() const { return stats_; }
+    void resetStats() { stats_ = Stats{}; }
+
+    /**
+     * @brief Per-thread cache used by StringCoder::decodeString
+     */
+    static HuffmanCache& decodeCache();
+
+    /**
+     * @brief Per-thread cache used by StringCoder::encodeString
+     */
+    static HuffmanCache& encodeCache();
+
+private:
+    struct Entry {
+        std::string key;
+        std::string value;
+    };
+
+    size_t capacity_;
+    size_t max_entry_size_;
+    std::list<Entry> entries_;  // Most recently used first
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> index_;
+    Stats stats_;
+
+    void evictOverflow();
+};
+
 /**
  * @class StaticTable
  * @brief HTTP/2 HPACK 静态表实现（RFC 7541 附录 B）
@@ -178,6 +322,15 @@ public:
      */
     HeaderField get(size_t index) const;
 
+    /**
+     * @brief 通过索引访问头字段（不复制）
+     *
+     * @param index 索引值（0-based），0 是最新的条目
+     * @return 条目引用，在下一次修改表之前有效
+     * @throws std::out_of_range 如果索引超出范围
+     */
+    const HeaderField& at(size_t index) const;
+
     /**
      * @brief 通过名值对查询头字段索引
      * 
@@ -221,10 +374,39 @@ public:
      */
     size_t entryCount() const;
 
+    /**
+     * @brief 获取动态表最大大小
+     * @return 字节数
+     */
+    size_t maxSize() const;
+
+    /**
+     * @brief 获取累计淘汰的条目数
+     * @return 自构造以来因插入或缩小而淘汰的条目数
+     */
+    size_t evictionCount() const;
+
+    /**
+     * @brief 估算持有的堆内存（字节）：条目存储容量加上字符串容量
+     */
+    size_t retainedBytes() const;
+
+    /**
+     * @brief 计算某个条目被淘汰前还能插入多少字节
+     *
+     * 等于剩余空间加上比该条目更旧的所有条目大小。
+     *
+     * @param index 索引值（0-based）
+     * @return 字节数
+     * @throws std::out_of_range 如果索引超出范围
+     */
+    size_t bytesUntilEviction(size_t index) const;
+
 private:
     std::vector<HeaderField> entries_;  // 存储头字段条目
     size_t max_size_;                    // 最大大小（字节）
     size_t current_size_;                // 当前占用大小（字节）
+    size_t eviction_count_;              // 累计淘汰条目数
 
     /**
      * @brief 计算头字段的大小（RFC 7541）
@@ -259,6 +441,15 @@ public:
      */
     HeaderField getByIndex(size_t index) const;
 
+    /**
+     * @brief 通过统一索引获取头字段视图（不复制字符串）
+     *
+     * @param index 索引值（1-61 为静态表，62+ 为动态表）
+     * @return 名称和值的视图，在下一次修改动态表之前有效
+     * @throws std::out_of_range 如果索引超出范围
+     */
+    std::pair<std::string_view, std::string_view> viewByIndex(size_t index) const;
+
     /**
      * @brief 通过名值对查询头字段索引（同时搜索静态表和动态表）
      * 
@@ -295,8 +486,26 @@ public:
      */
     void clearDynamic();
 
+    /**
+     * @brief 获取表状态版本号
+     *
+     * 每次修改动态表都会分配一个进程内唯一的新版本号，
+     * 版本号相同即表示索引布局完全相同，可用作编码结果的缓存键。
+     *
+     * @return 当前状态版本号
+     */
+    uint64_t version() const;
+
+    /**
+     * @brief 只读访问动态表（用于统计和编码策略）
+     */
+    const DynamicTable& dynamicTable() const;
+
 private:
     DynamicTable dynamic_table_;  // 动态表
+    uint64_t version_;            // 表状态版本号
+
+    void bumpVersion();
 };
 
 /**
@@ -307,6 +516,16 @@ private:
  */
 class HPACK {
 public:
+    /**
+     * @brief 逐字段解码回调：每解出一个头字段调用一次
+     */
+    using HeaderCallback = std::function<void(const std::string& name, const std::string& value)>;
+
+    /**
+     * @brief 逐字段解码回调（视图形式）：视图只在回调期间有效
+     */
+    using HeaderViewCallback = std::function<void(std::string_view name, std::string_view value)>;
+
     /**
      * @brief 使用 HPACK 编码头字段
      * @param headers 头字段名-值对向量
@@ -321,10 +540,745 @@ public:
      */
     static std::vector<std::pair<std::string, std::string>> decode(const std::vector<uint8_t>& buffer);
 
+    /**
+     * @brief 流式解码 HPACK 缓冲区，每个头字段解出后立即回调
+     *
+     * 调用方可以在解码的同时完成校验或转换，无需对结果再遍历一次。
+     * 无论回调如何处理字段，整个头块都会被完整解码，以保持动态表同步。
+     *
+     * @param data 编码数据起始地址
+     * @param length 编码数据长度
+     * @param on_header 每个头字段的回调
+     */
+    static void decode(const uint8_t* data, size_t length, const HeaderCallback& on_header);
+
 private:
     // 私有实现细节将在此添加
 };
 
+/**
+ * @class IndexingPolicy
+ * @brief 基于统计的自适应索引策略
+ *
+ * 对每个待编码字段决定使用哪种表示：
+ * - 名称在窗口内几乎从不重复取值（请求 ID、时间戳等）时不索引，
+ *   避免一次性的值挤占动态表；
+ * - 动态表淘汰频繁（churn 高）时，只有在窗口内出现过的名值对才索引；
+ * - 低熵的敏感字段（短的 authorization、cookie crumb）使用 never-indexed；
+ *   可选地让所有凭据都使用 never-indexed（见 setNeverIndexCredentials）；
+ * - 命中的动态表条目即将被淘汰且仍然常用时，重新插入一份新副本
+ *   而不是继续引用旧条目。
+ */
+class IndexingPolicy {
+public:
+    /**
+     * @brief 字段表示方式
+     */
+    enum class Decision {
+        INDEXED,           // 引用已有的表条目
+        INCREMENTAL,       // 字面量并加入动态表
+        WITHOUT_INDEXING,  // 字面量，不加入动态表
+        NEVER_INDEXED      // 字面量，中间节点也不得索引
+    };
+
+    /**
+     * @brief 构造函数
+     *
+     * @param window 统计窗口（字段数），窗口过后统计计数减半
+     */
+    explicit IndexingPolicy(size_t window = 256);
+
+    /**
+     * @brief 为一个字段做出编码决策并更新统计
+     *
+     * @param name 头字段名称
+     * @param value 头字段值
+     * @param index 该名值对在头表中的统一索引，-1 表示不存在
+     * @param table 编码器头表
+     * @return 编码决策
+     */
+    Decision decide(const std::string& name, const std::string& value,
+                    int index, const HeaderTable& table);
+
+    /**
+     * @brief 设置凭据（authorization、proxy-authorization）是否总是 never-indexed
+     *
+     * 默认关闭：只有短于低熵阈值的凭据不索引，长令牌难以逐字节猜测，
+     * 按普通字段索引以便复用（RFC 7541 7.1.3）。经过不受信任的中间节点
+     * 或同一连接上混有不同用户的请求时应开启。
+     */
+    void setNeverIndexCredentials(bool enabled);
+
+    /**
+     * @brief 记录一次插入造成的淘汰字节数（用于计算 churn）
+     */
+    void recordInsertion(size_t evicted_bytes);
+
+    /**
+     * @brief 当前窗口内是否处于高淘汰状态
+     * @param table_max_size 动态表最大大小
+     */
+    bool highChurn(size_t table_max_size) const;
+
+    /**
+     * @brief 清空统计（保留哈希表已分配的桶）
+     */
+    void reset();
+
+private:
+    struct NameStats {
+        uint32_t occurrences;  // 窗口内出现次数
+        uint32_t repeats;      // 其中值在窗口内出现过的次数
+    };
+
+    size_t window_;
+    uint64_t tick_;
+    size_t window_evicted_bytes_;
+    bool never_index_credentials_;
+    std::unordered_map<std::string, NameStats> names_;
+    std::unordered_map<size_t, uint64_t> recent_fields_;  // 名值对哈希 -> 最近出现的 tick
+
+    void decay();
+};
+
+/**
+ * @class HpackMemoryGovernor
+ * @brief 进程级 HPACK 动态表内存预算
+ *
+ * 编码器和解码器通过 setMemoryGovernor 注册。治理器按预算和注册数量计算
+ * 每个动态表允许的大小（按 256 字节取整，避免连接抖动频繁改变上限）：
+ * - 编码器在下一个头块开始时缩小动态表，并发送动态表大小更新；
+ * - 解码器通过 advertisedTableSize() 提供较小的 SETTINGS_HEADER_TABLE_SIZE，
+ *   由连接通告给对端，对端随后以大小更新缩小表。
+ *
+ * 编码器/解码器在各自线程中轮询上限并上报用量，治理器本身只使用原子变量，
+ * 可被任意线程注册和读取。
+ */
+class HpackMemoryGovernor {
+public:
+    /**
+     * @brief 用量指标
+     */
+    struct Metrics {
+        size_t budget;            // 预算（字节）
+        size_t table_size_limit;  // 当前每个动态表的上限（字节）
+        size_t encoders;          // 已注册的编码器数
+        size_t decoders;          // 已注册的解码器数
+        size_t table_bytes;       // 所有动态表的当前大小之和（RFC 7541 4.1 计算方式）
+        uint64_t limit_changes;   // 上限变化次数
+    };
+
+    /**
+     * @brief 编码器/解码器与治理器的注册关系
+     *
+     * 析构时自动注销并撤回已上报的用量；复制得到的对象不继承注册，
+     * 移动时注册随之转移。
+     */
+    class Link {
+    public:
+        Link() = default;
+        Link(const Link&) {}
+        Link& operator=(const Link&) { return *this; }
+        Link(Link&& other) noexcept;
+        Link& operator=(Link&& other) noexcept;
+        ~Link();
+
+        void attach(HpackMemoryGovernor* governor, bool encoder);
+        void reset();
+
+        /**
+         * @brief 上报当前动态表大小
+         * @return 当前每个动态表的上限；未注册时返回 SIZE_MAX
+         */
+        size_t sync(size_t table_bytes);
+
+        HpackMemoryGovernor* governor() const { return governor_; }
+
+    private:
+        HpackMemoryGovernor* governor_ = nullptr;
+        bool encoder_ = false;
+        size_t reported_bytes_ = 0;
+    };
+
+    /**
+     * @brief 构造函数
+     *
+     * @param budget 所有动态表的总预算（字节），默认不限制
+     * @param max_table_size 单个动态表的上限（字节），默认 4096
+     */
+    explicit HpackMemoryGovernor(size_t budget = std::numeric_limits<size_t>::max(),
+                                 size_t max_table_size = 4096);
+
+    /**
+     * @brief 进程级实例（默认不限制）
+     */
+    static HpackMemoryGovernor& global();
+
+    /**
+     * @brief 修改预算并重新计算每个动态表的上限
+     */
+    void setBudget(size_t budget);
+
+    /**
+     * @brief 当前每个动态表的上限（字节）
+     */
+    size_t tableSizeLimit() const;
+
+    Metrics metrics() const;
+
+private:
+    std::atomic<size_t> budget_;
+    size_t max_table_size_;
+    std::atomic<size_t> limit_;
+    std::atomic<size_t> encoders_;
+    std::atomic<size_t> decoders_;
+    std::atomic<size_t> table_bytes_;
+    std::atomic<uint64_t> limit_changes_;
+
+    void rebalance();
+};
+
+/**
+ * @class HpackEncoder
+ * @brief 有状态的 HPACK 编码器（每个连接一个实例）
+ *
+ * 与 HPACK::encode 不同，编码器维护自己的动态表：完全匹配的头字段
+ * 编码为索引，其余字段使用增量索引字面量并加入动态表。
+ * 对端的 HpackDecoder 按相同顺序解码即可保持两端表状态一致。
+ */
+class HpackEncoder {
+public:
+    /**
+     * @brief 编码模式
+     *
+     * STATEFUL：使用并维护动态表（默认）。
+     * STATELESS：只使用静态表索引和不索引字面量，输出与任何一端的
+     * 动态表状态无关，可在多个连接间共享同一份编码结果。
+     */
+    enum class Mode {
+        STATEFUL,
+        STATELESS
+    };
+
+    /**
+     * @brief 构造函数
+     *
+     * @param max_table_size 动态表最大大小（字节），默认 4096
+     * @param mode 编码模式，默认 STATEFUL
+     */
+    explicit HpackEncoder(size_t max_table_size = 4096, Mode mode = Mode::STATEFUL);
+
+    /**
+     * @brief 编码头字段列表
+     * @param headers 头字段名-值对向量（名称应为小写）
+     * @return 编码后的头块
+     */
+    std::vector<uint8_t> encode(const std::vector<std::pair<std::string, std::string>>& headers);
+
+    /**
+     * @brief 编码头字段列表并追加到已有缓冲区
+     * @param headers 头字段名-值对向量
+     * @param out 输出缓冲区
+     */
+    void encode(const std::vector<std::pair<std::string, std::string>>& headers,
+                std::vector<uint8_t>& out);
+
+    /**
+     * @brief 在已经开始的头块中继续编码头字段
+     *
+     * 与 encode() 相同，但不调用 beginBlock()：不应用治理器上限，也不输出
+     * 动态表大小更新（RFC 7541 4.2 只允许在头块开头出现）。用于同一头块的
+     * 后续部分，以及会被缓存重放的片段（RequestTemplate 的固定字段）。
+     */
+    void encodeFields(const std::vector<std::pair<std::string, std::string>>& headers,
+                      std::vector<uint8_t>& out);
+
+    /**
+     * @brief 编码单个头字段并追加到缓冲区（不做 cookie 拆分）
+     */
+    void encodeField(const std::string& name, const std::string& value,
+                     std::vector<uint8_t>& out);
+
+    /**
+     * @brief 编码单个头字段但不修改动态表
+     *
+     * 完全匹配时仍使用索引，否则使用不索引的字面量（0000xxxx）。
+     * 适用于每次请求都不同的字段（如 :path），避免污染动态表。
+     */
+    void encodeFieldWithoutIndexing(const std::string& name, const std::string& value,
+                                    std::vector<uint8_t>& out);
+
+    /**
+     * @brief 启用或禁用 cookie 拆分（RFC 9113 8.2.3），默认启用
+     *
+     * 启用时 cookie 头按 "; " 拆分为多个 crumb 分别编码，
+     * 只有变化的 crumb 需要以字面量发送。
+     */
+    void setCookieCrumbling(bool enabled);
+
+    /**
+     * @brief 获取编码模式
+     */
+    Mode mode() const;
+
+    /**
+     * @brief 启用或禁用自适应索引策略（仅 STATEFUL 模式生效）
+     *
+     * 禁用时（默认）所有未命中的字段都以增量索引方式加入动态表。
+     */
+    void setAdaptiveIndexing(bool enabled);
+
+    /**
+     * @brief 自适应索引时凭据是否总是 never-indexed，默认关闭
+     *
+     * @see IndexingPolicy::setNeverIndexCredentials
+     */
+    void setNeverIndexCredentials(bool enabled);
+
+    /**
+     * @brief 设置动态表大小上限（对端的 SETTINGS_HEADER_TABLE_SIZE）
+     *
+     * 实际使用的大小为该上限与内存治理器上限中的较小者。大小变化在下一次
+     * encode() 输出的头块开头以动态表大小更新（001xxxxx）通知对端。
+     */
+    void setMaxTableSize(size_t size);
+
+    /**
+     * @brief 注册到内存治理器（nullptr 表示注销）
+     */
+    void setMemoryGovernor(HpackMemoryGovernor* governor);
+
+    /**
+     * @brief 开始一个头块：应用治理器上限，并输出待发送的动态表大小更新
+     *
+     * encode() 会自动调用；不经过 encode() 开始头块的调用方（如 RequestTemplate）
+     * 需要先调用它。每个头块只能调用一次，且必须在写入任何字段之前：
+     * 之后的部分用 encodeFields() 编码。
+     */
+    void beginBlock(std::vector<uint8_t>& out);
+
+    /**
+     * @brief 恢复到新连接的初始状态
+     *
+     * 清空动态表和索引统计、恢复构造时的表大小，保留模式和配置；
+     * 已分配的缓冲区不释放，供连接池复用。内存治理器注册保持不变。
+     */
+    void reset();
+
+    /**
+     * @brief 估算对象持有的堆内存（字节）
+     */
+    size_t retainedBytes() const;
+
+    /**
+     * @brief 访问编码器的头表
+     */
+    HeaderTable& table();
+
+private:
+    HeaderTable table_;
+    bool crumble_cookies_;
+    Mode mode_;
+    bool adaptive_indexing_;
+    IndexingPolicy policy_;
+
+    size_t initial_table_size_;       // 构造时的表大小
+    size_t max_table_size_;           // 对端允许的上限
+    size_t min_pending_size_;         // 上次通知以来使用过的最小大小
+    bool size_update_pending_;
+    HpackMemoryGovernor::Link governor_link_;
+
+    void applyTableSize(size_t size);
+
+    void encodeStatelessField(const std::string& name, const std::string& value,
+                              std::vector<uint8_t>& out);
+
+    void encodeCookie(const std::string& value, std::vector<uint8_t>& out);
+};
+
+/**
+ * @class SharedHeaderBlock
+ * @brief 可被多个连接只读共享的无状态头块
+ *
+ * 广播相同头部到大量连接时，只需编码一次：块内只包含静态表引用和
+ * 不索引字面量，对任何连接的动态表都有效，且不会改变其状态。
+ */
+class SharedHeaderBlock {
+public:
+    /**
+     * @brief 共享编码与逐连接有状态编码的开销对比
+     */
+    struct Comparison {
+        size_t stateless_bytes;  // 每次发送共享块的总字节数
+        size_t stateful_bytes;   // 单个连接有状态编码的总字节数
+
+        /**
+         * @brief 共享编码相对有状态编码的字节比例（>= 1 表示共享更大）
+         */
+        double ratio() const;
+    };
+
+    /**
+     * @brief 以无状态模式编码头列表
+     * @param headers 头字段名-值对向量
+     * @return 共享头块
+     */
+    static SharedHeaderBlock encode(const std::vector<std::pair<std::string, std::string>>& headers);
+
+    /**
+     * @brief 对比同一连接上依次发送一组头列表时，两种编码方式的总字节数
+     *
+     * @param sequence 依次发送的头列表
+     * @param table_size 有状态编码使用的动态表大小
+     * @return 对比结果
+     */
+    static Comparison compare(
+        const std::vector<std::vector<std::pair<std::string, std::string>>>& sequence,
+        size_t table_size = 4096);
+
+    const uint8_t* data() const;
+    size_t size() const;
+
+    /**
+     * @brief 获取共享的编码字节（可在线程间安全传递）
+     */
+    std::shared_ptr<const std::vector<uint8_t>> bytes() const;
+
+    /**
+     * @brief 追加到某个连接的输出缓冲区
+     */
+    void appendTo(std::vector<uint8_t>& out) const;
+
+private:
+    explicit SharedHeaderBlock(std::shared_ptr<const std::vector<uint8_t>> bytes);
+
+    std::shared_ptr<const std::vector<uint8_t>> bytes_;
+};
+
+/**
+ * @class HpackDecoder
+ * @brief 有状态的 HPACK 解码器（每个连接一个实例）
+ *
+ * 持有独立的动态表，多个连接可以各自解码而互不干扰。
+ * HPACK::decode 内部使用一个线程局部的实例。
+ *
+ * 解码分两步：先预扫描头块，只记录各表示和字符串的位置；再把所有 Huffman
+ * 字符串交给 StringCoder::decodeHuffmanBatch 交错解码，最后按顺序回放
+ * 表操作和回调。预扫描发现格式异常时退回逐字段解码。
+ */
+class HpackDecoder {
+public:
+    /**
+     * @brief 构造函数
+     *
+     * @param max_table_size 动态表最大大小（字节），默认 4096
+     */
+    explicit HpackDecoder(size_t max_table_size = 4096);
+
+    /**
+     * @brief 解码头块
+     * @param data 编码数据起始地址
+     * @param length 编码数据长度
+     * @return 解码后的头字段名-值对
+     */
+    std::vector<std::pair<std::string, std::string>> decode(const uint8_t* data, size_t length);
+
+    /**
+     * @brief 流式解码头块，每个头字段解出后立即回调
+     */
+    void decode(const uint8_t* data, size_t length, const HPACK::HeaderCallback& on_header);
+
+    /**
+     * @brief 解码头块并追加到使用 PMR 分配器的头列表
+     *
+     * 字符串直接在 out 的内存资源中构造；配合每流 arena 使用时，
+     * 解码不再为每个头字段单独分配堆内存。
+     */
+    void decode(const uint8_t* data, size_t length, PmrHeaderList& out);
+
+    /**
+     * @brief 流式解码头块，以视图形式回调，不为回调构造字符串
+     *
+     * 视图指向头块、动态表或内部解码缓冲区，只在回调期间有效。
+     * 头块格式错误或引用了不存在的索引时仍尽量解码其余字段，但返回 false，
+     * 调用方应将其视为 COMPRESSION_ERROR。
+     *
+     * @return 头块是否完整有效
+     */
+    bool decodeViews(const uint8_t* data, size_t length, const HPACK::HeaderViewCallback& on_header);
+
+    /**
+     * @brief 访问解码器的头表
+     */
+    HeaderTable& table();
+
+    /**
+     * @brief 注册到内存治理器（nullptr 表示注销）
+     */
+    void setMemoryGovernor(HpackMemoryGovernor* governor);
+
+    /**
+     * @brief 应通告给对端的 SETTINGS_HEADER_TABLE_SIZE
+     *
+     * 为构造时的大小与内存治理器上限中的较小者。
+     */
+    size_t advertisedTableSize();
+
+    /**
+     * @brief 恢复到新连接的初始状态
+     *
+     * 清空动态表并恢复构造时的表大小；预扫描和批量解码缓冲区不释放。
+     * 内存治理器注册保持不变。
+     */
+    void reset();
+
+    /**
+     * @brief 估算对象持有的堆内存（字节）
+     */
+    size_t retainedBytes() const;
+
+private:
+    /**
+     * @brief 预扫描记录的字符串位置（相对头块起始）
+     */
+    struct StringRef {
+        size_t offset;
+        size_t length;
+        bool huffman;
+        size_t slot;  // Huffman 字符串在批量解码结果中的位置
+    };
+
+    /**
+     * @brief 预扫描记录的头字段表示
+     */
+    struct FieldRef {
+        enum Kind : uint8_t { INDEXED, INCREMENTAL, LITERAL, SIZE_UPDATE };
+        Kind kind;
+        uint64_t index;  // 索引 / 名称索引 / 新的表大小
+        StringRef name;
+        StringRef value;
+    };
+
+    HeaderTable table_;
+    size_t max_table_size_;
+    HpackMemoryGovernor::Link governor_link_;
+    // 预扫描与批量解码的缓冲区，跨头块复用
+    std::vector<FieldRef> fields_;
+    std::vector<StringCoder::HuffmanSpan> spans_;
+    std::vector<std::string> decoded_;
+
+    bool prescan(const uint8_t* data, size_t length);
+    bool decodeBlock(const uint8_t* data, size_t length, const HPACK::HeaderViewCallback& on_header);
+    void decodeSequential(const uint8_t* data, size_t length, const HPACK::HeaderCallback& on_header);
+};
+
+/**
+ * @class RequestTemplate
+ * @brief 请求头模板：缓存固定头字段的编码结果
+ *
+ * 同一连接上的请求通常只有 :path 等少数字段不同。模板保存固定字段
+ * （:method、:scheme、:authority 等）编码后的字节，并以编码器头表的
+ * 状态版本号作为缓存键：表未变化时直接复制缓存字节，只对变化字段编码。
+ */
+class RequestTemplate {
+public:
+    /**
+     * @brief 构造函数
+     *
+     * @param fixed_headers 每次请求都相同的头字段，按发送顺序排列
+     */
+    explicit RequestTemplate(std::vector<std::pair<std::string, std::string>> fixed_headers);
+
+    /**
+     * @brief 编码一个请求的头块
+     *
+     * 先输出固定字段（命中缓存时不做任何编码），再以不索引方式输出变化字段，
+     * 这样变化字段不会改变头表状态，下一次请求仍可命中缓存。
+     *
+     * @param encoder 连接的编码器
+     * @param varying_headers 本次请求特有的字段（如 {":path", "/"}）
+     * @param out 输出缓冲区（追加写入）
+     */
+    void encode(HpackEncoder& encoder,
+                const std::vector<std::pair<std::string, std::string>>& varying_headers,
+                std::vector<uint8_t>& out);
+
+    /**
+     * @brief 获取固定字段列表
+     */
+    const std::vector<std::pair<std::string, std::string>>& fixedHeaders() const;
+
+    /**
+     * @brief 缓存命中次数
+     */
+    size_t hits() const;
+
+    /**
+     * @brief 缓存未命中（重新编码）次数
+     */
+    size_t misses() const;
+
+private:
+    std::vector<std::pair<std::string, std::string>> fixed_headers_;
+    std::vector<uint8_t> cached_prefix_;  // 固定字段的编码结果
+    uint64_t cached_version_;             // 缓存对应的头表版本号
+    bool cache_valid_;
+    size_t hits_;
+    size_t misses_;
+};
+
+/**
+ * @class HpackTranscoder
+ * @brief 在两个连接之间转发头块，尽量不做完整的解码/重编码
+ *
+ * 代理场景下，入站头块按入站连接的解码器状态遍历，出站头块按出站连接的
+ * 编码器状态生成：
+ * - 索引字段和增量索引字面量需要字符串来维护两端的表，按名值重新编码
+ *   （入站索引被翻译为出站表中的索引）；
+ * - 不索引 / 永不索引字面量的值（以及新名称）按原始字节直接转发，
+ *   已经 Huffman 编码的数据不需要解码再编码；名称索引被翻译为出站索引；
+ * - 永不索引字段在出站时仍保持永不索引（RFC 7541 6.2.3）。
+ */
+class HpackTranscoder {
+public:
+    /**
+     * @brief 转码统计
+     */
+    struct Stats {
+        size_t fields;              // 转发的头字段数
+        size_t passthrough_fields;  // 值按原始字节转发的字段数
+        size_t passthrough_bytes;   // 未经解码直接转发的字符串字节数
+    };
+
+    /**
+     * @brief 转码一个头块
+     *
+     * out 中写入的是一个新的出站头块：开头先由 encoder.beginBlock() 输出待发送的
+     * 动态表大小更新（对端 SETTINGS 或内存治理器引起的变化）。
+     *
+     * @param decoder 入站连接的解码器（其动态表会被更新）
+     * @param encoder 出站连接的编码器（其动态表会被更新）
+     * @param data 入站头块
+     * @param length 入站头块长度
+     * @param out 出站头块（追加写入）
+     * @return 转码统计
+     * @throws std::out_of_range 如果入站头块被截断或引用了不存在的索引
+     * @throws std::runtime_error 如果入站头块包含无效的表示
+     */
+    static Stats transcode(HpackDecoder& decoder, HpackEncoder& encoder,
+                           const uint8_t* data, size_t length, std::vector<uint8_t>& out);
+};
+
+/**
+ * @class HpackPool
+ * @brief 编码器/解码器对象池（每线程空闲列表）
+ *
+ * 连接风暴时反复构造和销毁编解码器会给分配器带来大量压力。acquire() 优先
+ * 复用当前线程空闲列表中的对象；句柄释放时对象被 reset()、从内存治理器注销后
+ * 放回当前线程的空闲列表，保留已分配的缓冲区。空闲列表按 retainedBytes()
+ * 统计内存，超过上限的对象直接销毁。
+ *
+ * @tparam Codec HpackEncoder 或 HpackDecoder
+ */
+template <typename Codec>
+class HpackPool {
+public:
+    /**
+     * @brief 每线程统计
+     */
+    struct Stats {
+        size_t pooled = 0;        // 空闲对象数
+        size_t pooled_bytes = 0;  // 空闲对象持有的内存
+        uint64_t reused = 0;      // 复用空闲对象的次数
+        uint64_t created = 0;     // 新建对象的次数
+        uint64_t dropped = 0;     // 因超过上限而销毁的次数
+    };
+
+    struct Release {
+        void operator()(Codec* codec) const { HpackPool::release(codec); }
+    };
+
+    using Handle = std::unique_ptr<Codec, Release>;
+
+    /**
+     * @brief 获取一个处于初始状态的编解码器
+     */
+    static Handle acquire() {
+        FreeList& list = freeList();
+        if (list.codecs.empty()) {
+            ++list.stats.created;
+            return Handle(new Codec());
+        }
+        Codec* codec = list.codecs.back().release();
+        list.codecs.pop_back();
+        list.stats.pooled_bytes -= std::min(list.stats.pooled_bytes, codec->retainedBytes());
+        list.stats.pooled = list.codecs.size();
+        ++list.stats.reused;
+        return Handle(codec);
+    }
+
+    /**
+     * @brief 设置当前线程空闲列表的内存上限（默认 1 MiB）
+     */
+    static void setMaxPooledBytes(size_t bytes) {
+        FreeList& list = freeList();
+        list.max_bytes = bytes;
+        while (list.stats.pooled_bytes > list.max_bytes && !list.codecs.empty()) {
+            list.stats.pooled_bytes -= std::min(list.stats.pooled_bytes,
+                                                list.codecs.back()->retainedBytes());
+            list.codecs.pop_back();
+            ++list.stats.dropped;
+        }
+        list.stats.pooled = list.codecs.size();
+    }
+
+    /**
+     * @brief 当前线程的统计
+     */
+    static Stats stats() { return freeList().stats; }
+
+    /**
+     * @brief 释放当前线程的所有空闲对象
+     */
+    static void clear() {
+        FreeList& list = freeList();
+        list.codecs.clear();
+        list.stats.pooled = 0;
+        list.stats.pooled_bytes = 0;
+    }
+
+private:
+    struct FreeList {
+        std::vector<std::unique_ptr<Codec>> codecs;
+        size_t max_bytes = 1 << 20;
+        Stats stats;
+    };
+
+    static FreeList& freeList() {
+        static thread_local FreeList list;
+        return list;
+    }
+
+    static void release(Codec* codec) {
+        std::unique_ptr<Codec> owned(codec);
+        owned->setMemoryGovernor(nullptr);
+        owned->reset();
+
+        FreeList& list = freeList();
+        size_t bytes = owned->retainedBytes();
+        if (list.stats.pooled_bytes + bytes > list.max_bytes) {
+            ++list.stats.dropped;
+            return;
+        }
+        list.stats.pooled_bytes += bytes;
+        list.codecs.push_back(std::move(owned));
+        list.stats.pooled = list.codecs.size();
+    }
+};
+
+using HpackEncoderPool = HpackPool<HpackEncoder>;
+using HpackDecoderPool = HpackPool<HpackDecoder>;
+
 } // namespace http2
 
 #endif // HTTP2_HPACK_H
@@ -0,0 +1,201 @@
+#ifndef HTTP2_HPACK_CONST_H
+#define HTTP2_HPACK_CONST_H
+
+#include "hpack_tables.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+namespace http2 {
+
+/**
+ * @struct ConstHeader
+ * @brief 编译期常量头字段（名称必须为小写）
+ */
+struct ConstHeader {
+    std::string_view name;
+    std::string_view value;
+};
+
+namespace const_hpack {
+
+/**
+ * @brief 只统计长度的输出器，用于计算编码后的字节数
+ */
+struct SizeCounter {
+    size_t pos = 0;
+    constexpr void put(uint8_t) { ++pos; }
+};
+
+/**
+ * @brief 写入 std::array 的输出器
+ */
+template <size_t N>
+struct ArrayWriter {
+    std::array<uint8_t, N> data{};
+    size_t pos = 0;
+    constexpr void put(uint8_t byte) {
+        if (pos >= N) {
+            throw std::length_error("constant header block size mismatch");
+        }
+        data[pos++] = byte;
+    }
+};
+
+constexpr int findStaticExact(std::string_view name, std::string_view value) {
+    for (size_t i = 0; i < hpack_tables::STATIC_TABLE_SIZE; ++i) {
+        if (hpack_tables::STATIC_TABLE[i].name == name &&
+            hpack_tables::STATIC_TABLE[i].value == value) {
+            return static_cast<int>(i + 1);
+        }
+    }
+    return -1;
+}
+
+constexpr int findStaticName(std::string_view name) {
+    for (size_t i = 0; i < hpack_tables::STATIC_TABLE_SIZE; ++i) {
+        if (hpack_tables::STATIC_TABLE[i].name == name) {
+            return static_cast<int>(i + 1);
+        }
+    }
+    return -1;
+}
+
+constexpr size_t huffmanLength(std::string_view str) {
+    uint64_t bits = 0;
+    for (char c : str) {
+        bits += hpack_tables::HUFFMAN_CODE_TABLE[static_cast<uint8_t>(c)].bits;
+    }
+    return static_cast<size_t>((bits + 7) / 8);
+}
+
+template <typename Writer>
+constexpr void putInteger(Writer& out, uint64_t value, int prefix_bits, uint8_t flags) {
+    uint64_t max_prefix = (1ULL << prefix_bits) - 1;
+    if (value < max_prefix) {
+        out.put(static_cast<uint8_t>(flags | value));
+        return;
+    }
+    out.put(static_cast<uint8_t>(flags | max_prefix));
+    value -= max_prefix;
+    while (value >= 128) {
+        out.put(static_cast<uint8_t>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.put(static_cast<uint8_t>(value));
+}
+
+// 字符串表示：Huffman 编码更短时设置 H 标志，否则使用原始字节
+template <typename Writer>
+constexpr void putString(Writer& out, std::string_view str) {
+    size_t huffman_length = huffmanLength(str);
+    if (huffman_length >= str.size()) {
+        putInteger(out, str.size(), 7, 0x00);
+        for (char c : str) {
+            out.put(static_cast<uint8_t>(c));
+        }
+        return;
+    }
+
+    putInteger(out, huffman_length, 7, 0x80);
+    uint64_t acc = 0;
+    int acc_bits = 0;
+    for (char c : str) {
+        const auto& code = hpack_tables::HUFFMAN_CODE_TABLE[static_cast<uint8_t>(c)];
+        acc = (acc << code.bits) | code.code;
+        acc_bits += code.bits;
+        while (acc_bits >= 8) {
+            acc_bits -= 8;
+            out.put(static_cast<uint8_t>(acc >> acc_bits));
+        }
+        acc &= (1ULL << acc_bits) - 1;
+    }
+    if (acc_bits > 0) {
+        // 用 EOS 的高位（全 1）填充最后一个字节
+        out.put(static_cast<uint8_t>((acc << (8 - acc_bits)) | (0xFF >> acc_bits)));
+    }
+}
+
+/**
+ * @brief 编码常量头列表
+ *
+ * 只使用静态表引用和不索引字面量，结果与任何动态表状态无关，
+ * 可以直接拼接到任意连接的头块中。
+ */
+template <typename Writer, size_t Count>
+constexpr void encodeHeaders(Writer& out, const ConstHeader (&headers)[Count]) {
+    for (const auto& header : headers) {
+        for (char c : header.name) {
+            if (c >= 'A' && c <= 'Z') {
+                throw std::invalid_argument("constant header names must be lowercase");
+            }
+        }
+
+        int index = findStaticExact(header.name, header.value);
+        if (index > 0) {
+            // Indexed Header Field (1xxxxxxx)
+            putInteger(out, static_cast<uint64_t>(index), 7, 0x80);
+            continue;
+        }
+
+        // Literal Header Field without Indexing (0000xxxx)
+        int name_index = findStaticName(header.name);
+        if (name_index > 0) {
+            putInteger(out, static_cast<uint64_t>(name_index), 4, 0x00);
+        } else {
+            out.put(0x00);
+            putString(out, header.name);
+        }
+        putString(out, header.value);
+    }
+}
+
+} // namespace const_hpack
+
+/**
+ * @brief 计算常量头列表编码后的字节数
+ */
+template <size_t Count>
+constexpr size_t constEncodedSize(const ConstHeader (&headers)[Count]) {
+    const_hpack::SizeCounter counter;
+    const_hpack::encodeHeaders(counter, headers);
+    return counter.pos;
+}
+
+/**
+ * @brief 在编译期把常量头列表编码为 HPACK 字节序列
+ *
+ * 用法：
+ * @code
+ *   inline constexpr ConstHeader GRPC_HEADERS[] = {
+ *       {"content-type", "application/grpc"},
+ *       {"te", "trailers"},
+ *   };
+ *   inline constexpr auto GRPC_BLOCK = HTTP2_CONST_HEADER_BLOCK(GRPC_HEADERS);
+ * @endcode
+ *
+ * @tparam Size 编码后的字节数，必须等于 constEncodedSize(headers)
+ * @param headers 常量头列表（需具有静态存储期）
+ * @return 编码结果
+ */
+template <size_t Size, size_t Count>
+constexpr std::array<uint8_t, Size> constEncode(const ConstHeader (&headers)[Count]) {
+    const_hpack::ArrayWriter<Size> writer;
+    const_hpack::encodeHeaders(writer, headers);
+    if (writer.pos != Size) {
+        throw std::length_error("constant header block size mismatch");
+    }
+    return writer.data;
+}
+
+} // namespace http2
+
+/**
+ * @brief 由常量头数组生成编译期 HPACK 头块（std::array<uint8_t, N>）
+ */
+#define HTTP2_CONST_HEADER_BLOCK(headers) \
+    ::http2::constEncode<::http2::constEncodedSize(headers)>(headers)
+
+#endif // HTTP2_HPACK_CONST_H
@@ -2,10 +2,19 @@
 #define HTTP2_CLIENT_H
 
 #include <string>
+#include <chrono>
 #include <vector>
+#include <deque>
 #include <memory>
 #include <cstdint>
+#include <functional>
+#include <unordered_map>
 #include <openssl/ssl.h>
+#include "hpack.h"
+#include "frame.h"
+#include "event_loop.h"
+#include "stream_arena.h"
+#include "task.h"
 
 namespace http2 {
 
@@ -14,16 +23,142 @@ namespace http2 {
  * @brief HTTP/2 客户端实现，支持TLS连接和HTTP/2通信
  * 
  * 使用Linux socket API和OpenSSL库实现安全的HTTP/2连接。
+ *
+ * socket 和 SSL 对象都是非阻塞的，由 EventLoop（epoll）驱动：TLS 握手、
+ * 读写中的 WANT_READ/WANT_WRITE 都转换为事件关注的变化。多个客户端可以
+ * 共享同一个 EventLoop，在一个线程上运行成千上万个连接（connectAsync、
+ * submitAsync）；connect()、get()、head() 是运行事件循环直到结果就绪的
+ * 同步封装，受 setTimeout() 限制。
+ * 同步封装可以在完成回调（ResponseCallback）和共享同一事件循环的其他
+ * 连接的回调中调用（嵌套运行事件循环）；本连接正在分发帧时（连接回调、
+ * StreamHandler 回调）调用会被拒绝并返回失败。
+ *
+ * 发出的帧先进入连接的写队列，在事件循环本轮结束时（或调用 flush() 时）
+ * 一次交给 SSL_write：同一轮中产生的 SETTINGS ACK、PING ACK 和多个请求的
+ * HEADERS 合并为尽量满的 TLS 记录，通常只需一次写系统调用。
+ *
+ * 接收方向实现完整的流量控制：流级窗口通过 SETTINGS_INITIAL_WINDOW_SIZE
+ * 通告，连接级窗口在连接建立时用 WINDOW_UPDATE 扩大；数据交付后累计的
+ * 字节数超过窗口的一半时归还额度。发送方向跟踪对端的连接级和流级窗口。
+ * 窗口默认自动调整：DATA 持续到达时用 PING 测量往返时间和期间收到的字节数
+ * （带宽时延积），窗口接近被填满时扩大到估计值的两倍，明显偏大时逐步缩回
+ * setReceiveWindow() 设置的基准值。
+ *
+ * 事件循环使用 IO_URING 后端时，握手开始后 socket 的读写改走 io_uring：
+ * TLS 经一对内存 BIO 加解密，密文由 multishot recv 接收到环的缓冲区，
+ * 并从注册的发送槽以链接写（一条写链一次提交）发出。
  */
 class Http2Client {
 public:
     /**
      * @brief HTTP/2响应结构
+     *
+     * 头字段和尾部字段从响应自带的流 arena 分配，响应销毁时一次性释放；
+     * 响应体大小事先未知且可能很大，使用普通堆分配，扩容时旧缓冲区立即释放。
+     * arena 必须最先声明（最后销毁）；响应只能移动，不能复制。
      */
     struct Response {
-        int status_code;
-        std::vector<std::pair<std::string, std::string>> headers;
+        std::unique_ptr<StreamArena> arena;
+        int status_code = 0;
+        uint32_t error_code = 0;  // 流被 RST_STREAM/GOAWAY 终止时的错误码，正常结束为 0
+        PmrHeaderList headers;
         std::vector<uint8_t> body;
+        PmrHeaderList trailers;  // 响应体之后的尾部字段
+
+        Response()
+            : arena(std::make_unique<StreamArena>()),
+              headers(arena->resource()),
+              trailers(arena->resource()) {}
+
+        // 移动构造保留分配器，容器继续使用随之转移的 arena
+        Response(Response&&) = default;
+
+        Response& operator=(Response&& other) noexcept {
+            if (this != &other) {
+                status_code = other.status_code;
+                error_code = other.error_code;
+                body = std::move(other.body);
+                adopt(headers, other.headers);
+                adopt(trailers, other.trailers);
+                // 旧 arena 已不再被任何容器引用，最后释放
+                arena = std::move(other.arena);
+            }
+            return *this;
+        }
+
+    private:
+        // pmr 容器的移动赋值不传播分配器（分配器不同时逐个复制到本方的 arena），
+        // 因此以对方的容器移动构造，连同分配器一起接管
+        static void adopt(PmrHeaderList& target, PmrHeaderList& source) noexcept {
+            target.~PmrHeaderList();
+            new (&target) PmrHeaderList(std::move(source));
+        }
+    };
+
+    /**
+     * @brief 接收窗口自动调整的测量结果
+     */
+    struct FlowControlStats {
+        std::chrono::microseconds rtt{0};  // 平滑后的 PING 往返时间
+        uint64_t delivery_rate = 0;        // 最近一次测得的交付速率（字节/秒）
+        uint64_t bdp = 0;                  // 最近一次测得的带宽时延积（字节）
+        uint32_t stream_window = 0;        // 当前的流级接收窗口
+        uint32_t connection_window = 0;    // 当前的连接级接收窗口
+        uint64_t pings = 0;                // 发出的测量 PING 数
+        uint64_t increases = 0;            // 窗口扩大次数
+        uint64_t decreases = 0;            // 窗口缩小次数
+    };
+
+    // 自动调整的默认窗口上限
+    static constexpr uint32_t DEFAULT_MAX_TUNED_WINDOW = 64u << 20;
+
+    // 本端默认通告的 SETTINGS_MAX_FRAME_SIZE
+    static constexpr uint32_t DEFAULT_LOCAL_MAX_FRAME_SIZE = 65536;
+
+    // 本端默认通告的 SETTINGS_MAX_HEADER_LIST_SIZE，同时限制接收头块的大小
+    static constexpr uint32_t DEFAULT_LOCAL_MAX_HEADER_LIST_SIZE = 65536;
+
+    using ResponseCallback = std::function<void(Response&& response)>;
+    using ConnectCallback = std::function<void(bool connected)>;
+
+    /**
+     * @brief 消费驱动的流量控制中归还流级额度的句柄
+     *
+     * 可以复制，也可以在回调之外稍后调用；连接断开或重新连接后调用无效果。
+     */
+    class StreamCredit {
+    public:
+        StreamCredit() : stream_id_(0) {}
+
+        /**
+         * @brief 确认调用方已处理完 length 字节，允许对端继续发送
+         */
+        void consume(size_t length) const;
+
+    private:
+        friend class Http2Client;
+
+        StreamCredit(std::weak_ptr<Http2Client*> connection, uint32_t stream_id)
+            : connection_(std::move(connection)), stream_id_(stream_id) {}
+
+        std::weak_ptr<Http2Client*> connection_;
+        uint32_t stream_id_;
+    };
+
+    /**
+     * @brief 流级事件回调（可选）
+     *
+     * 回调在帧解析过程中同步调用，回调中不能断开连接。
+     */
+    struct StreamHandler {
+        // 最终（非 1xx）响应头到达：status_code 和 headers 已可用
+        std::function<void(const Response& response)> on_headers;
+        // 响应体数据块；设置后数据不在 Response::body 中累积
+        std::function<void(const uint8_t* data, size_t length)> on_data;
+        // 流已打开（请求即将发出）。设置后流进入消费驱动模式：on_data 交付的字节
+        // 只有在调用方通过 credit.consume() 确认后才归还流级额度，流中未处理的
+        // 数据因此不超过 setStreamBufferLimit()；连接级额度照常归还，不影响其他流
+        std::function<void(StreamCredit credit)> on_open;
     };
 
     /**
@@ -31,8 +166,9 @@ public:
      * 
      * @param host 目标主机名或IP地址
      * @param port 目标端口，默认为443（HTTPS）
+     * @param loop 驱动连接的事件循环，nullptr 表示使用客户端私有的循环
      */
-    Http2Client(const std::string& host, uint16_t port = 443);
+    Http2Client(const std::string& host, uint16_t port = 443, EventLoop* loop = nullptr);
 
     /**
      * @brief 析构函数，自动关闭连接
@@ -46,6 +182,16 @@ public:
      */
     bool connect();
 
+    /**
+     * @brief 开始异步连接，立即返回
+     *
+     * TCP 连接、TLS 握手和 HTTP/2 前言都由事件循环推进，
+     * 收到服务器的 SETTINGS 帧或连接失败时调用 on_connected。
+     *
+     * @param on_connected 完成回调
+     */
+    void connectAsync(ConnectCallback on_connected);
+
     /**
      * @brief 关闭连接
      */
@@ -71,6 +217,138 @@ public:
     Response head(const std::string& path,
                   const std::vector<std::pair<std::string, std::string>>& headers = {});
 
+    /**
+     * @brief 在新的流上发送请求，不等待响应
+     *
+     * 流ID按奇数递增分配；活动流数达到对端的 SETTINGS_MAX_CONCURRENT_STREAMS
+     * 时先处理入站帧，直到有流结束。同一连接上可以同时提交多个请求，
+     * 响应按流ID分发，之后用 wait() 取回。
+     *
+     * @param method HTTP方法
+     * @param path 请求路径
+     * @param headers 可选的自定义请求头
+     * @return 流ID，失败时为 0
+     */
+    uint32_t submit(const std::string& method, const std::string& path,
+                    const std::vector<std::pair<std::string, std::string>>& headers = {});
+
+    /**
+     * @brief 处理入站帧直到指定流结束，返回其响应
+     *
+     * 等待期间到达的其他流的帧照常分发到各自的流。
+     *
+     * @param stream_id submit() 返回的流ID
+     * @return Response 响应对象（流被重置时 error_code 非 0）
+     */
+    Response wait(uint32_t stream_id);
+
+    /**
+     * @brief 异步发送请求，流结束时调用 on_response
+     *
+     * 连接尚未就绪或并发流已满时请求排队，按提交顺序发出。连接已断开时
+     * 立即以 error_code = REFUSED_STREAM 回调。回调在事件循环中执行。
+     *
+     * @param method HTTP方法
+     * @param path 请求路径
+     * @param headers 自定义请求头
+     * @param on_response 完成回调
+     * @param handler 可选的流级事件回调
+     */
+    void submitAsync(const std::string& method, const std::string& path,
+                     const std::vector<std::pair<std::string, std::string>>& headers,
+                     ResponseCallback on_response, StreamHandler handler = StreamHandler());
+
+    /**
+     * @brief 设置同步接口（connect、submit、wait）的超时时间
+     *
+     * @param timeout_ms 超时（毫秒），默认 30000
+     */
+    void setTimeout(int timeout_ms);
+
+    /**
+     * @brief 设置接收窗口，在下一次连接时生效
+     *
+     * @param stream_window 每个流的接收窗口（SETTINGS_INITIAL_WINDOW_SIZE），默认 1 MiB
+     * @param connection_window 连接级接收窗口，默认 16 MiB，不小于 65535
+     */
+    void setReceiveWindow(uint32_t stream_window, uint32_t connection_window);
+
+    /**
+     * @brief 设置本端通告的 SETTINGS_MAX_FRAME_SIZE，在下一次连接时生效
+     *
+     * 较大的帧减少每字节的帧头开销；超过该大小的入站帧按 FRAME_SIZE_ERROR 处理。
+     *
+     * @param size 帧负载上限，范围 16384 ~ 16777215，默认 65536
+     */
+    void setMaxFrameSize(uint32_t size);
+
+    /**
+     * @brief 设置本端通告的 SETTINGS_MAX_HEADER_LIST_SIZE，在下一次连接时生效
+     *
+     * 同时作为接收头块（HEADERS 加全部 CONTINUATION）压缩后大小的上限：
+     * 超过时不再缓存后续 CONTINUATION，按 COMPRESSION_ERROR 关闭连接，
+     * 防止对端用无穷的 CONTINUATION 帧耗尽内存。
+     *
+     * @param size 头列表大小上限，默认 65536
+     */
+    void setMaxHeaderListSize(uint32_t size);
+
+    /**
+     * @brief 设置消费驱动模式下每个流未处理数据的上限（默认 1 MiB）
+     *
+     * 上限作为这些流的接收窗口，低于 SETTINGS_INITIAL_WINDOW_SIZE 时
+     * 第一个窗口仍按初始窗口接收，之后不再超过上限。
+     */
+    void setStreamBufferLimit(uint32_t limit);
+
+    /**
+     * @brief 开启或关闭接收窗口的自动调整（默认开启）
+     *
+     * 调整范围是 setReceiveWindow() 设置的基准值到 max_window。
+     *
+     * @param enabled 是否自动调整
+     * @param max_window 流级和连接级窗口的上限
+     */
+    void setWindowAutoTuning(bool enabled, uint32_t max_window = DEFAULT_MAX_TUNED_WINDOW);
+
+    /**
+     * @brief 当前连接的窗口调整测量结果
+     */
+    FlowControlStats flowControlStats() const;
+
+    /**
+     * @brief 由一次测量的带宽时延积计算新的接收窗口
+     *
+     * 一个往返内收到的字节达到窗口的 2/3 时窗口限制了吞吐，扩大到估计值的
+     * 两倍（不超过 max_window）；不到窗口的 1/4 时缩小，每次最多减半，
+     * 不低于 base；其余情况保持不变。
+     *
+     * @param current 当前窗口
+     * @param base setReceiveWindow() 设置的基准值
+     * @param max_window 自动调整的上限
+     * @param bdp 测量 PING 往返期间收到的字节数
+     */
+    static uint32_t tuneWindow(uint32_t current, uint32_t base, uint32_t max_window, uint64_t bdp);
+
+    /**
+     * @brief 立即写出写队列中的帧
+     *
+     * 通常不需要调用：事件循环每轮结束时自动写出。
+     *
+     * @return true 如果成功（可能尚未写完，剩余部分等待可写事件），false 如果出错
+     */
+    bool flush();
+
+    /**
+     * @brief 尚未结束的流数量
+     */
+    size_t activeStreams() const;
+
+    /**
+     * @brief 请求头模板缓存的累计命中次数（所有请求方法之和）
+     */
+    size_t templateHits() const;
+
     /**
      * @brief 检查是否已连接
      * 
@@ -78,44 +356,264 @@ public:
      */
     bool isConnected() const;
 
+#if HTTP2_HAVE_COROUTINES
+    class ResponseReader;
+
+    /**
+     * @brief 协程接口：发送请求，co_await 得到完整响应
+     *
+     * 请求通过 submitAsync 发出，协程在事件循环中恢复：
+     * @code
+     * Http2Client::Response response = co_await client.request("GET", "/");
+     * @endcode
+     */
+    Task<Response> request(std::string method, std::string path,
+                           std::vector<std::pair<std::string, std::string>> headers = {});
+
+    /**
+     * @brief 协程接口：发送请求，逐步读取响应头、响应体数据块和尾部字段
+     *
+     * @code
+     * auto reader = client.stream("GET", "/large");
+     * const auto& head = co_await reader.headers();
+     * while (auto chunk = co_await reader.read()) { ... }
+     * Http2Client::Response tail = co_await reader.finish();  // trailers、error_code
+     * @endcode
+     */
+    ResponseReader stream(std::string method, std::string path,
+                          std::vector<std::pair<std::string, std::string>> headers = {});
+#endif
+
 private:
     std::string host_;
     uint16_t port_;
     int socket_fd_;
     SSL_CTX* ssl_ctx_;
     SSL* ssl_;
+
+    // 驱动连接的事件循环（未指定时使用私有循环）
+    std::unique_ptr<EventLoop> own_loop_;
+    EventLoop* loop_;
+
+    enum class ConnectionState {
+        DISCONNECTED,
+        CONNECTING,          // 非阻塞 connect 进行中
+        HANDSHAKING,         // TLS 握手进行中
+        AWAITING_SETTINGS,   // 已发送前言，等待服务器的 SETTINGS
+        READY
+    };
+    ConnectionState state_;
+    ConnectCallback connect_callback_;
+    int timeout_ms_;
+
+    // 接收环形缓冲区：SSL_read 直接写入，帧以视图的形式就地分发
+    FrameReader reader_;
+
+    // 写队列：帧头和负载直接追加到 send_buffer_，send_offset_ 之前的字节已写出
+    std::vector<uint8_t> send_buffer_;
+    size_t send_offset_;
+    bool want_write_;       // 需要等待可写事件（发送未完成或 SSL 需要写）
+    bool flush_scheduled_;  // 已在事件循环中登记本轮结束时的写出
+    uint64_t flush_task_;   // 登记的延迟任务ID
+    bool parsing_;          // 正在分发接收环中的帧，同步接口不能嵌套运行事件循环
+
+    // io_uring 传输：待发送的一段密文，位于发送槽或（槽用尽时）堆缓冲区中
+    struct RingChunk {
+        int slot;
+        std::shared_ptr<const std::vector<uint8_t>> spill;
+        size_t offset;
+        size_t length;
+        uint64_t op;   // 在途写操作ID，0 表示未提交或已完成
+    };
+    IoUring* ring_;                      // 非空表示本连接的 socket 读写走 io_uring
+    BIO* net_in_;                        // 收到的密文（由 ssl_ 持有）
+    BIO* net_out_;                       // 待发送的密文（由 ssl_ 持有）
+    uint64_t ring_recv_op_;              // multishot recv 的操作ID，0 表示需要重新提交
+    std::deque<RingChunk> ring_chunks_;  // 按发送顺序排列的密文
+    size_t ring_writes_;                 // 当前写链中未完成的操作数
+
+    // 连接级HPACK编码器/解码器（注册到全局内存治理器），以及按方法缓存的请求头模板
+    HpackEncoder encoder_;
+    HpackDecoder decoder_;
+    std::unordered_map<std::string, RequestTemplate> request_templates_;
+
+    // 最近一次通告的 SETTINGS_HEADER_TABLE_SIZE
+    size_t advertised_table_size_;
     
-    // HTTP/2帧类型
-    static constexpr uint8_t FRAME_TYPE_DATA = 0x0;
-    static constexpr uint8_t FRAME_TYPE_HEADERS = 0x1;
-    static constexpr uint8_t FRAME_TYPE_PRIORITY = 0x2;
-    static constexpr uint8_t FRAME_TYPE_RST_STREAM = 0x3;
-    static constexpr uint8_t FRAME_TYPE_SETTINGS = 0x4;
-    static constexpr uint8_t FRAME_TYPE_PUSH_PROMISE = 0x5;
-    static constexpr uint8_t FRAME_TYPE_PING = 0x6;
-    static constexpr uint8_t FRAME_TYPE_GOAWAY = 0x7;
-    static constexpr uint8_t FRAME_TYPE_WINDOW_UPDATE = 0x8;
-    static constexpr uint8_t FRAME_TYPE_CONTINUATION = 0x9;
-
-    // HTTP/2帧头标志
-    static constexpr uint8_t FLAG_END_STREAM = 0x1;
-    static constexpr uint8_t FLAG_END_HEADERS = 0x4;
-    static constexpr uint8_t FLAG_PADDED = 0x8;
-    static constexpr uint8_t FLAG_PRIORITY = 0x20;
-
-    /**
-     * @brief 建立原始socket连接
+    // 对端的 SETTINGS_MAX_FRAME_SIZE（帧类型与标志常量见 frame.h）
+    uint32_t peer_max_frame_size_;
+
+    // 对端的 SETTINGS_MAX_HEADER_LIST_SIZE，未通告时不限制
+    uint32_t peer_max_header_list_size_;
+
+    // 本端通告的 SETTINGS_MAX_FRAME_SIZE
+    uint32_t local_max_frame_size_;
+
+    // 本端通告的 SETTINGS_MAX_HEADER_LIST_SIZE，也是接收头块的大小上限
+    uint32_t local_max_header_list_size_;
+
+    // 接收方向流量控制：窗口是对端还可以发送的字节数，credit 是尚未通过
+    // WINDOW_UPDATE 归还的额度（已交付的字节加上窗口扩大量，缩小时为负）
+    uint32_t stream_window_size_;       // 本端 SETTINGS_INITIAL_WINDOW_SIZE，自动调整的基准
+    uint32_t connection_window_size_;   // 连接级窗口的基准
+    uint32_t stream_window_target_;     // 当前的流级窗口
+    uint32_t connection_window_target_; // 当前的连接级窗口
+    int64_t recv_window_;
+    int64_t recv_credit_;
+
+    // 窗口自动调整：同一时间最多一个测量 PING 在途，bdp_bytes_ 是发出后收到的 DATA 字节
+    bool autotune_;
+    uint32_t autotune_max_window_;
+    bool bdp_ping_pending_;
+    uint64_t bdp_ping_id_;
+    std::chrono::steady_clock::time_point bdp_ping_sent_;
+    uint64_t bdp_bytes_;
+    FlowControlStats flow_stats_;
+
+    // 消费驱动模式下流的接收窗口上限
+    uint32_t stream_buffer_limit_;
+
+    // 当前连接的令牌：StreamCredit 持有其弱引用，断开或重新连接后失效
+    std::shared_ptr<Http2Client*> connection_token_;
+
+    // 发送方向流量控制：对端的连接级窗口与 SETTINGS_INITIAL_WINDOW_SIZE
+    int64_t send_window_;
+    uint32_t peer_initial_window_size_;
+
+    // 流ID是31位整数
+    static constexpr uint32_t MAX_STREAM_ID = 0x7FFFFFFF;
+
+    // 流状态（RFC 9113 5.1）；请求不带请求体，流创建时即为本端半关闭
+    enum class StreamState {
+        HALF_CLOSED_LOCAL,
+        CLOSED
+    };
+
+    struct Stream {
+        StreamState state = StreamState::HALF_CLOSED_LOCAL;
+        Response response;
+        ResponseCallback on_response;  // 异步请求的完成回调，同步请求为空
+        StreamHandler handler;
+        bool headers_complete = false;  // 已收到最终响应头，之后的头块是尾部字段
+        int64_t recv_window = DEFAULT_WINDOW_SIZE;  // 流级接收窗口
+        int64_t recv_credit = 0;
+        uint32_t window_size = DEFAULT_WINDOW_SIZE; // 当前授予的流级窗口大小
+        bool deferred_credit = false;               // 消费驱动模式：由 StreamCredit 归还额度
+        int64_t send_window = DEFAULT_WINDOW_SIZE;  // 对端给本端的流级窗口
+    };
+
+    struct PendingRequest {
+        std::string method;
+        std::string path;
+        std::vector<std::pair<std::string, std::string>> headers;
+        ResponseCallback on_response;
+        StreamHandler handler;
+    };
+
+    // 流表：已提交但尚未被 wait() 或回调取走的流
+    std::unordered_map<uint32_t, Stream> streams_;
+    std::deque<uint32_t> completed_;               // 已结束、等待回调的异步流
+    std::deque<PendingRequest> pending_requests_;  // 等待连接就绪或空闲流的异步请求
+    uint32_t next_stream_id_;
+    size_t active_streams_;
+    uint32_t peer_max_concurrent_streams_;
+
+    // 正在拼接的头块（HEADERS + CONTINUATION 必须连续，因此按连接保存）
+    std::vector<uint8_t> header_block_;
+    uint32_t header_block_stream_;   // 0 表示没有未结束的头块
+    bool header_block_end_stream_;   // HEADERS帧上的END_STREAM，在头块结束后生效
+
+    bool goaway_received_;
+
+    /**
+     * @brief 创建非阻塞socket并发起连接
      * 
-     * @return true 如果成功，false 如果失败
+     * @return true 如果成功（连接可能仍在进行），false 如果失败
      */
     bool createSocket();
 
     /**
-     * @brief 执行TLS握手
+     * @brief 创建SSL对象，进入握手状态
      * 
      * @return true 如果成功，false 如果失败
      */
-    bool performTlsHandshake();
+    bool startTls();
+
+    /**
+     * @brief 推进TLS握手；完成后发送前言和SETTINGS
+     *
+     * @return true 如果握手完成或仍在进行，false 如果失败
+     */
+    bool continueHandshake();
+
+    /**
+     * @brief socket 事件回调：按连接状态推进握手或读写
+     */
+    void onSocketEvent(uint32_t events);
+
+    /**
+     * @brief 根据连接状态和待发送数据更新 epoll 关注的事件
+     */
+    void updateInterest();
+
+    /**
+     * @brief 读取可读数据并分发完整的帧
+     *
+     * 每次 SSL_read 填满接收环的剩余空间。epoll 模式下 OpenSSL 以预读方式
+     * 一次读取多个 TLS 记录，其缓冲区取空后即返回，不再用一次返回 EAGAIN 的
+     * read 确认 socket 已空（水平触发会再次报告可读）。
+     *
+     * @return true 如果连接仍可用，false 如果连接关闭或出错
+     */
+    bool readAvailable();
+
+    /**
+     * @brief 从接收环中分发所有完整的帧，不完整的尾部留在环中
+     */
+    bool parseFrames();
+
+    /**
+     * @brief 登记在事件循环本轮结束时写出写队列（每轮最多一次）
+     */
+    void scheduleFlush();
+
+    /**
+     * @brief 尽可能写出写队列，剩余部分等待可写事件
+     *
+     * @return true 如果成功（可能尚未写完），false 如果出错
+     */
+    bool flushOutput();
+
+    /**
+     * @brief 提交 multishot recv，接收的密文写入 net_in_
+     */
+    void armRingReceive();
+
+    /**
+     * @brief io_uring 接收完成：推进握手或读取帧
+     */
+    void onRingReceive(int32_t result, uint32_t flags);
+
+    /**
+     * @brief 把 net_out_ 中的密文装入发送槽，作为一条链接写提交
+     *
+     * 同一时间只有一条写链在途；短写或被取消的部分在写链结束后重发。
+     *
+     * @return true 如果成功，false 如果出错
+     */
+    bool flushCiphertext();
+
+    /**
+     * @brief io_uring 写完成
+     *
+     * @param index 写链中的位置（ring_chunks_ 的下标）
+     */
+    void onRingWrite(size_t index, int32_t result);
+
+    /**
+     * @brief 取消本连接在环上的所有操作，归还发送槽
+     */
+    void stopRingTransport();
 
     /**
      * @brief 发送HTTP/2连接前言（PRI * HTTP/2.0）
@@ -126,37 +624,92 @@ private:
 
     /**
      * @brief 发送SETTINGS帧
+     *
+     * 总是通告 SETTINGS_ENABLE_PUSH = 0（客户端不接受服务器推送）；解码器的通告
+     * 表大小、接收窗口和最大帧大小不是默认值时分别携带对应参数。
      * 
      * @return true 如果成功，false 如果失败
      */
     bool sendSettings();
 
     /**
-     * @brief 发送HTTP/2帧
+     * @brief 把一个HTTP/2帧加入写队列
+     *
+     * 帧头直接写入写队列，负载复制一次到帧头之后；本轮结束时统一写出。
      * 
      * @param type 帧类型
      * @param flags 帧标志
      * @param stream_id 流ID
-     * @param payload 帧负载
-     * @return true 如果成功，false 如果失败
+     * @param payload 帧负载（调用返回后不再被引用）
+     * @param length 负载长度
+     * @return true 如果成功，false 如果连接不可用
      */
-    bool sendFrame(uint8_t type, uint8_t flags, uint32_t stream_id, 
-                   const std::vector<uint8_t>& payload);
+    bool sendFrame(uint8_t type, uint8_t flags, uint32_t stream_id,
+                   const uint8_t* payload = nullptr, size_t length = 0);
 
     /**
-     * @brief 接收HTTP/2帧
-     * 
-     * @param type 输出参数：帧类型
-     * @param flags 输出参数：帧标志
-     * @param stream_id 输出参数：流ID
-     * @param payload 输出参数：帧负载
-     * @return true 如果成功，false 如果失败或连接关闭
+     * @brief 应用对端SETTINGS帧中的参数
+     *
+     * 未知参数被忽略（RFC 9113 6.5.2）。
+     *
+     * @param payload SETTINGS帧负载（6字节一组的标识符/值）
+     * @param length 负载长度
+     * @return 0 如果成功，否则为连接错误码（PROTOCOL_ERROR 或 FLOW_CONTROL_ERROR）
      */
-    bool recvFrame(uint8_t& type, uint8_t& flags, uint32_t& stream_id,
-                   std::vector<uint8_t>& payload);
+    uint32_t applyPeerSettings(const uint8_t* payload, size_t length);
+
+    /**
+     * @brief 发送 WINDOW_UPDATE 帧（stream_id 为 0 时是连接级）
+     */
+    bool sendWindowUpdate(uint32_t stream_id, uint32_t increment);
+
+    /**
+     * @brief 记录已交付给调用方的 DATA 字节，累计超过窗口一半时归还额度
+     *
+     * @param stream 所属的流；流已结束或未知时为 nullptr，只归还连接级额度
+     */
+    void consumeData(uint32_t stream_id, Stream* stream, uint32_t length);
+
+    /**
+     * @brief 消费驱动模式的流：调用方处理完 length 字节后归还流级额度
+     */
+    void releaseCredit(uint32_t stream_id, size_t length);
+
+    /**
+     * @brief 流的接收窗口大小：当前窗口，消费驱动模式下不超过缓存上限
+     */
+    uint32_t streamWindow(const Stream& stream) const;
+
+    /**
+     * @brief 额度达到窗口大小的一半时发送 WINDOW_UPDATE
+     */
+    void returnCredit(uint32_t stream_id, int64_t& window, int64_t& credit, uint32_t size);
+
+    /**
+     * @brief 统计收到的 DATA 字节；没有测量在途且流未结束时发出测量 PING
+     */
+    void sampleData(uint32_t length, bool end_stream);
+
+    /**
+     * @brief 测量 PING 的 ACK：由往返时间和期间收到的字节数调整窗口
+     */
+    void onBdpSample();
+
+    /**
+     * @brief 修改当前窗口大小，差值计入各自的额度
+     */
+    void setWindowTargets(uint32_t stream_window, uint32_t connection_window);
+
+    /**
+     * @brief 发送 RST_STREAM 并以同一错误码结束流
+     */
+    void resetStream(uint32_t stream_id, Stream& stream, uint32_t error_code);
 
     /**
      * @brief 发送HEADERS帧（包含编码的请求头）
+     *
+     * 头块直接编码到写队列，超过对端最大帧大小时拆分为
+     * HEADERS + CONTINUATION 帧。
      * 
      * @param stream_id 流ID
      * @param method HTTP方法（GET、POST等）
@@ -171,30 +724,87 @@ private:
                           bool end_stream);
 
     /**
-     * @brief 接收响应头和数据
-     * 
-     * @param stream_id 流ID
-     * @return Response 响应对象
+     * @brief 获取指定方法的请求头模板（:method、:scheme、:authority）
+     *
+     * @param method HTTP方法
+     * @return RequestTemplate& 该连接上复用的模板
      */
-    Response receiveResponse(uint32_t stream_id);
+    RequestTemplate& requestTemplate(const std::string& method);
 
     /**
-     * @brief 从socket读取数据
-     * 
-     * @param buffer 缓冲区
-     * @param size 读取大小
-     * @return 实际读取的字节数，-1表示错误
+     * @brief 打开新流并发送请求头
+     *
+     * @return 流ID，失败时为 0
      */
-    int socketRead(uint8_t* buffer, size_t size);
+    uint32_t openStream(const std::string& method, const std::string& path,
+                        const std::vector<std::pair<std::string, std::string>>& headers,
+                        ResponseCallback on_response, StreamHandler handler);
 
     /**
-     * @brief 向socket写入数据
-     * 
-     * @param buffer 缓冲区
-     * @param size 写入大小
-     * @return 实际写入的字节数，-1表示错误
+     * @brief 按流ID分发一个完整的帧
+     *
+     * @param frame 引用接收环的帧（填充等字段会被就地去除）
+     * @return true 如果连接仍可用，false 如果出现连接错误或收到错误的 GOAWAY
+     */
+    bool dispatchFrame(FrameView& frame);
+
+    /**
+     * @brief 解码已完整接收的头块，写入所属流的响应
+     *
+     * 单帧头块直接从接收环解码，跨 CONTINUATION 的头块先拼接到 header_block_。
+     *
+     * @param stream_id 头块所属的流ID
+     * @param block 头块
+     * @param length 头块长度
+     * @return true 如果成功，false 如果解码失败（已发送 COMPRESSION_ERROR 的 GOAWAY）
+     */
+    bool onHeaderBlock(uint32_t stream_id, const uint8_t* block, size_t length);
+
+    /**
+     * @brief 结束流并记录错误码；异步流加入待回调列表
+     */
+    void closeStream(uint32_t stream_id, Stream& stream, uint32_t error_code);
+
+    /**
+     * @brief 以错误码结束 ID 大于 after_stream_id 的所有未结束流
+     */
+    void failOpenStreams(uint32_t after_stream_id, uint32_t error_code);
+
+    /**
+     * @brief 连接错误：以错误码结束所有未结束的流并向对端发送 GOAWAY
+     *
+     * 调用方随后返回 false，由上层调用 failConnection 关闭连接。
+     */
+    void goAway(uint32_t error_code);
+
+    /**
+     * @brief 调用已结束异步流的回调，并发出排队的请求
+     */
+    void deliverCompleted();
+
+    /**
+     * @brief 在并发限制内发出排队的异步请求
+     */
+    void startPendingRequests();
+
+    /**
+     * @brief 连接出错：结束所有流、拒绝排队的请求并释放连接
+     */
+    void failConnection(uint32_t error_code);
+
+    /**
+     * @brief 调用并清除连接完成回调
+     */
+    void finishConnect(bool connected);
+
+    /**
+     * @brief 运行事件循环直到条件满足、连接断开或超时
+     *
+     * 在本连接分发帧的过程中调用时不运行事件循环：嵌套的一轮会重入帧解析。
+     *
+     * @return done() 的最终结果（超时或被拒绝时返回 false）
      */
-    int socketWrite(const uint8_t* buffer, size_t size);
+    bool runUntil(const std::function<bool()>& done);
 
     /**
      * @brief 清理资源
@@ -202,6 +812,150 @@ private:
     void cleanup();
 };
 
+#if HTTP2_HAVE_COROUTINES
+
+/**
+ * @class Http2Client::ResponseReader
+ * @brief 一个请求的流级 awaitable
+ *
+ * headers()、read()、finish() 分别等待最终响应头、下一个响应体数据块和流结束。
+ * 流式读取时数据块在 read() 取走之前缓存在读取器中，流级额度在取走时才归还，
+ * 因此缓存不超过 setStreamBufferLimit()；协程在帧解析过程中恢复，
+ * 其中不能断开连接。读取器可以比客户端活得更久，但此后不会再有新的事件。
+ */
+class Http2Client::ResponseReader {
+    struct State {
+        Response head;      // 最终响应头，headers() 返回其引用，之后不再整体赋值
+        Response response;  // 流结束时的完整响应，由 finish() 取走
+        std::deque<std::vector<uint8_t>> chunks;
+        StreamCredit credit;
+        bool headers_ready = false;
+        bool closed = false;
+        std::coroutine_handle<> waiter;
+
+        void notify() {
+            if (auto handle = std::exchange(waiter, nullptr)) {
+                handle.resume();
+            }
+        }
+    };
+
+    template <typename Ready, typename Result>
+    struct Awaiter {
+        std::shared_ptr<State> state;
+        Ready ready;
+        Result result;
+
+        bool await_ready() const {
+            return ready(*state);
+        }
+
+        void await_suspend(std::coroutine_handle<> handle) {
+            state->waiter = handle;
+        }
+
+        decltype(auto) await_resume() {
+            return result(*state);
+        }
+    };
+
+    template <typename Ready, typename Result>
+    Awaiter<Ready, Result> await(Ready ready, Result result) const {
+        return {state_, ready, result};
+    }
+
+public:
+    ResponseReader(Http2Client& client, const std::string& method, const std::string& path,
+                   const std::vector<std::pair<std::string, std::string>>& headers, bool streaming)
+        : state_(std::make_shared<State>()) {
+        std::weak_ptr<State> weak = state_;
+        StreamHandler handler;
+        handler.on_headers = [weak](const Response& response) {
+            if (auto state = weak.lock()) {
+                state->head.status_code = response.status_code;
+                for (const auto& [name, value] : response.headers) {
+                    state->head.headers.emplace_back(name, value);
+                }
+                state->headers_ready = true;
+                state->notify();
+            }
+        };
+        if (streaming) {
+            handler.on_data = [weak](const uint8_t* data, size_t length) {
+                if (auto state = weak.lock()) {
+                    state->chunks.emplace_back(data, data + length);
+                    state->notify();
+                }
+            };
+            handler.on_open = [weak](StreamCredit credit) {
+                if (auto state = weak.lock()) {
+                    state->credit = std::move(credit);
+                }
+            };
+        }
+        client.submitAsync(method, path, headers, [weak](Response&& response) {
+            if (auto state = weak.lock()) {
+                if (!state->headers_ready) {
+                    state->head.error_code = response.error_code;
+                }
+                state->response = std::move(response);
+                state->closed = true;
+                state->notify();
+            }
+        }, std::move(handler));
+    }
+
+    /**
+     * @brief 等待最终响应头；流在响应头之前结束时 error_code 非 0
+     *
+     * 返回的引用在读取器存在期间一直有效，不受流结束的影响。
+     */
+    auto headers() const {
+        return await([](const State& state) { return state.headers_ready || state.closed; },
+                     [](State& state) -> const Response& { return state.head; });
+    }
+
+    /**
+     * @brief 等待下一个响应体数据块，流结束后返回 std::nullopt
+     */
+    auto read() const {
+        return await([](const State& state) { return !state.chunks.empty() || state.closed; },
+                     [](State& state) -> std::optional<std::vector<uint8_t>> {
+                         if (state.chunks.empty()) {
+                             return std::nullopt;
+                         }
+                         std::vector<uint8_t> chunk = std::move(state.chunks.front());
+                         state.chunks.pop_front();
+                         state.credit.consume(chunk.size());
+                         return chunk;
+                     });
+    }
+
+    /**
+     * @brief 等待流结束，取走响应（尾部字段、错误码；非流式读取时包括响应体）
+     */
+    auto finish() const {
+        return await([](const State& state) { return state.closed; },
+                     [](State& state) { return std::move(state.response); });
+    }
+
+private:
+    std::shared_ptr<State> state_;
+};
+
+inline Http2Client::ResponseReader Http2Client::stream(
+    std::string method, std::string path, std::vector<std::pair<std::string, std::string>> headers) {
+    return ResponseReader(*this, method, path, headers, true);
+}
+
+inline Task<Http2Client::Response> Http2Client::request(
+    std::string method, std::string path, std::vector<std::pair<std::string, std::string>> headers) {
+    ResponseReader reader(*this, method, path, headers, false);
+    co_return co_await reader.finish();
+}
+
+#endif // HTTP2_HAVE_COROUTINES
+
 } // namespace http2
 
 #endif // HTTP2_CLIENT_H
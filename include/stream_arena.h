@@ -0,0 +1,60 @@
+#ifndef HTTP2_STREAM_ARENA_H
+#define HTTP2_STREAM_ARENA_H
+
+#include <cstddef>
+#include <memory_resource>
+
+namespace http2 {
+
+/**
+ * @class StreamArena
+ * @brief 每个流一个的单调内存池，用于解码后的头字段和响应数据
+ *
+ * 头字段名称、值以及响应体都从同一个 std::pmr::monotonic_buffer_resource
+ * 分配：小响应完全落在内联缓冲区中，超出部分按几何增长向上游申请大块内存。
+ * 单个对象的释放不回收内存，流结束时整个 arena 一次性释放，因此一个请求的
+ * 堆分配次数与头字段数量无关。
+ *
+ * arena 必须比所有使用它的容器活得更久；不可复制、不可移动，
+ * 需要转移所有权时通过 std::unique_ptr 持有。
+ */
+class StreamArena {
+public:
+    // 内联缓冲区大小：覆盖常见响应的全部头字段
+    static constexpr size_t INLINE_SIZE = 4096;
+
+    /**
+     * @brief 构造函数
+     *
+     * @param upstream 内联缓冲区用完后申请内存的上游资源
+     */
+    explicit StreamArena(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+        : resource_(buffer_, sizeof(buffer_), upstream) {}
+
+    StreamArena(const StreamArena&) = delete;
+    StreamArena& operator=(const StreamArena&) = delete;
+
+    /**
+     * @brief 供 PMR 容器使用的内存资源
+     */
+    std::pmr::memory_resource* resource() {
+        return &resource_;
+    }
+
+    /**
+     * @brief 释放所有分配，回到只使用内联缓冲区的状态
+     *
+     * 调用前必须销毁或清空所有从该 arena 分配的容器。
+     */
+    void release() {
+        resource_.release();
+    }
+
+private:
+    alignas(std::max_align_t) std::byte buffer_[INLINE_SIZE];
+    std::pmr::monotonic_buffer_resource resource_;
+};
+
+} // namespace http2
+
+#endif // HTTP2_STREAM_ARENA_H
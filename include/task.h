@@ -0,0 +1,197 @@
+#ifndef HTTP2_TASK_H
+#define HTTP2_TASK_H
+
+// 协程接口需要 C++20；C++17 编译时本文件不定义任何内容
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#define HTTP2_HAVE_COROUTINES 1
+#else
+#define HTTP2_HAVE_COROUTINES 0
+#endif
+
+#if HTTP2_HAVE_COROUTINES
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+namespace http2 {
+
+template <typename T>
+class Task;
+
+namespace detail {
+
+// 协程结束时恢复等待者（对称转移，不增加调用栈深度）
+struct TaskFinalAwaiter {
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) const noexcept {
+        if (auto continuation = handle.promise().continuation) {
+            return continuation;
+        }
+        return std::noop_coroutine();
+    }
+
+    void await_resume() const noexcept {}
+};
+
+struct TaskPromiseBase {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr error;
+
+    std::suspend_always initial_suspend() const noexcept {
+        return {};
+    }
+
+    TaskFinalAwaiter final_suspend() const noexcept {
+        return {};
+    }
+
+    void unhandled_exception() noexcept {
+        error = std::current_exception();
+    }
+};
+
+template <typename T>
+struct TaskPromise : TaskPromiseBase {
+    std::optional<T> value;
+
+    Task<T> get_return_object();
+
+    template <typename U>
+    void return_value(U&& result) {
+        value.emplace(std::forward<U>(result));
+    }
+
+    T take() {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        return std::move(*value);
+    }
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase {
+    Task<void> get_return_object();
+
+    void return_void() const noexcept {}
+
+    void take() const {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+};
+
+} // namespace detail
+
+/**
+ * @class Task
+ * @brief 惰性启动的协程任务
+ *
+ * 协程创建后先挂起，被 co_await 时才开始执行，结束时恢复等待者。
+ * 顶层任务没有等待者：调用 start() 开始执行，运行事件循环直到 done()，
+ * 再用 result() 取得结果（协程中的异常在此重新抛出）。
+ *
+ * Task 拥有协程帧，只能移动；销毁未完成的任务会销毁其协程帧。
+ */
+template <typename T = void>
+class Task {
+public:
+    using promise_type = detail::TaskPromise<T>;
+
+    Task() = default;
+
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) {
+                handle_.destroy();
+            }
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    /**
+     * @brief 开始执行顶层任务（不能再被 co_await）
+     */
+    void start() {
+        handle_.resume();
+    }
+
+    /**
+     * @brief 协程是否已经结束
+     */
+    bool done() const {
+        return handle_ && handle_.done();
+    }
+
+    /**
+     * @brief 取得已结束任务的结果
+     *
+     * @throws 协程中未捕获的异常
+     */
+    T result() {
+        return handle_.promise().take();
+    }
+
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            std::coroutine_handle<promise_type> handle;
+
+            bool await_ready() const noexcept {
+                return false;
+            }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                handle.promise().continuation = awaiting;
+                return handle;
+            }
+
+            T await_resume() {
+                return handle.promise().take();
+            }
+        };
+        return Awaiter{handle_};
+    }
+
+private:
+    std::coroutine_handle<promise_type> handle_;
+};
+
+namespace detail {
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() {
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() {
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+} // namespace detail
+
+} // namespace http2
+
+#endif // HTTP2_HAVE_COROUTINES
+
+#endif // HTTP2_TASK_H
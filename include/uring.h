@@ -0,0 +1,195 @@
+#ifndef HTTP2_URING_H
+#define HTTP2_URING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace http2 {
+
+/**
+ * @class IoUring
+ * @brief 直接基于 io_uring 系统调用的提交/完成队列（不依赖 liburing）
+ *
+ * 操作先写入提交队列，下一次 submitAndWait() 用一次 io_uring_enter
+ * 批量提交并等待完成；完成事件按操作 ID 分发给各自的回调。
+ *
+ * 同时管理两类内存：
+ * - 接收缓冲区：注册为 provided buffer ring，多次接收（multishot recv）
+ *   的数据由内核选择缓冲区写入，调用方处理完后用 recycleReceiveBuffer 归还；
+ * - 发送槽：注册为 fixed buffers，writeFixed 直接引用，免去每次提交时的页映射。
+ *
+ * 一个 IoUring 只能在一个线程上使用。
+ */
+class IoUring {
+public:
+    // 完成回调：result 为操作结果（负数为 -errno），flags 为 CQE 标志
+    using Handler = std::function<void(int32_t result, uint32_t flags)>;
+
+    static constexpr size_t RECV_BUFFER_SIZE = 16384;
+    static constexpr uint16_t RECV_BUFFER_COUNT = 128;   // 必须是 2 的幂
+    static constexpr size_t SEND_SLOT_SIZE = 16384;
+    static constexpr uint16_t SEND_SLOT_COUNT = 64;
+
+    /**
+     * @brief 构造函数
+     *
+     * @param entries 提交队列长度
+     * @throws std::runtime_error 如果内核不支持 io_uring 或所需特性
+     */
+    explicit IoUring(unsigned entries = 256);
+    ~IoUring();
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    /**
+     * @brief 当前内核是否可以创建 IoUring（结果会被缓存）
+     */
+    static bool supported();
+
+    /**
+     * @brief 多次触发的 poll，描述符每次就绪产生一个完成事件
+     *
+     * @return 操作ID
+     */
+    uint64_t pollMultishot(int fd, uint32_t events, Handler handler);
+
+    /**
+     * @brief 多次接收：每个完成事件携带一个接收缓冲区
+     *
+     * 完成标志中包含 IORING_CQE_F_BUFFER 时，缓冲区ID为
+     * flags >> IORING_CQE_BUFFER_SHIFT。没有 IORING_CQE_F_MORE 时接收已停止，
+     * 需要重新提交（例如缓冲区用尽时 result 为 -ENOBUFS）。
+     *
+     * @return 操作ID
+     */
+    uint64_t recvMultishot(int fd, Handler handler);
+
+    /**
+     * @brief 从发送槽写出数据
+     *
+     * @param offset 槽内起始偏移（短写后重发剩余部分）
+     * @param link 与下一个提交的操作链接：本操作完成后才开始下一个，
+     *             失败或短写时后续操作以 -ECANCELED 完成
+     * @return 操作ID
+     */
+    uint64_t writeFixed(int fd, uint16_t slot, size_t offset, size_t length, bool link,
+                        Handler handler);
+
+    /**
+     * @brief 普通发送（发送槽用尽时使用）
+     *
+     * 缓冲区由操作持有到最终完成，即使操作被取消。
+     *
+     * @return 操作ID
+     */
+    uint64_t send(int fd, std::shared_ptr<const std::vector<uint8_t>> data, size_t offset,
+                  size_t length, bool link, Handler handler);
+
+    /**
+     * @brief 取消操作并丢弃其回调
+     *
+     * @param id 操作ID
+     * @param release_slot 操作最终完成时归还的发送槽，-1 表示无
+     */
+    void cancel(uint64_t id, int release_slot = -1);
+
+    /**
+     * @brief 确保接下来的 count 个操作可以放进提交队列
+     *
+     * 链接的一组操作必须在同一次 io_uring_enter 中提交，否则链会在批次边界断开。
+     * 空间不足时先提交已排队的操作。
+     */
+    void reserve(unsigned count);
+
+    const uint8_t* receiveBuffer(uint16_t id) const;
+    void recycleReceiveBuffer(uint16_t id);
+
+    /**
+     * @brief 申请一个发送槽
+     *
+     * @return 槽编号，没有空闲槽时返回 -1
+     */
+    int acquireSendSlot();
+    uint8_t* sendSlot(uint16_t slot);
+    void releaseSendSlot(uint16_t slot);
+
+    /**
+     * @brief 提交所有排队的操作，等待至少一个完成事件并分发
+     *
+     * @param timeout_ms 最长等待时间（毫秒），-1 表示无限等待，0 表示不等待
+     * @return 分发的完成事件数
+     */
+    size_t submitAndWait(int timeout_ms);
+
+    /**
+     * @brief 尚未最终完成的操作数
+     */
+    size_t pending() const;
+
+    /**
+     * @brief io_uring_enter 系统调用次数
+     */
+    uint64_t enterCalls() const;
+
+private:
+    struct Operation {
+        std::shared_ptr<Handler> handler;
+        int release_slot = -1;
+        std::shared_ptr<const std::vector<uint8_t>> buffer;  // send() 的数据
+    };
+
+    int ring_fd_;
+    unsigned sq_entries_;
+
+    // 映射的队列内存（提交队列与完成队列共用一次映射）
+    void* sq_ring_;
+    size_t sq_ring_size_;
+    io_uring_sqe* sqes_;
+    size_t sqes_size_;
+
+    unsigned* sq_head_;
+    unsigned* sq_tail_;
+    unsigned* sq_mask_;
+    unsigned* sq_array_;
+    unsigned* cq_head_;
+    unsigned* cq_tail_;
+    unsigned* cq_mask_;
+    io_uring_cqe* cqes_;
+
+    unsigned sqe_tail_;       // 本地提交队列尾（尚未发布给内核）
+    unsigned submitted_tail_; // 已发布的尾
+
+    // provided buffer ring 与接收缓冲区
+    void* buf_ring_;
+    size_t buf_ring_size_;
+    std::unique_ptr<uint8_t[]> recv_buffers_;
+    uint16_t buf_ring_tail_;
+
+    // 注册的发送槽
+    std::unique_ptr<uint8_t[]> send_slots_;
+    std::vector<uint16_t> free_slots_;
+
+    uint64_t next_id_;
+    std::unordered_map<uint64_t, Operation> operations_;
+    uint64_t enter_calls_;
+
+    io_uring_sqe* nextSqe();
+    uint64_t track(Handler handler);
+    int enter(unsigned to_submit, unsigned min_complete, int timeout_ms);
+    size_t dispatchCompletions();
+    void setupBufferRing();
+    void registerSendSlots();
+    void releaseRing();
+};
+
+} // namespace http2
+
+#endif // HTTP2_URING_H
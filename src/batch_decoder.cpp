@@ -0,0 +1,145 @@
+#include "batch_decoder.h"
+#include <algorithm>
+#include <unordered_map>
+
+namespace http2 {
+
+BatchDecoder::BatchDecoder(size_t thread_count)
+    : generation_(0), active_workers_(0), stopping_(false), jobs_(nullptr),
+      steal_count_(0) {
+    if (thread_count == 0) {
+        thread_count = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < thread_count; ++i) {
+        queues_.push_back(std::make_unique<WorkerQueue>());
+    }
+    // 工作线程 0 是调用线程
+    for (size_t i = 1; i < thread_count; ++i) {
+        threads_.emplace_back(&BatchDecoder::workerLoop, this, i);
+    }
+}
+
+BatchDecoder::~BatchDecoder() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    work_ready_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+size_t BatchDecoder::threadCount() const {
+    return queues_.size();
+}
+
+size_t BatchDecoder::lastStealCount() const {
+    return steal_count_;
+}
+
+void BatchDecoder::decode(std::vector<HeaderBlockJob>& jobs) {
+    // 按解码器分组，保持批次内的相对顺序
+    std::vector<Chain> chains;
+    std::unordered_map<HpackDecoder*, size_t> chain_of;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        auto [it, inserted] = chain_of.emplace(jobs[i].decoder, chains.size());
+        if (inserted) {
+            chains.emplace_back();
+        }
+        chains[it->second].push_back(i);
+    }
+
+    for (size_t i = 0; i < chains.size(); ++i) {
+        queues_[i % queues_.size()]->chains.push_back(&chains[i]);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_ = &jobs;
+        error_ = nullptr;
+        steal_count_ = 0;
+        active_workers_ = threads_.size();
+        ++generation_;
+    }
+    work_ready_.notify_all();
+
+    runWorker(0);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    work_done_.wait(lock, [this] { return active_workers_ == 0; });
+    jobs_ = nullptr;
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+}
+
+void BatchDecoder::workerLoop(size_t worker) {
+    uint64_t seen_generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_ready_.wait(lock, [&] { return stopping_ || generation_ != seen_generation; });
+            if (stopping_) {
+                return;
+            }
+            seen_generation = generation_;
+        }
+
+        runWorker(worker);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--active_workers_ == 0) {
+            work_done_.notify_one();
+        }
+    }
+}
+
+void BatchDecoder::runWorker(size_t worker) {
+    while (Chain* chain = nextChain(worker)) {
+        runChain(*chain);
+    }
+}
+
+BatchDecoder::Chain* BatchDecoder::nextChain(size_t worker) {
+    // 优先处理本地队列头部
+    {
+        WorkerQueue& own = *queues_[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.chains.empty()) {
+            Chain* chain = own.chains.front();
+            own.chains.pop_front();
+            return chain;
+        }
+    }
+
+    // 本地队列为空：从其他线程队列尾部窃取
+    for (size_t offset = 1; offset < queues_.size(); ++offset) {
+        WorkerQueue& victim = *queues_[(worker + offset) % queues_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.chains.empty()) {
+            Chain* chain = victim.chains.back();
+            victim.chains.pop_back();
+            std::lock_guard<std::mutex> stats_lock(mutex_);
+            ++steal_count_;
+            return chain;
+        }
+    }
+    return nullptr;
+}
+
+void BatchDecoder::runChain(const Chain& chain) {
+    for (size_t index : chain) {
+        HeaderBlockJob& job = (*jobs_)[index];
+        try {
+            job.headers = job.decoder->decode(job.data, job.length);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!error_) {
+                error_ = std::current_exception();
+            }
+        }
+    }
+}
+
+} // namespace http2
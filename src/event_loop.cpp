@@ -0,0 +1,211 @@
+#include "event_loop.h"
+#include "uring.h"
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+namespace http2 {
+
+namespace {
+
+// 每轮最多取回的事件数
+constexpr size_t MAX_EVENTS = 256;
+
+} // namespace
+
+EventLoop::EventLoop(Backend backend)
+    : epoll_fd_(epoll_create1(EPOLL_CLOEXEC)), stopping_(false),
+      next_deferred_(1),
+      epoll_armed_(false), epoll_ready_(false) {
+    if (epoll_fd_ < 0) {
+        throw std::runtime_error(std::string("epoll_create1 failed: ") + std::strerror(errno));
+    }
+    if (backend == Backend::IO_URING) {
+        try {
+            uring_ = std::make_unique<IoUring>();
+        } catch (...) {
+            close(epoll_fd_);
+            throw;
+        }
+    }
+}
+
+EventLoop::~EventLoop() {
+    uring_.reset();
+    close(epoll_fd_);
+}
+
+bool EventLoop::add(int fd, uint32_t events, Callback callback) {
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = fd;
+    ++stats_.ctl_calls;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0) {
+        return false;
+    }
+    watches_[fd] = std::make_shared<Watch>(Watch{events, std::move(callback)});
+    return true;
+}
+
+bool EventLoop::modify(int fd, uint32_t events) {
+    auto it = watches_.find(fd);
+    if (it == watches_.end()) {
+        return false;
+    }
+    if (it->second->events == events) {
+        return true;
+    }
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = fd;
+    ++stats_.ctl_calls;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event) < 0) {
+        return false;
+    }
+    it->second->events = events;
+    return true;
+}
+
+void EventLoop::remove(int fd) {
+    if (watches_.erase(fd) > 0) {
+        ++stats_.ctl_calls;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    }
+}
+
+uint64_t EventLoop::defer(DeferredTask task) {
+    uint64_t id = next_deferred_++;
+    deferred_.emplace(id, std::move(task));
+    deferred_order_.push_back(id);
+    return id;
+}
+
+void EventLoop::cancelDeferred(uint64_t id) {
+    deferred_.erase(id);
+}
+
+void EventLoop::runDeferred() {
+    // 任务可能登记新任务（留到下一次）或取消同一批中的其他任务
+    std::vector<uint64_t> order;
+    order.swap(deferred_order_);
+    for (uint64_t id : order) {
+        auto it = deferred_.find(id);
+        if (it == deferred_.end()) {
+            continue;
+        }
+        DeferredTask task = std::move(it->second);
+        deferred_.erase(it);
+        task();
+    }
+}
+
+size_t EventLoop::runOnce(int timeout_ms) {
+    runDeferred();
+    if (!deferred_.empty()) {
+        timeout_ms = 0;  // 任务又登记了任务，不阻塞
+    }
+    size_t dispatched = uring_ ? dispatchRing(timeout_ms) : dispatchReady(timeout_ms);
+    runDeferred();
+    return dispatched;
+}
+
+size_t EventLoop::dispatchRing(int timeout_ms) {
+    if (!epoll_armed_) {
+        epoll_armed_ = true;
+        uring_->pollMultishot(epoll_fd_, POLLIN, [this](int32_t result, uint32_t flags) {
+            if (!(flags & IORING_CQE_F_MORE)) {
+                epoll_armed_ = false;
+            }
+            if (result > 0) {
+                epoll_ready_ = true;
+            }
+        });
+    }
+
+    // epoll 上仍可能有未取完的事件时不阻塞
+    size_t dispatched = uring_->submitAndWait(epoll_ready_ ? 0 : timeout_ms);
+    if (epoll_ready_) {
+        size_t count = dispatchReady(0);
+        // 取空之后才依赖 poll 的下一次唤醒
+        epoll_ready_ = count > 0;
+        dispatched += count;
+    }
+    return dispatched;
+}
+
+size_t EventLoop::dispatchReady(int timeout_ms) {
+    // 每次调用独立的数组：回调中可能嵌套调用 runOnce()
+    epoll_event events[MAX_EVENTS];
+    ++stats_.wait_calls;
+    int count = epoll_wait(epoll_fd_, events, static_cast<int>(MAX_EVENTS), timeout_ms);
+    if (count < 0) {
+        if (errno == EINTR) {
+            return 0;
+        }
+        throw std::runtime_error(std::string("epoll_wait failed: ") + std::strerror(errno));
+    }
+
+    size_t dispatched = 0;
+    for (int i = 0; i < count; ++i) {
+        auto it = watches_.find(events[i].data.fd);
+        if (it == watches_.end()) {
+            continue;  // 本轮中已被移除
+        }
+        // 持有引用：回调可能移除自身
+        std::shared_ptr<Watch> watch = it->second;
+        watch->callback(events[i].events);
+        ++dispatched;
+    }
+    return dispatched;
+}
+
+void EventLoop::run() {
+    stopping_ = false;
+    // 常驻的 epoll poll 不算未完成的操作
+    auto busy = [this] {
+        return !watches_.empty() || !deferred_.empty() || (uring_ && uring_->pending() > (epoll_armed_ ? 1u : 0u));
+    };
+    while (!stopping_) {
+        // 先运行延迟任务：它们可能是仅剩的工作
+        runDeferred();
+        if (stopping_ || !busy()) {
+            break;
+        }
+        runOnce();
+    }
+}
+
+void EventLoop::stop() {
+    stopping_ = true;
+}
+
+size_t EventLoop::size() const {
+    return watches_.size();
+}
+
+EventLoop::Backend EventLoop::backend() const {
+    return uring_ ? Backend::IO_URING : Backend::EPOLL;
+}
+
+IoUring* EventLoop::uring() {
+    return uring_.get();
+}
+
+void EventLoop::recordIo(uint64_t calls) {
+    stats_.io_calls += calls;
+}
+
+EventLoop::Stats EventLoop::stats() const {
+    Stats stats = stats_;
+    if (uring_) {
+        stats.wait_calls += uring_->enterCalls();
+    }
+    return stats;
+}
+
+} // namespace http2
@@ -0,0 +1,201 @@
+#include "frame.h"
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace http2 {
+
+void writeFrameHeader(uint8_t* out, const FrameHeader& header) {
+    // 长度（3字节，大端）
+    out[0] = (header.length >> 16) & 0xFF;
+    out[1] = (header.length >> 8) & 0xFF;
+    out[2] = header.length & 0xFF;
+    out[3] = header.type;
+    out[4] = header.flags;
+    // 流ID（4字节，大端，最高位必须为0）
+    out[5] = (header.stream_id >> 24) & 0x7F;
+    out[6] = (header.stream_id >> 16) & 0xFF;
+    out[7] = (header.stream_id >> 8) & 0xFF;
+    out[8] = header.stream_id & 0xFF;
+}
+
+FrameHeader readFrameHeader(const uint8_t* data) {
+    FrameHeader header;
+    header.length = ((uint32_t)data[0] << 16) | ((uint32_t)data[1] << 8) | data[2];
+    header.type = data[3];
+    header.flags = data[4];
+    header.stream_id = (((uint32_t)data[5] & 0x7F) << 24) |
+                       ((uint32_t)data[6] << 16) |
+                       ((uint32_t)data[7] << 8) |
+                       data[8];
+    return header;
+}
+
+// ============================================================================
+// HeaderFrameBuilder Implementation
+// ============================================================================
+
+HeaderFrameBuilder::HeaderFrameBuilder(std::vector<uint8_t>& out, uint32_t stream_id,
+                                       uint32_t max_frame_size)
+    : out_(out), frame_start_(out.size()), stream_id_(stream_id),
+      max_frame_size_(std::max<uint32_t>(1, max_frame_size)) {
+    // 预留 HEADERS 帧头
+    out_.resize(out_.size() + FRAME_HEADER_SIZE);
+}
+
+std::vector<uint8_t>& HeaderFrameBuilder::block() {
+    return out_;
+}
+
+size_t HeaderFrameBuilder::finish(bool end_stream) {
+    size_t payload_start = frame_start_ + FRAME_HEADER_SIZE;
+    size_t block_size = out_.size() - payload_start;
+    size_t frame_count = block_size == 0 ? 1 : (block_size + max_frame_size_ - 1) / max_frame_size_;
+    uint8_t end_stream_flag = end_stream ? FLAG_END_STREAM : 0;
+
+    if (frame_count == 1) {
+        writeFrameHeader(&out_[frame_start_],
+                         {static_cast<uint32_t>(block_size), FRAME_TYPE_HEADERS,
+                          static_cast<uint8_t>(FLAG_END_HEADERS | end_stream_flag), stream_id_});
+        return 1;
+    }
+
+    // 每个 CONTINUATION 帧需要额外的帧头：从后往前移动片段，避免覆盖未移动的数据
+    out_.resize(out_.size() + (frame_count - 1) * FRAME_HEADER_SIZE);
+    for (size_t i = frame_count; i-- > 0;) {
+        size_t src = payload_start + i * max_frame_size_;
+        size_t length = std::min<size_t>(max_frame_size_, block_size - i * max_frame_size_);
+        size_t dst_header = frame_start_ + i * (FRAME_HEADER_SIZE + max_frame_size_);
+        if (i > 0) {
+            std::memmove(&out_[dst_header + FRAME_HEADER_SIZE], &out_[src], length);
+        }
+
+        FrameHeader header;
+        header.length = static_cast<uint32_t>(length);
+        header.type = i == 0 ? FRAME_TYPE_HEADERS : FRAME_TYPE_CONTINUATION;
+        header.flags = i == 0 ? end_stream_flag : 0;
+        if (i == frame_count - 1) {
+            header.flags |= FLAG_END_HEADERS;
+        }
+        header.stream_id = stream_id_;
+        writeFrameHeader(&out_[dst_header], header);
+    }
+    return frame_count;
+}
+
+// ============================================================================
+// FrameReader Implementation
+// ============================================================================
+
+FrameReader::FrameReader(size_t capacity)
+    : base_(nullptr), capacity_(0), read_(0), size_(0) {
+    map(capacity);
+}
+
+FrameReader::~FrameReader() {
+    munmap(base_, capacity_ * 2);
+}
+
+void FrameReader::map(size_t capacity) {
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    capacity = (std::max<size_t>(capacity, 1) + page - 1) / page * page;
+
+    int fd = memfd_create("http2-frame-reader", MFD_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error(std::string("memfd_create failed: ") + std::strerror(errno));
+    }
+    if (ftruncate(fd, static_cast<off_t>(capacity)) < 0) {
+        int error = errno;
+        close(fd);
+        throw std::runtime_error(std::string("ftruncate failed: ") + std::strerror(error));
+    }
+
+    // 先保留两倍容量的地址空间，再把同一段内存固定映射到前后两半
+    void* region = mmap(nullptr, capacity * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    bool ok = region != MAP_FAILED;
+    auto* base = static_cast<uint8_t*>(region);
+    for (size_t half = 0; ok && half < 2; ++half) {
+        ok = mmap(base + half * capacity, capacity, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED;
+    }
+    int error = errno;
+    close(fd);
+    if (!ok) {
+        if (region != MAP_FAILED) {
+            munmap(region, capacity * 2);
+        }
+        throw std::runtime_error(std::string("frame buffer mmap failed: ") + std::strerror(error));
+    }
+
+    base_ = base;
+    capacity_ = capacity;
+}
+
+void FrameReader::grow(size_t capacity) {
+    uint8_t* old_base = base_;
+    size_t old_capacity = capacity_;
+    size_t old_read = read_;
+    map(capacity);
+    // 未取出的数据在旧映射中是连续的
+    std::memcpy(base_, old_base + old_read, size_);
+    read_ = 0;
+    munmap(old_base, old_capacity * 2);
+}
+
+uint8_t* FrameReader::writePointer() {
+    return base_ + (read_ + size_) % capacity_;
+}
+
+size_t FrameReader::writable() const {
+    return capacity_ - size_;
+}
+
+void FrameReader::commit(size_t length) {
+    size_ += std::min(length, writable());
+}
+
+bool FrameReader::peek(FrameHeader& header) const {
+    if (size_ < FRAME_HEADER_SIZE) {
+        return false;
+    }
+    header = readFrameHeader(base_ + read_);
+    return true;
+}
+
+bool FrameReader::next(FrameView& frame) {
+    if (size_ < FRAME_HEADER_SIZE) {
+        return false;
+    }
+    frame.header = readFrameHeader(base_ + read_);
+    size_t frame_size = FRAME_HEADER_SIZE + frame.header.length;
+    if (frame_size > capacity_) {
+        grow(frame_size * 2);
+    }
+    if (size_ < frame_size) {
+        return false;
+    }
+    frame.payload = base_ + read_ + FRAME_HEADER_SIZE;
+    frame.length = frame.header.length;
+    read_ = (read_ + frame_size) % capacity_;
+    size_ -= frame_size;
+    return true;
+}
+
+size_t FrameReader::buffered() const {
+    return size_;
+}
+
+size_t FrameReader::capacity() const {
+    return capacity_;
+}
+
+void FrameReader::clear() {
+    read_ = 0;
+    size_ = 0;
+}
+
+} // namespace http2
@@ -2,12 +2,132 @@
 #include "hpack.h"
 #include <algorithm>
 #include <cctype>
+#include <cstdint>
 
 namespace http2 {
 
+// Map a pseudo-header name to its HeaderValidation bit, 0 if unknown
+static uint8_t pseudoHeaderBit(const std::string& name) {
+    if (name == ":method") return HeaderValidation::PSEUDO_METHOD;
+    if (name == ":scheme") return HeaderValidation::PSEUDO_SCHEME;
+    if (name == ":authority") return HeaderValidation::PSEUDO_AUTHORITY;
+    if (name == ":path") return HeaderValidation::PSEUDO_PATH;
+    if (name == ":status") return HeaderValidation::PSEUDO_STATUS;
+    if (name == ":protocol") return HeaderValidation::PSEUDO_PROTOCOL;
+    return 0;
+}
+
+// RFC 9113 section 8.2.2: connection-specific fields are not allowed in HTTP/2
+static bool isConnectionSpecificHeader(const std::string& name) {
+    return name == "connection" || name == "keep-alive" ||
+           name == "proxy-connection" || name == "transfer-encoding" ||
+           name == "upgrade";
+}
+
+// RFC 9113 section 8.2.1: names are lowercase and contain no controls, spaces
+// or non-ASCII octets; a colon may only start a pseudo-header name
+static bool isValidFieldName(const std::string& name) {
+    if (name.empty()) {
+        return false;
+    }
+    for (size_t i = 0; i < name.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(name[i]);
+        if (c <= 0x20 || c >= 0x7f || (c >= 'A' && c <= 'Z') || (c == ':' && i > 0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// RFC 9113 section 8.2.1: values may be empty but never contain NUL, CR or LF
+static bool isValidFieldValue(const std::string& value) {
+    return value.find_first_of(std::string("\0\r\n", 3)) == std::string::npos;
+}
+
+// ============================================================================
+// HeaderValidator Implementation
+// ============================================================================
+
+bool HeaderValidator::fail(const char* reason) {
+    if (result_.error == nullptr) {
+        result_.error = reason;
+    }
+    return false;
+}
+
+bool HeaderValidator::addField(const std::string& name, const std::string& value) {
+    if (result_.error != nullptr) {
+        return false;
+    }
+    if (!isValidFieldName(name)) {
+        return fail("invalid header name");
+    }
+    if (!isValidFieldValue(value)) {
+        return fail("invalid header value");
+    }
+
+    if (name[0] == ':') {
+        if (seen_regular_) {
+            return fail("pseudo-header after regular header");
+        }
+        uint8_t bit = pseudoHeaderBit(name);
+        if (bit == 0) {
+            return fail("unknown pseudo-header");
+        }
+        if (result_.pseudo_headers & bit) {
+            return fail("duplicate pseudo-header");
+        }
+        result_.pseudo_headers |= bit;
+
+        // :status only appears in responses, everything else only in requests
+        const uint8_t request_bits = HeaderValidation::PSEUDO_METHOD |
+                                     HeaderValidation::PSEUDO_SCHEME |
+                                     HeaderValidation::PSEUDO_AUTHORITY |
+                                     HeaderValidation::PSEUDO_PATH |
+                                     HeaderValidation::PSEUDO_PROTOCOL;
+        if ((result_.pseudo_headers & HeaderValidation::PSEUDO_STATUS) &&
+            (result_.pseudo_headers & request_bits)) {
+            return fail("request and response pseudo-headers mixed");
+        }
+        return true;
+    }
+
+    seen_regular_ = true;
+    if (isConnectionSpecificHeader(name)) {
+        return fail("connection-specific header");
+    }
+    if (name == "te" && value != "trailers") {
+        return fail("te header other than trailers");
+    }
+    return true;
+}
+
+// ============================================================================
+// HeaderParser Implementation
+// ============================================================================
+
+// Append a decoded field, folding cookie crumbs into the first cookie field
+static void appendField(std::vector<std::pair<std::string, std::string>>& headers,
+                        const std::string& name, const std::string& value,
+                        bool join_cookies, size_t& cookie_index) {
+    if (join_cookies && name == "cookie") {
+        if (cookie_index < headers.size()) {
+            // RFC 9113 section 8.2.3: crumbs are concatenated with "; "
+            std::string& joined = headers[cookie_index].second;
+            joined.reserve(joined.size() + 2 + value.size());
+            joined += "; ";
+            joined += value;
+            return;
+        }
+        cookie_index = headers.size();
+    }
+    headers.emplace_back(name, value);
+}
+
 std::vector<std::pair<std::string, std::string>> HeaderParser::parseHeaders(
     const uint8_t* buffer,
-    size_t length) {
+    size_t length,
+    bool join_cookies) {
     // Parse header block using HPACK decompression
     std::vector<std::pair<std::string, std::string>> headers;
     
@@ -15,27 +135,62 @@ std::vector<std::pair<std::string, std::string>> HeaderParser::parseHeaders(
         return headers;
     }
     
-    // Convert buffer to vector for HPACK decoder
-    std::vector<uint8_t> data(buffer, buffer + length);
-    
+    size_t cookie_index = SIZE_MAX;
     try {
-        headers = HPACK::decode(data);
+        HPACK::decode(buffer, length,
+                      [&](const std::string& name, const std::string& value) {
+                          appendField(headers, name, value, join_cookies, cookie_index);
+                      });
     } catch (const std::exception& e) {
         // Return empty on decode failure
+        headers.clear();
     }
     
     return headers;
 }
 
+std::vector<std::pair<std::string, std::string>> HeaderParser::parseHeaders(
+    const uint8_t* buffer,
+    size_t length,
+    HeaderValidation& validation,
+    bool join_cookies) {
+    std::vector<std::pair<std::string, std::string>> headers;
+    HeaderValidator validator;
+    size_t cookie_index = SIZE_MAX;
+
+    if (buffer != nullptr && length > 0) {
+        try {
+            HPACK::decode(buffer, length,
+                          [&](const std::string& name, const std::string& value) {
+                              if (validator.addField(name, value)) {
+                                  appendField(headers, name, value, join_cookies, cookie_index);
+                              }
+                          });
+        } catch (const std::exception& e) {
+            headers.clear();
+        }
+    }
+
+    validation = validator.result();
+    if (!validation.valid()) {
+        headers.clear();
+    }
+    return headers;
+}
+
 bool HeaderParser::validateHeaders(
-    const std::vector<std::pair<std::string, std::string>>& headers) {
-    // TODO: Implement header validation
+    const std::vector<std::pair<std::string, std::string>>& headers,
+    HeaderValidation* summary) {
+    HeaderValidator validator;
     for (const auto& header : headers) {
-        if (!isValidHeaderName(header.first) || !isValidHeaderValue(header.second)) {
-            return false;
+        if (!validator.addField(header.first, header.second)) {
+            break;
         }
     }
-    return true;
+    if (summary != nullptr) {
+        *summary = validator.result();
+    }
+    return validator.result().valid();
 }
 
 bool HeaderParser::isValidHeaderName(const std::string& name) {
@@ -1,13 +1,29 @@
 #include "hpack.h"
+#include "hpack_tables.h"
 #include <algorithm>
 #include <limits>
 #include <cctype>
 #include <deque>
 #include <map>
 #include <iostream>
+#include <array>
+#include <cstring>
+#include <atomic>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define HTTP2_HPACK_HAVE_AVX2 1
+#else
+#define HTTP2_HPACK_HAVE_AVX2 0
+#endif
 
 namespace http2 {
 
+using hpack_tables::STATIC_TABLE;
+using hpack_tables::STATIC_TABLE_SIZE;
+using hpack_tables::HuffmanCode;
+using hpack_tables::HUFFMAN_CODE_TABLE;
+
 // ============================================================================
 // 辅助函数：字符串小写转换
 // ============================================================================
@@ -25,147 +41,16 @@ static std::string toLower(const std::string& str) {
 }
 
 // ============================================================================
-// StaticTable 实现
+// StaticTable 实现（表数据见 hpack_tables.h）
 // ============================================================================
 
-/**
- * RFC 7541 附录 B 的静态表
- * 包含 61 个预定义的 HTTP/2 标准头字段
- * 索引从 1 开始（遵循 RFC 标准）
- */
-static const HeaderField STATIC_TABLE[] = {
-    // Index 1
-    {":authority", ""},
-    // Index 2
-    {":method", "GET"},
-    // Index 3
-    {":method", "POST"},
-    // Index 4
-    {":path", "/"},
-    // Index 5
-    {":path", "/index.html"},
-    // Index 6
-    {":scheme", "http"},
-    // Index 7
-    {":scheme", "https"},
-    // Index 8
-    {":status", "200"},
-    // Index 9
-    {":status", "204"},
-    // Index 10
-    {":status", "206"},
-    // Index 11
-    {":status", "304"},
-    // Index 12
-    {":status", "400"},
-    // Index 13
-    {":status", "404"},
-    // Index 14
-    {":status", "500"},
-    // Index 15
-    {"accept-charset", ""},
-    // Index 16
-    {"accept-encoding", "gzip, deflate"},
-    // Index 17
-    {"accept-language", ""},
-    // Index 18
-    {"accept-ranges", ""},
-    // Index 19
-    {"accept", ""},
-    // Index 20
-    {"access-control-allow-origin", ""},
-    // Index 21
-    {"age", ""},
-    // Index 22
-    {"allow", ""},
-    // Index 23
-    {"authorization", ""},
-    // Index 24
-    {"cache-control", ""},
-    // Index 25
-    {"content-disposition", ""},
-    // Index 26
-    {"content-encoding", ""},
-    // Index 27
-    {"content-language", ""},
-    // Index 28
-    {"content-length", ""},
-    // Index 29
-    {"content-location", ""},
-    // Index 30
-    {"content-range", ""},
-    // Index 31
-    {"content-type", ""},
-    // Index 32
-    {"cookie", ""},
-    // Index 33
-    {"date", ""},
-    // Index 34
-    {"etag", ""},
-    // Index 35
-    {"expect", ""},
-    // Index 36
-    {"expires", ""},
-    // Index 37
-    {"from", ""},
-    // Index 38
-    {"host", ""},
-    // Index 39
-    {"if-match", ""},
-    // Index 40
-    {"if-modified-since", ""},
-    // Index 41
-    {"if-none-match", ""},
-    // Index 42
-    {"if-range", ""},
-    // Index 43
-    {"if-unmodified-since", ""},
-    // Index 44
-    {"last-modified", ""},
-    // Index 45
-    {"link", ""},
-    // Index 46
-    {"location", ""},
-    // Index 47
-    {"max-forwards", ""},
-    // Index 48
-    {"proxy-authenticate", ""},
-    // Index 49
-    {"proxy-authorization", ""},
-    // Index 50
-    {"range", ""},
-    // Index 51
-    {"referer", ""},
-    // Index 52
-    {"refresh", ""},
-    // Index 53
-    {"retry-after", ""},
-    // Index 54
-    {"server", ""},
-    // Index 55
-    {"set-cookie", ""},
-    // Index 56
-    {"strict-transport-security", ""},
-    // Index 57
-    {"transfer-encoding", ""},
-    // Index 58
-    {"user-agent", ""},
-    // Index 59
-    {"vary", ""},
-    // Index 60
-    {"via", ""},
-    // Index 61
-    {"www-authenticate", ""}
-};
-
-const size_t STATIC_TABLE_SIZE = 61;
-
 HeaderField StaticTable::getByIndex(size_t index) {
     if (index < 1 || index > STATIC_TABLE_SIZE) {
         throw std::out_of_range("Static table index out of range: " + std::to_string(index));
     }
     // 数组索引从 0 开始，但 RFC 索引从 1 开始
-    return STATIC_TABLE[index - 1];
+    const auto& entry = STATIC_TABLE[index - 1];
+    return HeaderField{std::string(entry.name), std::string(entry.value)};
 }
 
 int StaticTable::getIndexByNameValue(const std::string& name, const std::string& value) {
@@ -203,7 +88,7 @@ size_t StaticTable::size() {
 // ============================================================================
 
 DynamicTable::DynamicTable(size_t max_size)
-    : max_size_(max_size), current_size_(0) {}
+    : max_size_(max_size), current_size_(0), eviction_count_(0) {}
 
 size_t DynamicTable::calculateEntrySize(const HeaderField& field) {
     // RFC 7541: 大小 = 32 + 名称长度 + 值长度（字节）
@@ -220,6 +105,7 @@ void DynamicTable::insert(const HeaderField& field) {
     
     // 如果条目本身超过最大大小，清空表并丢弃条目
     if (entry_size > max_size_) {
+        eviction_count_ += entries_.size();
         entries_.clear();
         current_size_ = 0;
         return;
@@ -230,6 +116,7 @@ void DynamicTable::insert(const HeaderField& field) {
         size_t removed_size = calculateEntrySize(entries_.back());
         entries_.pop_back();
         current_size_ -= removed_size;
+        ++eviction_count_;
     }
     
     // 从前端插入新条目
@@ -244,6 +131,13 @@ HeaderField DynamicTable::get(size_t index) const {
     return entries_[index];
 }
 
+const HeaderField& DynamicTable::at(size_t index) const {
+    if (index >= entries_.size()) {
+        throw std::out_of_range("Dynamic table index out of range: " + std::to_string(index));
+    }
+    return entries_[index];
+}
+
 int DynamicTable::getIndexByNameValue(const std::string& name, const std::string& value) const {
     std::string lower_name = toLower(name);
     
@@ -283,7 +177,16 @@ void DynamicTable::setMaxSize(size_t size) {
         size_t removed_size = calculateEntrySize(entries_.back());
         entries_.pop_back();
         current_size_ -= removed_size;
+        ++eviction_count_;
+    }
+}
+
+size_t DynamicTable::retainedBytes() const {
+    size_t bytes = entries_.capacity() * sizeof(HeaderField);
+    for (const auto& entry : entries_) {
+        bytes += entry.name.capacity() + entry.value.capacity();
     }
+    return bytes;
 }
 
 size_t DynamicTable::size() const {
@@ -294,12 +197,46 @@ size_t DynamicTable::entryCount() const {
     return entries_.size();
 }
 
+size_t DynamicTable::maxSize() const {
+    return max_size_;
+}
+
+size_t DynamicTable::evictionCount() const {
+    return eviction_count_;
+}
+
+size_t DynamicTable::bytesUntilEviction(size_t index) const {
+    if (index >= entries_.size()) {
+        throw std::out_of_range("Dynamic table index out of range: " + std::to_string(index));
+    }
+    size_t distance = max_size_ - current_size_;
+    for (size_t i = index + 1; i < entries_.size(); ++i) {
+        distance += calculateEntrySize(entries_[i]);
+    }
+    return distance;
+}
+
 // ============================================================================
 // HeaderTable 实现
 // ============================================================================
 
+// 全局版本号计数器，保证不同表实例的版本号也互不相同
+static std::atomic<uint64_t> g_table_version{0};
+
 HeaderTable::HeaderTable(size_t dynamic_table_max_size)
-    : dynamic_table_(dynamic_table_max_size) {}
+    : dynamic_table_(dynamic_table_max_size), version_(++g_table_version) {}
+
+void HeaderTable::bumpVersion() {
+    version_ = ++g_table_version;
+}
+
+uint64_t HeaderTable::version() const {
+    return version_;
+}
+
+const DynamicTable& HeaderTable::dynamicTable() const {
+    return dynamic_table_;
+}
 
 HeaderField HeaderTable::getByIndex(size_t index) const {
     if (index < 1) {
@@ -316,6 +253,18 @@ HeaderField HeaderTable::getByIndex(size_t index) const {
     return dynamic_table_.get(dynamic_index);
 }
 
+std::pair<std::string_view, std::string_view> HeaderTable::viewByIndex(size_t index) const {
+    if (index < 1) {
+        throw std::out_of_range("Header table index must be >= 1");
+    }
+    if (index <= StaticTable::size()) {
+        const auto& entry = STATIC_TABLE[index - 1];
+        return {entry.name, entry.value};
+    }
+    const HeaderField& field = dynamic_table_.at(index - StaticTable::size() - 1);
+    return {field.name, field.value};
+}
+
 int HeaderTable::getIndexByNameValue(const std::string& name, const std::string& value) const {
     // 首先在动态表中查找（动态表优先级更高，因为更新）
     int dynamic_index = dynamic_table_.getIndexByNameValue(name, value);
@@ -342,14 +291,17 @@ int HeaderTable::getIndexByName(const std::string& name) const {
 
 void HeaderTable::insertDynamic(const HeaderField& field) {
     dynamic_table_.insert(field);
+    bumpVersion();
 }
 
 void HeaderTable::setDynamicTableMaxSize(size_t size) {
     dynamic_table_.setMaxSize(size);
+    bumpVersion();
 }
 
 void HeaderTable::clearDynamic() {
     dynamic_table_.clear();
+    bumpVersion();
 }
 
 // ============================================================================
@@ -462,188 +414,480 @@ std::pair<uint64_t, size_t> IntegerEncoder::decodeInteger(
 
 // ============================================================================
 // Huffman Decoding Implementation (RFC 7541 Section 5.2)
+// Code table: HUFFMAN_CODE_TABLE in hpack_tables.h
 // ============================================================================
 
+// Codes up to this length are resolved with a single table lookup
+static constexpr int HUFFMAN_PRIMARY_BITS = 11;
+static constexpr int HUFFMAN_MAX_CODE_BITS = 30;
+
 /**
- * Huffman code table for decoding (RFC 7541 Appendix B)
- * Each symbol (0-255) has a variable-length binary code
- * The table is indexed by symbol number
+ * @brief Lookup tables derived from HUFFMAN_CODE_TABLE
+ *
+ * The RFC 7541 code is canonical: codes of the same length are consecutive.
+ * Short codes come from a direct table indexed by the next 11 bits; longer
+ * codes are found by comparing against the first code of each length.
  */
-struct HuffmanCode {
-    uint32_t code;    // The code bits (right-aligned)
-    uint8_t bits;     // Number of bits (1-30)
+struct HuffmanDecodeTables {
+    struct Entry {
+        uint8_t symbol;
+        uint8_t bits;  // 0 if the code is longer than HUFFMAN_PRIMARY_BITS
+    };
+
+    std::array<Entry, 1u << HUFFMAN_PRIMARY_BITS> primary{};
+    std::array<uint32_t, HUFFMAN_MAX_CODE_BITS + 1> first_code{};
+    std::array<uint32_t, HUFFMAN_MAX_CODE_BITS + 1> code_count{};
+    std::array<uint16_t, HUFFMAN_MAX_CODE_BITS + 1> first_symbol{};
+    std::array<uint8_t, 256> symbols{};  // Sorted by (length, code)
+
+    HuffmanDecodeTables() {
+        size_t next = 0;
+        for (int bits = 1; bits <= HUFFMAN_MAX_CODE_BITS; ++bits) {
+            first_symbol[bits] = static_cast<uint16_t>(next);
+            std::vector<std::pair<uint32_t, uint8_t>> codes;
+            for (int sym = 0; sym < 256; ++sym) {
+                if (HUFFMAN_CODE_TABLE[sym].bits == bits) {
+                    codes.emplace_back(HUFFMAN_CODE_TABLE[sym].code, static_cast<uint8_t>(sym));
+                }
+            }
+            std::sort(codes.begin(), codes.end());
+            first_code[bits] = codes.empty() ? 0 : codes.front().first;
+            code_count[bits] = static_cast<uint32_t>(codes.size());
+            for (const auto& [code, sym] : codes) {
+                symbols[next++] = sym;
+                if (bits <= HUFFMAN_PRIMARY_BITS) {
+                    uint32_t shift = HUFFMAN_PRIMARY_BITS - bits;
+                    for (uint32_t fill = 0; fill < (1u << shift); ++fill) {
+                        primary[(code << shift) | fill] = {sym, static_cast<uint8_t>(bits)};
+                    }
+                }
+            }
+        }
+    }
 };
 
-// Huffman codes from RFC 7541 Appendix B (extracted from nghttp2)
-static const HuffmanCode HUFFMAN_CODE_TABLE[256] = {
-    {0x1ff8, 13}, {0x7fffd8, 23}, {0xfffffe2, 28}, {0xfffffe3, 28},  // Sym 0-3
-    {0xfffffe4, 28}, {0xfffffe5, 28}, {0xfffffe6, 28}, {0xfffffe7, 28},  // Sym 4-7
-    {0xfffffe8, 28}, {0xffffea, 24}, {0x3ffffffc, 30}, {0xfffffe9, 28},  // Sym 8-11
-    {0xfffffea, 28}, {0x3ffffffd, 30}, {0xfffffeb, 28}, {0xfffffec, 28},  // Sym 12-15
-    {0xfffffed, 28}, {0xfffffee, 28}, {0xfffffef, 28}, {0xffffff0, 28},  // Sym 16-19
-    {0xffffff1, 28}, {0xffffff2, 28}, {0x3ffffffe, 30}, {0xffffff3, 28},  // Sym 20-23
-    {0xffffff4, 28}, {0xffffff5, 28}, {0xffffff6, 28}, {0xffffff7, 28},  // Sym 24-27
-    {0xffffff8, 28}, {0xffffff9, 28}, {0xffffffa, 28}, {0xffffffb, 28},  // Sym 28-31
-    {0x14, 6}, {0x3f8, 10}, {0x3f9, 10}, {0xffa, 12},  // Sym 32-35
-    {0x1ff9, 13}, {0x15, 6}, {0xf8, 8}, {0x7fa, 11},  // Sym 36-39
-    {0x3fa, 10}, {0x3fb, 10}, {0xf9, 8}, {0x7fb, 11},  // Sym 40-43
-    {0xfa, 8}, {0x16, 6}, {0x17, 6}, {0x18, 6},  // Sym 44-47
-    {0x0, 5}, {0x1, 5}, {0x2, 5}, {0x19, 6},  // Sym 48-51
-    {0x1a, 6}, {0x1b, 6}, {0x1c, 6}, {0x1d, 6},  // Sym 52-55
-    {0x1e, 6}, {0x1f, 6}, {0x5c, 7}, {0xfb, 8},  // Sym 56-59
-    {0x7ffc, 15}, {0x20, 6}, {0xffb, 12}, {0x3fc, 10},  // Sym 60-63
-    {0x1ffa, 13}, {0x21, 6}, {0x5d, 7}, {0x5e, 7},  // Sym 64-67
-    {0x5f, 7}, {0x60, 7}, {0x61, 7}, {0x62, 7},  // Sym 68-71
-    {0x63, 7}, {0x64, 7}, {0x65, 7}, {0x66, 7},  // Sym 72-75
-    {0x67, 7}, {0x68, 7}, {0x69, 7}, {0x6a, 7},  // Sym 76-79
-    {0x6b, 7}, {0x6c, 7}, {0x6d, 7}, {0x6e, 7},  // Sym 80-83
-    {0x6f, 7}, {0x70, 7}, {0x71, 7}, {0x72, 7},  // Sym 84-87
-    {0xfc, 8}, {0x73, 7}, {0xfd, 8}, {0x1ffb, 13},  // Sym 88-91
-    {0x7fff0, 19}, {0x1ffc, 13}, {0x3ffc, 14}, {0x22, 6},  // Sym 92-95
-    {0x7ffd, 15}, {0x3, 5}, {0x23, 6}, {0x4, 5},  // Sym 96-99
-    {0x24, 6}, {0x5, 5}, {0x25, 6}, {0x26, 6},  // Sym 100-103
-    {0x27, 6}, {0x6, 5}, {0x74, 7}, {0x75, 7},  // Sym 104-107
-    {0x28, 6}, {0x29, 6}, {0x2a, 6}, {0x7, 5},  // Sym 108-111
-    {0x2b, 6}, {0x76, 7}, {0x2c, 6}, {0x8, 5},  // Sym 112-115
-    {0x9, 5}, {0x2d, 6}, {0x77, 7}, {0x78, 7},  // Sym 116-119
-    {0x79, 7}, {0x7a, 7}, {0x7b, 7}, {0x7ffe, 15},  // Sym 120-123
-    {0x7fc, 11}, {0x3ffd, 14}, {0x1ffd, 13}, {0xffffffc, 28},  // Sym 124-127
-    {0xfffe6, 20}, {0x3fffd2, 22}, {0xfffe7, 20}, {0xfffe8, 20},  // Sym 128-131
-    {0x3fffd3, 22}, {0x3fffd4, 22}, {0x3fffd5, 22}, {0x7fffd9, 23},  // Sym 132-135
-    {0x3fffd6, 22}, {0x7fffda, 23}, {0x7fffdb, 23}, {0x7fffdc, 23},  // Sym 136-139
-    {0x7fffdd, 23}, {0x7fffde, 23}, {0xffffeb, 24}, {0x7fffdf, 23},  // Sym 140-143
-    {0xffffec, 24}, {0xffffed, 24}, {0x3fffd7, 22}, {0x7fffe0, 23},  // Sym 144-147
-    {0xffffee, 24}, {0x7fffe1, 23}, {0x7fffe2, 23}, {0x7fffe3, 23},  // Sym 148-151
-    {0x7fffe4, 23}, {0x1fffdc, 21}, {0x3fffd8, 22}, {0x7fffe5, 23},  // Sym 152-155
-    {0x3fffd9, 22}, {0x7fffe6, 23}, {0x7fffe7, 23}, {0xffffef, 24},  // Sym 156-159
-    {0x3fffda, 22}, {0x1fffdd, 21}, {0xfffe9, 20}, {0x3fffdb, 22},  // Sym 160-163
-    {0x3fffdc, 22}, {0x7fffe8, 23}, {0x7fffe9, 23}, {0x1fffde, 21},  // Sym 164-167
-    {0x7fffea, 23}, {0x3fffdd, 22}, {0x3fffde, 22}, {0xfffff0, 24},  // Sym 168-171
-    {0x1fffdf, 21}, {0x3fffdf, 22}, {0x7fffeb, 23}, {0x7fffec, 23},  // Sym 172-175
-    {0x1fffe0, 21}, {0x1fffe1, 21}, {0x3fffe0, 22}, {0x1fffe2, 21},  // Sym 176-179
-    {0x7fffed, 23}, {0x3fffe1, 22}, {0x7fffee, 23}, {0x7fffef, 23},  // Sym 180-183
-    {0xfffea, 20}, {0x3fffe2, 22}, {0x3fffe3, 22}, {0x3fffe4, 22},  // Sym 184-187
-    {0x7ffff0, 23}, {0x3fffe5, 22}, {0x3fffe6, 22}, {0x7ffff1, 23},  // Sym 188-191
-    {0x3ffffe0, 26}, {0x3ffffe1, 26}, {0xfffeb, 20}, {0x7fff1, 19},  // Sym 192-195
-    {0x3fffe7, 22}, {0x7ffff2, 23}, {0x3fffe8, 22}, {0x1ffffec, 25},  // Sym 196-199
-    {0x3ffffe2, 26}, {0x3ffffe3, 26}, {0x3ffffe4, 26}, {0x7ffffde, 27},  // Sym 200-203
-    {0x7ffffdf, 27}, {0x3ffffe5, 26}, {0xfffff1, 24}, {0x1ffffed, 25},  // Sym 204-207
-    {0x7fff2, 19}, {0x1fffe3, 21}, {0x3ffffe6, 26}, {0x7ffffe0, 27},  // Sym 208-211
-    {0x7ffffe1, 27}, {0x3ffffe7, 26}, {0x7ffffe2, 27}, {0xfffff2, 24},  // Sym 212-215
-    {0x1fffe4, 21}, {0x1fffe5, 21}, {0x3ffffe8, 26}, {0x3ffffe9, 26},  // Sym 216-219
-    {0xffffffd, 28}, {0x7ffffe3, 27}, {0x7ffffe4, 27}, {0x7ffffe5, 27},  // Sym 220-223
-    {0xfffec, 20}, {0xfffff3, 24}, {0xfffed, 20}, {0x1fffe6, 21},  // Sym 224-227
-    {0x3fffe9, 22}, {0x1fffe7, 21}, {0x1fffe8, 21}, {0x7ffff3, 23},  // Sym 228-231
-    {0x3fffea, 22}, {0x3fffeb, 22}, {0x1ffffee, 25}, {0x1ffffef, 25},  // Sym 232-235
-    {0xfffff4, 24}, {0xfffff5, 24}, {0x3ffffea, 26}, {0x7ffff4, 23},  // Sym 236-239
-    {0x3ffffeb, 26}, {0x7ffffe6, 27}, {0x3ffffec, 26}, {0x3ffffed, 26},  // Sym 240-243
-    {0x7ffffe7, 27}, {0x7ffffe8, 27}, {0x7ffffe9, 27}, {0x7ffffea, 27},  // Sym 244-247
-    {0x7ffffeb, 27}, {0xffffffe, 28}, {0x7ffffec, 27}, {0x7ffffed, 27},  // Sym 248-251
-    {0x7ffffee, 27}, {0x7ffffef, 27}, {0x7fffff0, 27}, {0x3ffffee, 26}   // Sym 252-255
+static const HuffmanDecodeTables& huffmanDecodeTables() {
+    static const HuffmanDecodeTables tables;
+    return tables;
+}
+
+static inline uint64_t loadBigEndian64(const uint8_t* data) {
+    uint64_t word;
+    std::memcpy(&word, data, sizeof(word));
+#if defined(__GNUC__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    return __builtin_bswap64(word);
+#else
+    word = 0;
+    for (int i = 0; i < 8; ++i) {
+        word = (word << 8) | data[i];
+    }
+    return word;
+#endif
+}
+
+/**
+ * @brief Decoding state of one Huffman string
+ * Pending bits are kept left-aligned in a 64-bit buffer; symbols are written
+ * through dst into an output string presized for the worst case (5-bit codes)
+ */
+struct HuffmanLane {
+    const uint8_t* next;
+    const uint8_t* end;
+    uint64_t bits;
+    int count;
+    char* dst;
+    std::string* out;
+
+    void start(const uint8_t* data, size_t length, std::string& result) {
+        next = data;
+        end = data + length;
+        bits = 0;
+        count = 0;
+        out = &result;
+        result.resize(length * 8 / 5);
+        dst = result.data();
+    }
+
+    void finish() {
+        out->resize(static_cast<size_t>(dst - out->data()));
+    }
 };
 
+/**
+ * @brief Decode one symbol from a lane
+ * Once the input is exhausted, missing bits read as 1s: a code that runs
+ * into them is the EOS padding and ends the string
+ *
+ * @return false when the lane has finished
+ */
+static inline bool huffmanStep(const HuffmanDecodeTables& tables, HuffmanLane& lane) {
+    if (lane.count < HUFFMAN_MAX_CODE_BITS) {
+        if (lane.end - lane.next >= 8) {
+            // Refill whole bytes from one big-endian 64-bit load
+            uint64_t word = loadBigEndian64(lane.next);
+            int take = (64 - lane.count) >> 3;
+            int filled = lane.count + take * 8;
+            lane.bits |= (word >> lane.count) & (filled >= 64 ? ~0ULL : ~(~0ULL >> filled));
+            lane.next += take;
+            lane.count = filled;
+        } else {
+            while (lane.count <= 56 && lane.next < lane.end) {
+                lane.bits |= static_cast<uint64_t>(*lane.next++) << (56 - lane.count);
+                lane.count += 8;
+            }
+            if (lane.count == 0) {
+                return false;
+            }
+        }
+    }
+
+    uint64_t peek = lane.bits | (lane.count >= 64 ? 0 : (~0ULL >> lane.count));
+    const HuffmanDecodeTables::Entry& entry = tables.primary[peek >> (64 - HUFFMAN_PRIMARY_BITS)];
+    int bits = entry.bits;
+    uint8_t symbol = entry.symbol;
+    if (bits == 0) {
+        for (bits = HUFFMAN_PRIMARY_BITS + 1; bits <= HUFFMAN_MAX_CODE_BITS; ++bits) {
+            uint32_t offset = static_cast<uint32_t>(peek >> (64 - bits)) - tables.first_code[bits];
+            if (offset < tables.code_count[bits]) {
+                symbol = tables.symbols[tables.first_symbol[bits] + offset];
+                break;
+            }
+        }
+        if (bits > HUFFMAN_MAX_CODE_BITS) {
+            // EOS or invalid code: stop like the padding case
+            return false;
+        }
+    }
+    if (bits > lane.count) {
+        // Padding (most significant bits of EOS)
+        return false;
+    }
+
+    *lane.dst++ = static_cast<char>(symbol);
+    lane.bits <<= bits;
+    lane.count -= bits;
+    return true;
+}
+
 /**
  * @brief Decode a Huffman-encoded byte string using RFC 7541 Appendix B
- * Uses a linear search decoder optimized for correctness
  *
  * @param data Pointer to Huffman-encoded data
  * @param length Length of encoded data in bytes
  * @return Decoded string
  */
 static std::string huffmanDecode(const uint8_t* data, size_t length) {
-    if (length == 0) {
-        return "";
-    }
-
     std::string result;
-    result.reserve(length * 2);
-
-    uint64_t bit_buffer = 0;
-    int bits_in_buffer = 0;
-    size_t byte_idx = 0;
+    HuffmanLane lane;
+    lane.start(data, length, result);
+    const HuffmanDecodeTables& tables = huffmanDecodeTables();
+    while (huffmanStep(tables, lane)) {
+    }
+    lane.finish();
+    return result;
+}
 
-    // Main decode loop - continue while we have data or enough bits to decode
-    while (byte_idx < length || bits_in_buffer >= 5) {
-        // Load more bytes into buffer if needed (up to 30 bits for longest code)
-        while (bits_in_buffer < 30 && byte_idx < length) {
-            bit_buffer = (bit_buffer << 8) | data[byte_idx++];
-            bits_in_buffer += 8;
+// Number of strings decoded concurrently by decodeHuffmanBatch
+static constexpr size_t HUFFMAN_LANES = 4;
+
+void StringCoder::decodeHuffmanBatch(const HuffmanSpan* spans, size_t count, std::string* out) {
+    const HuffmanDecodeTables& tables = huffmanDecodeTables();
+    HuffmanCache& cache = HuffmanCache::decodeCache();
+
+    // Cached strings are resolved up front; only misses go through the lanes
+    std::vector<size_t> pending;
+    pending.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        out[i].clear();
+        if (spans[i].length >= HuffmanCache::MIN_CACHED_LENGTH) {
+            std::string_view key(reinterpret_cast<const char*>(spans[i].data), spans[i].length);
+            if (const std::string* cached = cache.find(key)) {
+                out[i] = *cached;
+                continue;
+            }
         }
+        pending.push_back(i);
+    }
 
-        // Try to decode a symbol from the buffer
-        bool found = false;
-
-        // Try all possible symbols
-        for (int sym = 0; sym < 256; ++sym) {
-            uint8_t code_len = HUFFMAN_CODE_TABLE[sym].bits;
-            uint32_t code = HUFFMAN_CODE_TABLE[sym].code;
-
-            // Check if we have enough bits
-            if (bits_in_buffer < code_len) {
+    size_t next = 0;
+    auto load = [&](HuffmanLane& lane) {
+        if (next == pending.size()) {
+            return false;
+        }
+        const HuffmanSpan& span = spans[pending[next]];
+        lane.start(span.data, span.length, out[pending[next]]);
+        ++next;
+        return true;
+    };
+    auto drain = [&](HuffmanLane& lane) {
+        while (huffmanStep(tables, lane)) {
+        }
+        lane.finish();
+    };
+
+    if (pending.size() >= HUFFMAN_LANES) {
+        // Independent strings advance in lockstep so the table lookups of one
+        // lane overlap the others. The lanes are separate locals rather than
+        // an array so they stay in registers across the output stores.
+        HuffmanLane lane0, lane1, lane2, lane3;
+        load(lane0);
+        load(lane1);
+        load(lane2);
+        load(lane3);
+        auto retire = [&](HuffmanLane& lane, bool stepped) {
+            if (stepped) {
+                return true;
+            }
+            lane.finish();
+            return load(lane);
+        };
+        while (true) {
+            bool stepped0 = huffmanStep(tables, lane0);
+            bool stepped1 = huffmanStep(tables, lane1);
+            bool stepped2 = huffmanStep(tables, lane2);
+            bool stepped3 = huffmanStep(tables, lane3);
+            if (stepped0 && stepped1 && stepped2 && stepped3) {
                 continue;
             }
-
-            // Extract the top code_len bits from buffer
-            uint64_t test_code = bit_buffer >> (bits_in_buffer - code_len);
-            test_code &= ((1ULL << code_len) - 1);
-
-            // Check if it matches
-            if (test_code == code) {
-                result += static_cast<char>(sym);
-                bits_in_buffer -= code_len;
-                // Keep only the remaining bits
-                bit_buffer &= ((1ULL << bits_in_buffer) - 1);
-                found = true;
-                break;
+            bool live0 = retire(lane0, stepped0);
+            bool live1 = retire(lane1, stepped1);
+            bool live2 = retire(lane2, stepped2);
+            bool live3 = retire(lane3, stepped3);
+            if (live0 && live1 && live2 && live3) {
+                continue;
             }
+            // Pending list exhausted: finish the remaining lanes one at a time
+            if (live0) drain(lane0);
+            if (live1) drain(lane1);
+            if (live2) drain(lane2);
+            if (live3) drain(lane3);
+            break;
         }
+    }
 
-        if (!found) {
-            // No valid code found - remaining bits should be padding (all 1s)
-            // According to RFC 7541, padding consists of the most significant
-            // bits of the EOS symbol (which is all 1s)
-            break;
+    HuffmanLane lane;
+    while (load(lane)) {
+        drain(lane);
+    }
+
+    for (size_t i : pending) {
+        if (spans[i].length >= HuffmanCache::MIN_CACHED_LENGTH) {
+            cache.insert(std::string_view(reinterpret_cast<const char*>(spans[i].data),
+                                          spans[i].length),
+                         out[i]);
         }
     }
+}
 
-    return result;
+/**
+ * @brief Huffman-encode a string using RFC 7541 Appendix B
+ * The last byte is padded with the most significant bits of EOS (all 1s)
+ *
+ * @param str Raw string
+ * @param out Output container (appended to)
+ */
+template <typename Output>
+static void huffmanEncode(std::string_view str, Output& out) {
+    uint64_t bit_buffer = 0;
+    int bits_in_buffer = 0;
+    for (char c : str) {
+        const HuffmanCode& code = HUFFMAN_CODE_TABLE[static_cast<uint8_t>(c)];
+        bit_buffer = (bit_buffer << code.bits) | code.code;
+        bits_in_buffer += code.bits;
+        while (bits_in_buffer >= 8) {
+            bits_in_buffer -= 8;
+            out.push_back(static_cast<typename Output::value_type>(bit_buffer >> bits_in_buffer));
+        }
+        bit_buffer &= (1ULL << bits_in_buffer) - 1;
+    }
+    if (bits_in_buffer > 0) {
+        out.push_back(static_cast<typename Output::value_type>(
+            (bit_buffer << (8 - bits_in_buffer)) | (0xFF >> bits_in_buffer)));
+    }
 }
 
 // ============================================================================
-// StringCoder Implementation
+// Huffman Length Estimation
 // ============================================================================
 
-std::vector<uint8_t> StringCoder::encodeString(const std::string& str, bool use_huffman) {
-    // Check for Huffman encoding
-    if (use_huffman) {
-        throw std::runtime_error("Huffman encoding is not yet implemented");
+// Code length in bits for each symbol, widened to 32 bits for gathers
+static constexpr std::array<uint32_t, 256> HUFFMAN_BITS = [] {
+    std::array<uint32_t, 256> bits{};
+    for (size_t i = 0; i < bits.size(); ++i) {
+        bits[i] = HUFFMAN_CODE_TABLE[i].bits;
     }
+    return bits;
+}();
 
-    // Literal string encoding (H bit = 0)
-    // First byte: bit 7 = 0 (H flag), bits 0-6 = length or length prefix
-    std::vector<uint8_t> result;
-    uint64_t length = str.length();
+/**
+ * @brief Sum code lengths with four independent accumulators
+ */
+static uint64_t huffmanBitsScalar(const uint8_t* data, size_t length) {
+    uint64_t acc0 = 0, acc1 = 0, acc2 = 0, acc3 = 0;
+    size_t i = 0;
+    for (; i + 4 <= length; i += 4) {
+        acc0 += HUFFMAN_BITS[data[i]];
+        acc1 += HUFFMAN_BITS[data[i + 1]];
+        acc2 += HUFFMAN_BITS[data[i + 2]];
+        acc3 += HUFFMAN_BITS[data[i + 3]];
+    }
+    for (; i < length; ++i) {
+        acc0 += HUFFMAN_BITS[data[i]];
+    }
+    return acc0 + acc1 + acc2 + acc3;
+}
 
-    // Encode length using 7-bit prefix
-    if (length < 127) {
-        // Length fits in 7 bits
-        result.push_back(static_cast<uint8_t>(length));
+#if HTTP2_HPACK_HAVE_AVX2
+/**
+ * @brief Sum code lengths 8 bytes at a time with AVX2 gathers
+ * Each 32-bit lane holds at most 30 bits per symbol, so the lanes cannot
+ * overflow for strings shorter than 1 GiB
+ */
+__attribute__((target("avx2")))
+static uint64_t huffmanBitsAvx2(const uint8_t* data, size_t length) {
+    const int* table = reinterpret_cast<const int*>(HUFFMAN_BITS.data());
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(data + i));
+        __m256i symbols = _mm256_cvtepu8_epi32(bytes);
+        acc = _mm256_add_epi32(acc, _mm256_i32gather_epi32(table, symbols, 4));
+    }
+
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    uint64_t bits = static_cast<uint32_t>(_mm_cvtsi128_si32(sum));
+    return bits + huffmanBitsScalar(data + i, length - i);
+}
+#endif
+
+size_t StringCoder::huffmanEncodedLength(std::string_view str) {
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(str.data());
+    uint64_t bits;
+#if HTTP2_HPACK_HAVE_AVX2
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    if (has_avx2 && str.size() >= 16) {
+        bits = huffmanBitsAvx2(data, str.size());
     } else {
-        // Length doesn't fit in 7 bits, use continuation bytes
-        result.push_back(127); // 7 bits all set to 1
+        bits = huffmanBitsScalar(data, str.size());
+    }
+#else
+    bits = huffmanBitsScalar(data, str.size());
+#endif
+    return static_cast<size_t>((bits + 7) / 8);
+}
 
-        // Encode remaining length using continuation bytes
-        uint64_t remaining = length - 127;
-        while (remaining >= 128) {
-            result.push_back(static_cast<uint8_t>((remaining & 0x7F) | 0x80));
-            remaining >>= 7;
-        }
-        result.push_back(static_cast<uint8_t>(remaining & 0x7F));
+/**
+ * @brief 以 N 位前缀编码整数并直接追加到输出缓冲区
+ * @param flags 首字节中前缀以外的表示类型标志位
+ */
+static void appendInteger(std::vector<uint8_t>& out, uint64_t value, int prefix_bits, uint8_t flags) {
+    uint64_t max_prefix = (1ULL << prefix_bits) - 1;
+    if (value < max_prefix) {
+        out.push_back(static_cast<uint8_t>(flags | value));
+        return;
+    }
+    out.push_back(static_cast<uint8_t>(flags | max_prefix));
+    value -= max_prefix;
+    while (value >= 128) {
+        out.push_back(static_cast<uint8_t>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+// ============================================================================
+// HuffmanCache Implementation
+// ============================================================================
+
+HuffmanCache::HuffmanCache(size_t capacity, size_t max_entry_size)
+    : capacity_(capacity), max_entry_size_(max_entry_size) {}
+
+const std::string* HuffmanCache::find(std::string_view key) {
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        ++stats_.misses;
+        return nullptr;
+    }
+    ++stats_.hits;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return &it->second->value;
+}
+
+void HuffmanCache::insert(std::string_view key, std::string value) {
+    if (capacity_ == 0 || key.size() > max_entry_size_ || index_.count(key) != 0) {
+        return;
+    }
+    entries_.push_front(Entry{std::string(key), std::move(value)});
+    index_.emplace(entries_.front().key, entries_.begin());
+    evictOverflow();
+}
+
+void HuffmanCache::clear() {
+    index_.clear();
+    entries_.clear();
+}
+
+void HuffmanCache::setCapacity(size_t capacity) {
+    capacity_ = capacity;
+    evictOverflow();
+}
+
+void HuffmanCache::evictOverflow() {
+    while (entries_.size() > capacity_) {
+        index_.erase(entries_.back().key);
+        entries_.pop_back();
+    }
+}
+
+HuffmanCache& HuffmanCache::decodeCache() {
+    static thread_local HuffmanCache cache;
+    return cache;
+}
+
+HuffmanCache& HuffmanCache::encodeCache() {
+    static thread_local HuffmanCache cache;
+    return cache;
+}
+
+// ============================================================================
+// StringCoder Implementation
+// ============================================================================
+
+/**
+ * @brief Append the Huffman coding of a string
+ * Strings of at least MIN_CACHED_LENGTH bytes go through the per-thread cache
+ */
+static void appendHuffman(std::vector<uint8_t>& out, const std::string& str) {
+    if (str.size() < HuffmanCache::MIN_CACHED_LENGTH) {
+        huffmanEncode(str, out);
+        return;
     }
 
-    // Append string data (literal octets)
-    result.insert(result.end(), str.begin(), str.end());
+    HuffmanCache& cache = HuffmanCache::encodeCache();
+    if (const std::string* cached = cache.find(str)) {
+        out.insert(out.end(), cached->begin(), cached->end());
+        return;
+    }
+    size_t start = out.size();
+    huffmanEncode(str, out);
+    cache.insert(str, std::string(out.begin() + start, out.end()));
+}
 
+std::vector<uint8_t> StringCoder::encodeString(const std::string& str, bool use_huffman) {
+    // First byte: bit 7 = H flag, bits 0-6 = length or length prefix
+    std::vector<uint8_t> result;
+    if (use_huffman) {
+        size_t length = huffmanEncodedLength(str);
+        result.reserve(length + 10);
+        appendInteger(result, length, 7, 0x80);
+        appendHuffman(result, str);
+    } else {
+        result.reserve(str.size() + 10);
+        appendInteger(result, str.size(), 7, 0x00);
+        result.insert(result.end(), str.begin(), str.end());
+    }
     return result;
 }
 
@@ -700,9 +944,20 @@ std::pair<std::string, size_t> StringCoder::decodeString(
     std::string result;
     
     if (huffman) {
-        // Huffman-encoded string
+        // Huffman-encoded string; repeated long literals come from the cache
         try {
-            result = huffmanDecode(data + bytes_consumed, len);
+            if (len >= HuffmanCache::MIN_CACHED_LENGTH) {
+                std::string_view key(reinterpret_cast<const char*>(data + bytes_consumed), len);
+                HuffmanCache& cache = HuffmanCache::decodeCache();
+                if (const std::string* cached = cache.find(key)) {
+                    result = *cached;
+                } else {
+                    result = huffmanDecode(data + bytes_consumed, len);
+                    cache.insert(key, result);
+                }
+            } else {
+                result = huffmanDecode(data + bytes_consumed, len);
+            }
         } catch (const std::exception& e) {
             std::cerr << "Huffman decoding failed: " << e.what() << std::endl;
             throw;
@@ -720,12 +975,8 @@ std::pair<std::string, size_t> StringCoder::decodeString(
 // HPACK Implementation (High-level API)
 // ============================================================================
 
-// ============================================================================
-// HPACK Implementation (High-level API)
-// ============================================================================
-
-// Static instance of HeaderTable for stateful decoding/encoding
-static thread_local HeaderTable g_header_table(4096);
+// Static decoder instance for stateful decoding through the HPACK facade
+static thread_local HpackDecoder g_decoder(4096);
 
 std::vector<uint8_t> HPACK::encode(
     const std::vector<std::pair<std::string, std::string>>& headers) {
@@ -753,25 +1004,932 @@ std::vector<std::pair<std::string, std::string>> HPACK::decode(
     const std::vector<uint8_t>& buffer) {
     std::vector<std::pair<std::string, std::string>> headers;
 
-    if (buffer.empty()) {
-        return headers;
+    decode(buffer.data(), buffer.size(),
+           [&headers](const std::string& name, const std::string& value) {
+               headers.emplace_back(name, value);
+           });
+
+    return headers;
+}
+
+void HPACK::decode(const uint8_t* data, size_t length, const HeaderCallback& on_header) {
+    g_decoder.decode(data, length, on_header);
+}
+
+// ============================================================================
+// IndexingPolicy Implementation
+// ============================================================================
+
+// 统计样本不足时默认索引
+static const uint32_t MIN_NAME_SAMPLES = 4;
+
+// 认为条目“即将被淘汰”的距离：动态表大小的 1/8
+static const size_t DRAINING_FRACTION = 8;
+
+// 短于此长度的敏感值熵较低，可能被逐字节猜测（RFC 7541 7.1.3）
+static const size_t LOW_ENTROPY_VALUE_LENGTH = 20;
+
+static bool isCredentialHeader(const std::string& name) {
+    return name == "authorization" || name == "proxy-authorization";
+}
+
+IndexingPolicy::IndexingPolicy(size_t window)
+    : window_(window == 0 ? 1 : window), tick_(0), window_evicted_bytes_(0),
+      never_index_credentials_(false) {}
+
+void IndexingPolicy::setNeverIndexCredentials(bool enabled) {
+    never_index_credentials_ = enabled;
+}
+
+void IndexingPolicy::reset() {
+    tick_ = 0;
+    window_evicted_bytes_ = 0;
+    names_.clear();
+    recent_fields_.clear();
+}
+
+IndexingPolicy::Decision IndexingPolicy::decide(const std::string& name, const std::string& value,
+                                                int index, const HeaderTable& table) {
+    ++tick_;
+    size_t key = std::hash<std::string>()(name) * 31 + std::hash<std::string>()(value);
+    auto recent = recent_fields_.find(key);
+    bool seen_recently = recent != recent_fields_.end() && tick_ - recent->second <= window_;
+    recent_fields_[key] = tick_;
+
+    NameStats& stats = names_[name];
+    ++stats.occurrences;
+    if (seen_recently) {
+        ++stats.repeats;
+    }
+    if (tick_ % window_ == 0) {
+        decay();
+    }
+
+    // 低熵的敏感值不索引；长令牌难以猜测，除非要求凭据一律不索引
+    bool credential = isCredentialHeader(name);
+    if (credential && never_index_credentials_) {
+        return Decision::NEVER_INDEXED;
+    }
+    if ((credential || name == "cookie") && value.size() < LOW_ENTROPY_VALUE_LENGTH) {
+        return Decision::NEVER_INDEXED;
+    }
+
+    const DynamicTable& dynamic_table = table.dynamicTable();
+    if (index > 0) {
+        size_t static_size = StaticTable::size();
+        if (static_cast<size_t>(index) > static_size && seen_recently) {
+            // 常用条目即将被淘汰：重新插入新副本，后续请求仍可引用
+            size_t distance = dynamic_table.bytesUntilEviction(index - static_size - 1);
+            if (distance < dynamic_table.maxSize() / DRAINING_FRACTION) {
+                return Decision::INCREMENTAL;
+            }
+        }
+        return Decision::INDEXED;
+    }
+
+    size_t entry_size = 32 + name.size() + value.size();
+    if (entry_size > dynamic_table.maxSize()) {
+        return Decision::WITHOUT_INDEXING;
+    }
+
+    // 一次性的值：名称出现多次但值几乎从不重复。
+    // 表中没有可引用的名称时仍插入一次，之后的字面量可以用名称索引
+    bool name_indexed = table.getIndexByName(name) > 0;
+    if (stats.occurrences >= MIN_NAME_SAMPLES && stats.repeats * 4 < stats.occurrences) {
+        return name_indexed ? Decision::WITHOUT_INDEXING : Decision::INCREMENTAL;
+    }
+
+    // 淘汰频繁时只为已经重复出现过的名值对付出插入代价
+    if (highChurn(dynamic_table.maxSize()) && !seen_recently) {
+        return Decision::WITHOUT_INDEXING;
     }
 
+    return Decision::INCREMENTAL;
+}
+
+void IndexingPolicy::recordInsertion(size_t evicted_bytes) {
+    window_evicted_bytes_ += evicted_bytes;
+}
+
+bool IndexingPolicy::highChurn(size_t table_max_size) const {
+    return window_evicted_bytes_ > table_max_size;
+}
+
+void IndexingPolicy::decay() {
+    window_evicted_bytes_ /= 2;
+
+    for (auto it = names_.begin(); it != names_.end();) {
+        it->second.occurrences /= 2;
+        it->second.repeats /= 2;
+        if (it->second.occurrences == 0) {
+            it = names_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (auto it = recent_fields_.begin(); it != recent_fields_.end();) {
+        if (tick_ - it->second > window_) {
+            it = recent_fields_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+// ============================================================================
+// HpackEncoder Implementation
+// ============================================================================
+
+/**
+ * @brief 编码字符串并直接追加到输出缓冲区
+ * Huffman 编码更短时设置 H 标志；长度由 huffmanEncodedLength 预先算出，
+ * 不需要试编码，输出缓冲区也按最终大小一次预留
+ */
+static void appendString(std::vector<uint8_t>& out, const std::string& str) {
+    size_t huffman_length = StringCoder::huffmanEncodedLength(str);
+    bool use_huffman = huffman_length < str.size();
+    size_t payload_length = use_huffman ? huffman_length : str.size();
+
+    out.reserve(out.size() + payload_length + 10);
+    appendInteger(out, payload_length, 7, use_huffman ? 0x80 : 0x00);
+    if (use_huffman) {
+        appendHuffman(out, str);
+    } else {
+        out.insert(out.end(), str.begin(), str.end());
+    }
+}
+
+HpackEncoder::HpackEncoder(size_t max_table_size, Mode mode)
+    : table_(max_table_size), crumble_cookies_(true), mode_(mode),
+      adaptive_indexing_(false), initial_table_size_(max_table_size),
+      max_table_size_(max_table_size),
+      min_pending_size_(max_table_size), size_update_pending_(false) {}
+
+std::vector<uint8_t> HpackEncoder::encode(
+    const std::vector<std::pair<std::string, std::string>>& headers) {
+    std::vector<uint8_t> buffer;
+    encode(headers, buffer);
+    return buffer;
+}
+
+void HpackEncoder::encode(const std::vector<std::pair<std::string, std::string>>& headers,
+                          std::vector<uint8_t>& out) {
+    beginBlock(out);
+    encodeFields(headers, out);
+}
+
+void HpackEncoder::encodeFields(const std::vector<std::pair<std::string, std::string>>& headers,
+                                std::vector<uint8_t>& out) {
+    for (const auto& [name, value] : headers) {
+        // 无状态模式下 crumb 不会被索引，拆分只会增加字节数
+        if (crumble_cookies_ && mode_ == Mode::STATEFUL && name == "cookie") {
+            encodeCookie(value, out);
+        } else {
+            encodeField(name, value, out);
+        }
+    }
+    governor_link_.sync(table_.dynamicTable().size());
+}
+
+void HpackEncoder::encodeField(const std::string& name, const std::string& value,
+                               std::vector<uint8_t>& out) {
+    if (mode_ == Mode::STATELESS) {
+        encodeStatelessField(name, value, out);
+        return;
+    }
+
+    int index = table_.getIndexByNameValue(name, value);
+    IndexingPolicy::Decision decision;
+    if (adaptive_indexing_) {
+        decision = policy_.decide(name, value, index, table_);
+    } else {
+        decision = index > 0 ? IndexingPolicy::Decision::INDEXED
+                             : IndexingPolicy::Decision::INCREMENTAL;
+    }
+
+    // 名值完全匹配：Indexed Header Field (1xxxxxxx)
+    if (decision == IndexingPolicy::Decision::INDEXED) {
+        appendInteger(out, static_cast<uint64_t>(index), 7, 0x80);
+        return;
+    }
+
+    // 字面量：01xxxxxx（增量索引）、0000xxxx（不索引）、0001xxxx（永不索引）
+    int name_index = index > 0 ? index : table_.getIndexByName(name);
+    int prefix_bits = 4;
+    uint8_t flags = 0x00;
+    if (decision == IndexingPolicy::Decision::INCREMENTAL) {
+        prefix_bits = 6;
+        flags = 0x40;
+    } else if (decision == IndexingPolicy::Decision::NEVER_INDEXED) {
+        flags = 0x10;
+    }
+
+    if (name_index > 0) {
+        appendInteger(out, static_cast<uint64_t>(name_index), prefix_bits, flags);
+    } else {
+        out.push_back(flags);
+        appendString(out, name);
+    }
+    appendString(out, value);
+
+    if (decision == IndexingPolicy::Decision::INCREMENTAL) {
+        const DynamicTable& dynamic_table = table_.dynamicTable();
+        size_t before = dynamic_table.size();
+        table_.insertDynamic({name, value});
+        if (adaptive_indexing_) {
+            size_t entry_size = 32 + name.size() + value.size();
+            size_t after = dynamic_table.size();
+            policy_.recordInsertion(before + entry_size > after ? before + entry_size - after : 0);
+        }
+    }
+}
+
+void HpackEncoder::encodeFieldWithoutIndexing(const std::string& name, const std::string& value,
+                                              std::vector<uint8_t>& out) {
+    if (mode_ == Mode::STATELESS) {
+        encodeStatelessField(name, value, out);
+        return;
+    }
+
+    int index = table_.getIndexByNameValue(name, value);
+    if (index > 0) {
+        appendInteger(out, static_cast<uint64_t>(index), 7, 0x80);
+        return;
+    }
+
+    // Literal Header Field without Indexing (0000xxxx)
+    int name_index = table_.getIndexByName(name);
+    if (name_index > 0) {
+        appendInteger(out, static_cast<uint64_t>(name_index), 4, 0x00);
+    } else {
+        out.push_back(0x00);
+        appendString(out, name);
+    }
+    appendString(out, value);
+}
+
+void HpackEncoder::encodeCookie(const std::string& value, std::vector<uint8_t>& out) {
+    // RFC 9113 8.2.3：按 "; " 拆分为独立的 crumb，未变化的 crumb 可命中动态表
+    if (value.find(';') == std::string::npos) {
+        encodeField("cookie", value, out);
+        return;
+    }
+
+    size_t start = 0;
+    while (start <= value.size()) {
+        size_t end = value.find(';', start);
+        if (end == std::string::npos) {
+            end = value.size();
+        }
+        if (end > start) {
+            encodeField("cookie", value.substr(start, end - start), out);
+        }
+        start = end + 1;
+        while (start < value.size() && value[start] == ' ') {
+            ++start;
+        }
+    }
+}
+
+void HpackEncoder::encodeStatelessField(const std::string& name, const std::string& value,
+                                        std::vector<uint8_t>& out) {
+    // 只引用静态表：静态索引对所有连接都相同
+    int index = StaticTable::getIndexByNameValue(name, value);
+    if (index > 0) {
+        appendInteger(out, static_cast<uint64_t>(index), 7, 0x80);
+        return;
+    }
+
+    int name_index = StaticTable::getIndexByName(name);
+    if (name_index > 0) {
+        appendInteger(out, static_cast<uint64_t>(name_index), 4, 0x00);
+    } else {
+        out.push_back(0x00);
+        appendString(out, name);
+    }
+    appendString(out, value);
+}
+
+void HpackEncoder::setCookieCrumbling(bool enabled) {
+    crumble_cookies_ = enabled;
+}
+
+HpackEncoder::Mode HpackEncoder::mode() const {
+    return mode_;
+}
+
+void HpackEncoder::setAdaptiveIndexing(bool enabled) {
+    adaptive_indexing_ = enabled;
+}
+
+void HpackEncoder::setNeverIndexCredentials(bool enabled) {
+    policy_.setNeverIndexCredentials(enabled);
+}
+
+void HpackEncoder::setMaxTableSize(size_t size) {
+    max_table_size_ = size;
+    size_t limit = governor_link_.governor() ? governor_link_.governor()->tableSizeLimit()
+                                             : std::numeric_limits<size_t>::max();
+    applyTableSize(std::min(max_table_size_, limit));
+}
+
+void HpackEncoder::setMemoryGovernor(HpackMemoryGovernor* governor) {
+    governor_link_.reset();
+    if (governor != nullptr) {
+        governor_link_.attach(governor, true);
+    }
+}
+
+void HpackEncoder::applyTableSize(size_t size) {
+    if (mode_ == Mode::STATELESS || size == table_.dynamicTable().maxSize()) {
+        return;
+    }
+    table_.setDynamicTableMaxSize(size);
+    min_pending_size_ = size_update_pending_ ? std::min(min_pending_size_, size) : size;
+    size_update_pending_ = true;
+}
+
+void HpackEncoder::beginBlock(std::vector<uint8_t>& out) {
+    if (governor_link_.governor() != nullptr) {
+        size_t limit = governor_link_.sync(table_.dynamicTable().size());
+        applyTableSize(std::min(max_table_size_, limit));
+    }
+    if (!size_update_pending_) {
+        return;
+    }
+
+    // Dynamic Table Size Update (001xxxxx)：先前缩小过的最小值必须先通知（RFC 7541 4.2）
+    size_t current = table_.dynamicTable().maxSize();
+    if (min_pending_size_ < current) {
+        appendInteger(out, min_pending_size_, 5, 0x20);
+    }
+    appendInteger(out, current, 5, 0x20);
+    size_update_pending_ = false;
+}
+
+void HpackEncoder::reset() {
+    table_.clearDynamic();
+    table_.setDynamicTableMaxSize(initial_table_size_);
+    policy_.reset();
+    max_table_size_ = initial_table_size_;
+    min_pending_size_ = initial_table_size_;
+    size_update_pending_ = false;
+    governor_link_.sync(0);
+}
+
+size_t HpackEncoder::retainedBytes() const {
+    return sizeof(*this) + table_.dynamicTable().retainedBytes();
+}
+
+HeaderTable& HpackEncoder::table() {
+    return table_;
+}
+
+// ============================================================================
+// HpackMemoryGovernor Implementation
+// ============================================================================
+
+// 上限取整粒度，避免连接数的小幅变化频繁触发表大小更新
+static constexpr size_t GOVERNOR_LIMIT_GRANULARITY = 256;
+
+HpackMemoryGovernor::HpackMemoryGovernor(size_t budget, size_t max_table_size)
+    : budget_(budget), max_table_size_(max_table_size), limit_(max_table_size),
+      encoders_(0), decoders_(0), table_bytes_(0), limit_changes_(0) {}
+
+HpackMemoryGovernor& HpackMemoryGovernor::global() {
+    static HpackMemoryGovernor governor;
+    return governor;
+}
+
+void HpackMemoryGovernor::setBudget(size_t budget) {
+    budget_ = budget;
+    rebalance();
+}
+
+size_t HpackMemoryGovernor::tableSizeLimit() const {
+    return limit_.load(std::memory_order_relaxed);
+}
+
+HpackMemoryGovernor::Metrics HpackMemoryGovernor::metrics() const {
+    return {budget_.load(), limit_.load(), encoders_.load(), decoders_.load(),
+            table_bytes_.load(), limit_changes_.load()};
+}
+
+void HpackMemoryGovernor::rebalance() {
+    size_t tables = encoders_.load() + decoders_.load();
+    size_t limit = max_table_size_;
+    if (tables > 0) {
+        size_t share = budget_.load() / tables;
+        if (share < limit) {
+            limit = share / GOVERNOR_LIMIT_GRANULARITY * GOVERNOR_LIMIT_GRANULARITY;
+        }
+    }
+    if (limit_.exchange(limit) != limit) {
+        ++limit_changes_;
+    }
+}
+
+HpackMemoryGovernor::Link::Link(Link&& other) noexcept
+    : governor_(other.governor_), encoder_(other.encoder_),
+      reported_bytes_(other.reported_bytes_) {
+    other.governor_ = nullptr;
+    other.reported_bytes_ = 0;
+}
+
+HpackMemoryGovernor::Link& HpackMemoryGovernor::Link::operator=(Link&& other) noexcept {
+    if (this != &other) {
+        reset();
+        governor_ = other.governor_;
+        encoder_ = other.encoder_;
+        reported_bytes_ = other.reported_bytes_;
+        other.governor_ = nullptr;
+        other.reported_bytes_ = 0;
+    }
+    return *this;
+}
+
+HpackMemoryGovernor::Link::~Link() {
+    reset();
+}
+
+void HpackMemoryGovernor::Link::attach(HpackMemoryGovernor* governor, bool encoder) {
+    reset();
+    governor_ = governor;
+    encoder_ = encoder;
+    ++(encoder ? governor->encoders_ : governor->decoders_);
+    governor->rebalance();
+}
+
+void HpackMemoryGovernor::Link::reset() {
+    if (governor_ == nullptr) {
+        return;
+    }
+    governor_->table_bytes_ -= reported_bytes_;
+    --(encoder_ ? governor_->encoders_ : governor_->decoders_);
+    governor_->rebalance();
+    governor_ = nullptr;
+    reported_bytes_ = 0;
+}
+
+size_t HpackMemoryGovernor::Link::sync(size_t table_bytes) {
+    if (governor_ == nullptr) {
+        return std::numeric_limits<size_t>::max();
+    }
+    if (table_bytes != reported_bytes_) {
+        governor_->table_bytes_ += table_bytes - reported_bytes_;
+        reported_bytes_ = table_bytes;
+    }
+    return governor_->tableSizeLimit();
+}
+
+// ============================================================================
+// RequestTemplate Implementation
+// ============================================================================
+
+RequestTemplate::RequestTemplate(std::vector<std::pair<std::string, std::string>> fixed_headers)
+    : fixed_headers_(std::move(fixed_headers)), cached_version_(0),
+      cache_valid_(false), hits_(0), misses_(0) {}
+
+void RequestTemplate::encode(HpackEncoder& encoder,
+                             const std::vector<std::pair<std::string, std::string>>& varying_headers,
+                             std::vector<uint8_t>& out) {
+    encoder.beginBlock(out);
+    uint64_t version = encoder.table().version();
+    if (cache_valid_ && cached_version_ == version) {
+        ++hits_;
+        out.insert(out.end(), cached_prefix_.begin(), cached_prefix_.end());
+    } else {
+        ++misses_;
+        cached_prefix_.clear();
+        // 大小更新已由上面的 beginBlock 写入 out，缓存的前缀中不能再出现
+        encoder.encodeFields(fixed_headers_, cached_prefix_);
+        out.insert(out.end(), cached_prefix_.begin(), cached_prefix_.end());
+
+        // 只有编码过程未修改头表时，缓存的索引才能在相同状态下复用
+        cache_valid_ = encoder.table().version() == version;
+        cached_version_ = version;
+    }
+
+    for (const auto& [name, value] : varying_headers) {
+        encoder.encodeFieldWithoutIndexing(name, value, out);
+    }
+}
+
+const std::vector<std::pair<std::string, std::string>>& RequestTemplate::fixedHeaders() const {
+    return fixed_headers_;
+}
+
+size_t RequestTemplate::hits() const {
+    return hits_;
+}
+
+size_t RequestTemplate::misses() const {
+    return misses_;
+}
+
+// ============================================================================
+// SharedHeaderBlock Implementation
+// ============================================================================
+
+SharedHeaderBlock::SharedHeaderBlock(std::shared_ptr<const std::vector<uint8_t>> bytes)
+    : bytes_(std::move(bytes)) {}
+
+SharedHeaderBlock SharedHeaderBlock::encode(
+    const std::vector<std::pair<std::string, std::string>>& headers) {
+    HpackEncoder encoder(0, HpackEncoder::Mode::STATELESS);
+    return SharedHeaderBlock(std::make_shared<const std::vector<uint8_t>>(encoder.encode(headers)));
+}
+
+SharedHeaderBlock::Comparison SharedHeaderBlock::compare(
+    const std::vector<std::vector<std::pair<std::string, std::string>>>& sequence,
+    size_t table_size) {
+    Comparison result{0, 0};
+    HpackEncoder stateful(table_size);
+    for (const auto& headers : sequence) {
+        result.stateless_bytes += encode(headers).size();
+        result.stateful_bytes += stateful.encode(headers).size();
+    }
+    return result;
+}
+
+double SharedHeaderBlock::Comparison::ratio() const {
+    if (stateful_bytes == 0) {
+        return 1.0;
+    }
+    return static_cast<double>(stateless_bytes) / static_cast<double>(stateful_bytes);
+}
+
+const uint8_t* SharedHeaderBlock::data() const {
+    return bytes_->data();
+}
+
+size_t SharedHeaderBlock::size() const {
+    return bytes_->size();
+}
+
+std::shared_ptr<const std::vector<uint8_t>> SharedHeaderBlock::bytes() const {
+    return bytes_;
+}
+
+void SharedHeaderBlock::appendTo(std::vector<uint8_t>& out) const {
+    out.insert(out.end(), bytes_->begin(), bytes_->end());
+}
+
+// ============================================================================
+// HpackTranscoder Implementation
+// ============================================================================
+
+/**
+ * @brief 计算一个已编码字符串（含 H 标志和长度前缀）占用的字节数，不解码内容
+ */
+static size_t encodedStringExtent(const uint8_t* data, size_t length) {
+    auto [string_length, prefix_length] = IntegerEncoder::decodeInteger(data, length, 7);
+    if (string_length > length - prefix_length) {
+        throw std::out_of_range("buffer is too short for string data");
+    }
+    return prefix_length + static_cast<size_t>(string_length);
+}
+
+HpackTranscoder::Stats HpackTranscoder::transcode(HpackDecoder& decoder, HpackEncoder& encoder,
+                                                  const uint8_t* data, size_t length,
+                                                  std::vector<uint8_t>& out) {
+    Stats stats{0, 0, 0};
+    HeaderTable& in_table = decoder.table();
+    size_t pos = 0;
+    bool fields_started = false;
+
+    // 出站头块同样要先通知对端挂起的表大小变化
+    encoder.beginBlock(out);
+
+    while (pos < length) {
+        uint8_t first_byte = data[pos];
+        fields_started = fields_started || (first_byte & 0xE0) != 0x20;
+
+        if ((first_byte & 0x80) != 0) {
+            // Indexed Header Field：翻译为出站表的表示
+            auto [index, consumed] = IntegerEncoder::decodeInteger(data + pos, length - pos, 7);
+            pos += consumed;
+            if (index == 0) {
+                throw std::runtime_error("Invalid index 0 for indexed header field");
+            }
+            HeaderField field = in_table.getByIndex(index);
+            encoder.encodeField(field.name, field.value, out);
+            ++stats.fields;
+
+        } else if ((first_byte & 0xE0) == 0x20) {
+            // Dynamic Table Size Update：只作用于入站连接
+            auto [size, consumed] = IntegerEncoder::decodeInteger(data + pos, length - pos, 5);
+            pos += consumed;
+            if (fields_started) {
+                throw std::runtime_error("Dynamic table size update after the first header field");
+            }
+            if (size > decoder.advertisedTableSize()) {
+                throw std::runtime_error("Dynamic table size update exceeds the advertised limit");
+            }
+            in_table.setDynamicTableMaxSize(size);
+
+        } else if ((first_byte & 0xC0) == 0x40) {
+            // Literal with Incremental Indexing：入站表需要完整的名值
+            auto [index, consumed] = IntegerEncoder::decodeInteger(data + pos, length - pos, 6);
+            pos += consumed;
+            std::string name;
+            if (index == 0) {
+                auto [decoded_name, name_length] = StringCoder::decodeString(data + pos, length - pos);
+                name = std::move(decoded_name);
+                pos += name_length;
+            } else {
+                name = in_table.getByIndex(index).name;
+            }
+            auto [value, value_length] = StringCoder::decodeString(data + pos, length - pos);
+            pos += value_length;
+
+            in_table.insertDynamic({name, value});
+            encoder.encodeField(name, value, out);
+            ++stats.fields;
+
+        } else {
+            // Literal without Indexing (0000xxxx) / Never Indexed (0001xxxx)：
+            // 值不进入任何表，原始字节直接转发
+            uint8_t flags = first_byte & 0xF0;
+            auto [index, consumed] = IntegerEncoder::decodeInteger(data + pos, length - pos, 4);
+            pos += consumed;
+
+            int out_name_index = -1;
+            size_t name_start = pos;
+            size_t name_extent = 0;
+            if (index == 0) {
+                name_extent = encodedStringExtent(data + pos, length - pos);
+                pos += name_extent;
+            } else {
+                std::string name = in_table.getByIndex(index).name;
+                out_name_index = encoder.mode() == HpackEncoder::Mode::STATELESS
+                    ? StaticTable::getIndexByName(name)
+                    : encoder.table().getIndexByName(name);
+                if (out_name_index <= 0) {
+                    // 出站表中没有该名称：以字面量发送名称
+                    out.push_back(flags);
+                    appendString(out, name);
+                }
+            }
+
+            if (out_name_index > 0) {
+                appendInteger(out, static_cast<uint64_t>(out_name_index), 4, flags);
+            } else if (index == 0) {
+                out.push_back(flags);
+                out.insert(out.end(), data + name_start, data + name_start + name_extent);
+                stats.passthrough_bytes += name_extent;
+            }
+
+            size_t value_extent = encodedStringExtent(data + pos, length - pos);
+            out.insert(out.end(), data + pos, data + pos + value_extent);
+            pos += value_extent;
+
+            stats.passthrough_bytes += value_extent;
+            ++stats.passthrough_fields;
+            ++stats.fields;
+        }
+    }
+
+    return stats;
+}
+
+// ============================================================================
+// HpackDecoder Implementation
+// ============================================================================
+
+HpackDecoder::HpackDecoder(size_t max_table_size)
+    : table_(max_table_size), max_table_size_(max_table_size) {}
+
+void HpackDecoder::setMemoryGovernor(HpackMemoryGovernor* governor) {
+    governor_link_.reset();
+    if (governor != nullptr) {
+        governor_link_.attach(governor, false);
+    }
+}
+
+void HpackDecoder::reset() {
+    table_.clearDynamic();
+    table_.setDynamicTableMaxSize(max_table_size_);
+    governor_link_.sync(0);
+}
+
+size_t HpackDecoder::retainedBytes() const {
+    size_t bytes = sizeof(*this) + table_.dynamicTable().retainedBytes() +
+                   fields_.capacity() * sizeof(FieldRef) +
+                   spans_.capacity() * sizeof(StringCoder::HuffmanSpan) +
+                   decoded_.capacity() * sizeof(std::string);
+    for (const auto& str : decoded_) {
+        bytes += str.capacity();
+    }
+    return bytes;
+}
+
+size_t HpackDecoder::advertisedTableSize() {
+    size_t limit = governor_link_.sync(table_.dynamicTable().size());
+    return std::min(max_table_size_, limit);
+}
+
+std::vector<std::pair<std::string, std::string>> HpackDecoder::decode(
+    const uint8_t* data, size_t length) {
+    std::vector<std::pair<std::string, std::string>> headers;
+
+    decode(data, length,
+           [&headers](const std::string& name, const std::string& value) {
+               headers.emplace_back(name, value);
+           });
+
+    return headers;
+}
+
+HeaderTable& HpackDecoder::table() {
+    return table_;
+}
+
+bool HpackDecoder::prescan(const uint8_t* data, size_t length) {
+    fields_.clear();
+    spans_.clear();
     size_t pos = 0;
+
+    // 读取一个字符串表示：只记录位置，Huffman 字符串加入批量解码列表
+    auto scanString = [&](StringRef& ref) {
+        if (pos >= length) {
+            return false;
+        }
+        auto [string_length, prefix_length] =
+            IntegerEncoder::decodeInteger(data + pos, length - pos, 7);
+        if (string_length > length - pos - prefix_length) {
+            return false;
+        }
+        ref.huffman = (data[pos] & 0x80) != 0;
+        ref.offset = pos + prefix_length;
+        ref.length = static_cast<size_t>(string_length);
+        pos += prefix_length + ref.length;
+        if (ref.huffman) {
+            ref.slot = spans_.size();
+            spans_.push_back({data + ref.offset, ref.length});
+        }
+        return true;
+    };
+
+    try {
+        while (pos < length) {
+            uint8_t first_byte = data[pos];
+            FieldRef field{};
+
+            if ((first_byte & 0x80) != 0) {
+                auto [index, consumed] = IntegerEncoder::decodeInteger(data + pos, length - pos, 7);
+                pos += consumed;
+                field.kind = FieldRef::INDEXED;
+                field.index = index;
+            } else if ((first_byte & 0xE0) == 0x20) {
+                auto [size, consumed] = IntegerEncoder::decodeInteger(data + pos, length - pos, 5);
+                pos += consumed;
+                field.kind = FieldRef::SIZE_UPDATE;
+                field.index = size;
+            } else {
+                int prefix_bits = (first_byte & 0xC0) == 0x40 ? 6 : 4;
+                auto [index, consumed] = IntegerEncoder::decodeInteger(data + pos, length - pos,
+                                                                       prefix_bits);
+                pos += consumed;
+                field.kind = prefix_bits == 6 ? FieldRef::INCREMENTAL : FieldRef::LITERAL;
+                field.index = index;
+                if (index == 0 && !scanString(field.name)) {
+                    return false;
+                }
+                if (!scanString(field.value)) {
+                    return false;
+                }
+            }
+            fields_.push_back(field);
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+    return true;
+}
+
+void HpackDecoder::decode(const uint8_t* data, size_t length,
+                          const HPACK::HeaderCallback& on_header) {
+    if (data == nullptr || length == 0) {
+        return;
+    }
+
+    decodeBlock(data, length, [&on_header](std::string_view name, std::string_view value) {
+        on_header(std::string(name), std::string(value));
+    });
+    governor_link_.sync(table_.dynamicTable().size());
+}
+
+void HpackDecoder::decode(const uint8_t* data, size_t length, PmrHeaderList& out) {
+    decodeViews(data, length, [&out](std::string_view name, std::string_view value) {
+        out.emplace_back(name, value);
+    });
+}
+
+bool HpackDecoder::decodeViews(const uint8_t* data, size_t length,
+                               const HPACK::HeaderViewCallback& on_header) {
+    if (data == nullptr || length == 0) {
+        return true;
+    }
+    bool valid = decodeBlock(data, length, on_header);
+    governor_link_.sync(table_.dynamicTable().size());
+    return valid;
+}
+
+bool HpackDecoder::decodeBlock(const uint8_t* data, size_t length,
+                               const HPACK::HeaderViewCallback& on_header) {
+    // 格式异常的头块走逐字段解码路径，保持原有的容错行为，但向调用方报告失败
+    if (!prescan(data, length)) {
+        decodeSequential(data, length, [&on_header](const std::string& name, const std::string& value) {
+            on_header(name, value);
+        });
+        return false;
+    }
+
+    decoded_.resize(std::max(decoded_.size(), spans_.size()));
+    StringCoder::decodeHuffmanBatch(spans_.data(), spans_.size(), decoded_.data());
+
+    auto text = [&](const StringRef& ref) -> std::string_view {
+        if (ref.huffman) {
+            return decoded_[ref.slot];
+        }
+        return std::string_view(reinterpret_cast<const char*>(data + ref.offset), ref.length);
+    };
+
+    bool valid = true;
+    bool fields_started = false;
+    for (const FieldRef& field : fields_) {
+        fields_started = fields_started || field.kind != FieldRef::SIZE_UPDATE;
+        switch (field.kind) {
+            case FieldRef::INDEXED: {
+                if (field.index == 0) {
+                    std::cerr << "Invalid index 0 for indexed header field" << std::endl;
+                    return false;
+                }
+                std::pair<std::string_view, std::string_view> header;
+                try {
+                    header = table_.viewByIndex(field.index);
+                } catch (const std::exception& e) {
+                    std::cerr << "Failed to retrieve header at index " << field.index << std::endl;
+                    valid = false;
+                    break;
+                }
+                on_header(header.first, header.second);
+                break;
+            }
+            case FieldRef::SIZE_UPDATE:
+                // 大小更新只能出现在头块开头，且不得超过通告给对端的上限（RFC 7541 4.2、6.3）
+                if (fields_started || field.index > advertisedTableSize()) {
+                    std::cerr << "Invalid dynamic table size update: " << field.index << std::endl;
+                    return false;
+                }
+                table_.setDynamicTableMaxSize(field.index);
+                break;
+            case FieldRef::INCREMENTAL:
+            case FieldRef::LITERAL: {
+                std::string_view name;
+                if (field.index == 0) {
+                    name = text(field.name);
+                } else {
+                    try {
+                        name = table_.viewByIndex(field.index).first;
+                    } catch (const std::exception& e) {
+                        return false;
+                    }
+                }
+                std::string_view value = text(field.value);
+                on_header(name, value);
+                if (field.kind == FieldRef::INCREMENTAL) {
+                    // 名称可能引用即将被淘汰的条目，先复制再插入
+                    table_.insertDynamic({std::string(name), std::string(value)});
+                }
+                break;
+            }
+        }
+    }
+    return valid;
+}
+
+void HpackDecoder::decodeSequential(const uint8_t* data, size_t length,
+                                    const HPACK::HeaderCallback& on_header) {
+    size_t pos = 0;
+    bool fields_started = false;
     
-    while (pos < buffer.size()) {
+    while (pos < length) {
         try {
-            if (pos >= buffer.size()) break;
+            if (pos >= length) break;
             
-            uint8_t first_byte = buffer[pos];
+            uint8_t first_byte = data[pos];
+            fields_started = fields_started || (first_byte & 0xE0) != 0x20;
             
             // Determine the encoding type based on the bit pattern
             if ((first_byte & 0x80) != 0) {
                 // Indexed Header Field Representation (1xxxxxxx)
-                if (pos + 1 > buffer.size()) break;
+                if (pos + 1 > length) break;
                 
                 auto [index, bytes_consumed] = IntegerEncoder::decodeInteger(
-                    buffer.data() + pos, buffer.size() - pos, 7);
+                    data + pos, length - pos, 7);
                 pos += bytes_consumed;
                 
                 if (index == 0) {
@@ -780,138 +1938,142 @@ std::vector<std::pair<std::string, std::string>> HPACK::decode(
                 }
                 
                 try {
-                    HeaderField field = g_header_table.getByIndex(index);
-                    headers.emplace_back(field.name, field.value);
+                    HeaderField field = table_.getByIndex(index);
+                    on_header(field.name, field.value);
                 } catch (const std::exception& e) {
                     std::cerr << "Failed to retrieve header at index " << index << std::endl;
                 }
                 
             } else if ((first_byte & 0xC0) == 0x40) {
                 // Literal Header Field with Incremental Indexing (01xxxxxx)
-                if (pos + 1 > buffer.size()) break;
+                if (pos + 1 > length) break;
                 
                 auto [index, bytes_consumed] = IntegerEncoder::decodeInteger(
-                    buffer.data() + pos, buffer.size() - pos, 6);
+                    data + pos, length - pos, 6);
                 pos += bytes_consumed;
                 
-                if (pos >= buffer.size()) break;
+                if (pos >= length) break;
                 
                 std::string name, value;
                 
                 if (index == 0) {
                     // New name
                     auto [name_decoded, name_len] = StringCoder::decodeString(
-                        buffer.data() + pos, buffer.size() - pos);
+                        data + pos, length - pos);
                     name = name_decoded;
                     pos += name_len;
                 } else {
                     // Name from table
                     try {
-                        HeaderField field = g_header_table.getByIndex(index);
+                        HeaderField field = table_.getByIndex(index);
                         name = field.name;
                     } catch (const std::exception& e) {
                         break;
                     }
                 }
                 
-                if (pos >= buffer.size()) break;
+                if (pos >= length) break;
                 
                 // Decode value
                 auto [value_decoded, value_len] = StringCoder::decodeString(
-                    buffer.data() + pos, buffer.size() - pos);
+                    data + pos, length - pos);
                 value = value_decoded;
                 pos += value_len;
                 
-                headers.emplace_back(name, value);
+                on_header(name, value);
                 
                 // Add to dynamic table
-                g_header_table.insertDynamic({name, value});
+                table_.insertDynamic({name, value});
                 
             } else if ((first_byte & 0xF0) == 0x00) {
                 // Literal Header Field without Indexing (0000xxxx)
-                if (pos + 1 > buffer.size()) break;
+                if (pos + 1 > length) break;
                 
                 auto [index, bytes_consumed] = IntegerEncoder::decodeInteger(
-                    buffer.data() + pos, buffer.size() - pos, 4);
+                    data + pos, length - pos, 4);
                 pos += bytes_consumed;
                 
-                if (pos >= buffer.size()) break;
+                if (pos >= length) break;
                 
                 std::string name, value;
                 
                 if (index == 0) {
                     // New name
                     auto [name_decoded, name_len] = StringCoder::decodeString(
-                        buffer.data() + pos, buffer.size() - pos);
+                        data + pos, length - pos);
                     name = name_decoded;
                     pos += name_len;
                 } else {
                     // Name from table
                     try {
-                        HeaderField field = g_header_table.getByIndex(index);
+                        HeaderField field = table_.getByIndex(index);
                         name = field.name;
                     } catch (const std::exception& e) {
                         break;
                     }
                 }
                 
-                if (pos >= buffer.size()) break;
+                if (pos >= length) break;
                 
                 // Decode value
                 auto [value_decoded, value_len] = StringCoder::decodeString(
-                    buffer.data() + pos, buffer.size() - pos);
+                    data + pos, length - pos);
                 value = value_decoded;
                 pos += value_len;
                 
-                headers.emplace_back(name, value);
+                on_header(name, value);
                 
             } else if ((first_byte & 0xF0) == 0x10) {
                 // Literal Header Field Never Indexed (0001xxxx)
-                if (pos + 1 > buffer.size()) break;
+                if (pos + 1 > length) break;
                 
                 auto [index, bytes_consumed] = IntegerEncoder::decodeInteger(
-                    buffer.data() + pos, buffer.size() - pos, 4);
+                    data + pos, length - pos, 4);
                 pos += bytes_consumed;
                 
-                if (pos >= buffer.size()) break;
+                if (pos >= length) break;
                 
                 std::string name, value;
                 
                 if (index == 0) {
                     // New name
                     auto [name_decoded, name_len] = StringCoder::decodeString(
-                        buffer.data() + pos, buffer.size() - pos);
+                        data + pos, length - pos);
                     name = name_decoded;
                     pos += name_len;
                 } else {
                     // Name from table
                     try {
-                        HeaderField field = g_header_table.getByIndex(index);
+                        HeaderField field = table_.getByIndex(index);
                         name = field.name;
                     } catch (const std::exception& e) {
                         break;
                     }
                 }
                 
-                if (pos >= buffer.size()) break;
+                if (pos >= length) break;
                 
                 // Decode value
                 auto [value_decoded, value_len] = StringCoder::decodeString(
-                    buffer.data() + pos, buffer.size() - pos);
+                    data + pos, length - pos);
                 value = value_decoded;
                 pos += value_len;
                 
-                headers.emplace_back(name, value);
+                on_header(name, value);
                 
             } else if ((first_byte & 0xE0) == 0x20) {
                 // Dynamic Table Size Update (001xxxxx)
-                if (pos + 1 > buffer.size()) break;
+                if (pos + 1 > length) break;
                 
                 auto [size, bytes_consumed] = IntegerEncoder::decodeInteger(
-                    buffer.data() + pos, buffer.size() - pos, 5);
+                    data + pos, length - pos, 5);
                 pos += bytes_consumed;
                 
-                g_header_table.setDynamicTableMaxSize(size);
+                // 非法的大小更新不能应用到动态表，后续字段也无从解码
+                if (fields_started || size > advertisedTableSize()) {
+                    return;
+                }
+                table_.setDynamicTableMaxSize(size);
                 
             } else {
                 // Unknown encoding, skip this byte
@@ -923,8 +2085,6 @@ std::vector<std::pair<std::string, std::string>> HPACK::decode(
             pos++;
         }
     }
-
-    return headers;
 }
 
 } // namespace http2
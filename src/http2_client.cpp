@@ -1,11 +1,16 @@
 #include "http2_client.h"
 #include "hpack.h"
+#include "uring.h"
+#include <linux/io_uring.h>
 #include <iostream>
-#include <iomanip>
 #include <cstring>
 #include <cstdlib>
 #include <cstdio>
+#include <cerrno>
+#include <climits>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
@@ -20,8 +25,43 @@ namespace http2 {
 // HTTP/2连接前言
 static const char HTTP2_PREFACE[] = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
 
-Http2Client::Http2Client(const std::string& host, uint16_t port)
-    : host_(host), port_(port), socket_fd_(-1), ssl_ctx_(nullptr), ssl_(nullptr) {
+// 默认接收窗口：流级 1 MiB，连接级 16 MiB
+static constexpr uint32_t DEFAULT_STREAM_WINDOW = 1u << 20;
+static constexpr uint32_t DEFAULT_CONNECTION_WINDOW = 16u << 20;
+
+// 对端通告的 SETTINGS_HEADER_TABLE_SIZE 超过该值时，编码器只使用这么大的动态表
+static constexpr uint32_t MAX_ENCODER_TABLE_SIZE = 65536;
+
+// OpenSSL 预读缓冲区大小：一次 read 系统调用取回多个 TLS 记录
+static constexpr size_t TLS_READ_AHEAD_SIZE = 65536;
+
+// socket BIO 回调：统计 SSL 发起的 read/write 系统调用（调用前触发一次）
+static long countSocketIo(BIO* bio, int oper, const char*, size_t, int, long, int ret, size_t*) {
+    if (oper == BIO_CB_READ || oper == BIO_CB_WRITE) {
+        static_cast<EventLoop*>(static_cast<void*>(BIO_get_callback_arg(bio)))->recordIo();
+    }
+    return ret;
+}
+
+Http2Client::Http2Client(const std::string& host, uint16_t port, EventLoop* loop)
+    : host_(host), port_(port), socket_fd_(-1), ssl_ctx_(nullptr), ssl_(nullptr),
+      own_loop_(loop ? nullptr : std::make_unique<EventLoop>()),
+      loop_(loop ? loop : own_loop_.get()),
+      state_(ConnectionState::DISCONNECTED), timeout_ms_(30000),
+      send_offset_(0), want_write_(false), flush_scheduled_(false), flush_task_(0), parsing_(false),
+      ring_(nullptr), net_in_(nullptr), net_out_(nullptr), ring_recv_op_(0), ring_writes_(0),
+      advertised_table_size_(4096), peer_max_frame_size_(DEFAULT_MAX_FRAME_SIZE),
+      peer_max_header_list_size_(UINT32_MAX), local_max_frame_size_(DEFAULT_LOCAL_MAX_FRAME_SIZE),
+      local_max_header_list_size_(DEFAULT_LOCAL_MAX_HEADER_LIST_SIZE),
+      stream_window_size_(DEFAULT_STREAM_WINDOW), connection_window_size_(DEFAULT_CONNECTION_WINDOW),
+      stream_window_target_(DEFAULT_STREAM_WINDOW), connection_window_target_(DEFAULT_CONNECTION_WINDOW),
+      recv_window_(DEFAULT_WINDOW_SIZE), recv_credit_(0),
+      autotune_(true), autotune_max_window_(DEFAULT_MAX_TUNED_WINDOW),
+      bdp_ping_pending_(false), bdp_ping_id_(0), bdp_bytes_(0),
+      stream_buffer_limit_(DEFAULT_STREAM_WINDOW),
+      send_window_(DEFAULT_WINDOW_SIZE), peer_initial_window_size_(DEFAULT_WINDOW_SIZE),
+      next_stream_id_(1), active_streams_(0), peer_max_concurrent_streams_(UINT32_MAX),
+      header_block_stream_(0), header_block_end_stream_(false), goaway_received_(false) {
     // 初始化OpenSSL
     SSL_library_init();
     SSL_load_error_strings();
@@ -33,15 +73,15 @@ Http2Client::~Http2Client() {
 }
 
 bool Http2Client::createSocket() {
-    // 获取主机信息
+    // 获取主机信息（域名解析仍是阻塞的）
     struct hostent* host_entry = gethostbyname(host_.c_str());
     if (!host_entry) {
         std::cerr << "Failed to resolve hostname: " << host_ << std::endl;
         return false;
     }
 
-    // 创建socket
-    socket_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    // 创建非阻塞socket
+    socket_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
     if (socket_fd_ < 0) {
         std::cerr << "Failed to create socket" << std::endl;
         return false;
@@ -61,27 +101,20 @@ bool Http2Client::createSocket() {
     std::memset(&server_addr, 0, sizeof(server_addr));
     server_addr.sin_family = AF_INET;
     server_addr.sin_port = htons(port_);
-    server_addr.sin_addr.s_addr = inet_aton(host_entry->h_addr, nullptr) ? 
-        *(uint32_t*)host_entry->h_addr : 0;
+    server_addr.sin_addr = *(struct in_addr*)host_entry->h_addr_list[0];
 
-    // 如果inet_aton失败，尝试使用h_addr
-    if (server_addr.sin_addr.s_addr == 0) {
-        server_addr.sin_addr = *(struct in_addr*)host_entry->h_addr_list[0];
-    }
-
-    // 连接到服务器
-    if (::connect(socket_fd_, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+    // 发起连接：非阻塞socket通常返回 EINPROGRESS，可写时连接完成
+    if (::connect(socket_fd_, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0 &&
+        errno != EINPROGRESS) {
         std::cerr << "Failed to connect to server: " << host_ << ":" << port_ << std::endl;
         close(socket_fd_);
         socket_fd_ = -1;
         return false;
     }
-
-    std::cout << "Socket connection established" << std::endl;
     return true;
 }
 
-bool Http2Client::performTlsHandshake() {
+bool Http2Client::startTls() {
     // 创建SSL上下文
     ssl_ctx_ = SSL_CTX_new(TLS_client_method());
     if (!ssl_ctx_) {
@@ -94,7 +127,7 @@ bool Http2Client::performTlsHandshake() {
 
     // 设置ALPN以支持HTTP/2
     unsigned char alpn_protos[] = {2, 'h', '2', 8, 'h', 't', 't', 'p', '/', '1', '.', '1'};
-    if (!SSL_CTX_set_alpn_protos(ssl_ctx_, alpn_protos, sizeof(alpn_protos))) {
+    if (SSL_CTX_set_alpn_protos(ssl_ctx_, alpn_protos, sizeof(alpn_protos)) != 0) {
         std::cerr << "Failed to set ALPN protocols" << std::endl;
         // 继续，ALPN不是强制的
     }
@@ -103,572 +136,1353 @@ bool Http2Client::performTlsHandshake() {
     ssl_ = SSL_new(ssl_ctx_);
     if (!ssl_) {
         std::cerr << "Failed to create SSL connection" << std::endl;
-        SSL_CTX_free(ssl_ctx_);
-        ssl_ctx_ = nullptr;
         return false;
     }
 
+    // 非阻塞写可能只写出一部分，重试时发送缓冲区可能已经扩容
+    SSL_set_mode(ssl_, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+
     // 设置SNI（服务器名称指示）
     SSL_set_tlsext_host_name(ssl_, host_.c_str());
 
-    // 关联socket和SSL
-    if (!SSL_set_fd(ssl_, socket_fd_)) {
-        std::cerr << "Failed to set SSL socket" << std::endl;
-        SSL_free(ssl_);
-        ssl_ = nullptr;
-        SSL_CTX_free(ssl_ctx_);
-        ssl_ctx_ = nullptr;
-        return false;
+    ring_ = loop_->uring();
+    if (ring_) {
+        // 密文经内存 BIO 交给 io_uring 收发，socket 不再由 epoll 监视
+        BIO* in = BIO_new(BIO_s_mem());
+        BIO* out = BIO_new(BIO_s_mem());
+        if (!in || !out) {
+            BIO_free(in);
+            BIO_free(out);
+            ring_ = nullptr;
+            std::cerr << "Failed to create memory BIO" << std::endl;
+            return false;
+        }
+        SSL_set_bio(ssl_, in, out);
+        net_in_ = in;
+        net_out_ = out;
+        loop_->remove(socket_fd_);
+        armRingReceive();
+    } else {
+        // 关联socket和SSL
+        if (!SSL_set_fd(ssl_, socket_fd_)) {
+            std::cerr << "Failed to set SSL socket" << std::endl;
+            return false;
+        }
+        BIO* bio = SSL_get_rbio(ssl_);
+        BIO_set_callback_ex(bio, countSocketIo);
+        BIO_set_callback_arg(bio, static_cast<char*>(static_cast<void*>(loop_)));
+
+        // 预读：每次 read 尽量取满缓冲区，而不是按记录头和记录体各读一次
+        SSL_set_read_ahead(ssl_, 1);
+        SSL_set_default_read_buffer_len(ssl_, TLS_READ_AHEAD_SIZE);
     }
 
-    // 执行TLS握手
-    if (SSL_connect(ssl_) <= 0) {
+    SSL_set_connect_state(ssl_);
+    state_ = ConnectionState::HANDSHAKING;
+    return true;
+}
+
+bool Http2Client::continueHandshake() {
+    int ret = SSL_connect(ssl_);
+    if (ret <= 0) {
+        int err = SSL_get_error(ssl_, ret);
+        if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) {
+            want_write_ = err == SSL_ERROR_WANT_WRITE;
+            return !ring_ || flushCiphertext();
+        }
         std::cerr << "TLS handshake failed" << std::endl;
-        SSL_free(ssl_);
-        ssl_ = nullptr;
-        SSL_CTX_free(ssl_ctx_);
-        ssl_ctx_ = nullptr;
         return false;
     }
+    want_write_ = false;
 
-    // 检查ALPN协议协商结果
-    const unsigned char* alpn_selected = nullptr;
-    unsigned int alpn_len = 0;
-    SSL_get0_alpn_selected(ssl_, &alpn_selected, &alpn_len);
-    if (alpn_selected) {
-        std::cout << "ALPN selected: ";
-        for (unsigned int i = 0; i < alpn_len; ++i) {
-            std::cout << (char)alpn_selected[i];
+    // 发送客户端前言和SETTINGS（以及扩大连接窗口的 WINDOW_UPDATE），然后等待服务器的SETTINGS
+    state_ = ConnectionState::AWAITING_SETTINGS;
+    if (!sendClientPreface() || !sendSettings()) {
+        return false;
+    }
+    if (connection_window_size_ > DEFAULT_WINDOW_SIZE) {
+        if (!sendWindowUpdate(0, connection_window_size_ - DEFAULT_WINDOW_SIZE)) {
+            return false;
+        }
+        recv_window_ = connection_window_size_;
+    }
+    return true;
+}
+
+void Http2Client::onSocketEvent(uint32_t events) {
+    bool ok = true;
+    switch (state_) {
+        case ConnectionState::CONNECTING: {
+            int error = 0;
+            socklen_t length = sizeof(error);
+            if (getsockopt(socket_fd_, SOL_SOCKET, SO_ERROR, &error, &length) < 0 || error != 0) {
+                std::cerr << "Failed to connect to server: " << host_ << ":" << port_ << std::endl;
+                ok = false;
+                break;
+            }
+            ok = startTls() && continueHandshake();
+            break;
         }
-        std::cout << std::endl;
+
+        case ConnectionState::HANDSHAKING:
+            ok = continueHandshake();
+            break;
+
+        case ConnectionState::AWAITING_SETTINGS:
+        case ConnectionState::READY:
+            // 读到的帧产生的回复在本轮结束时统一写出；可写时继续未写完的部分
+            if (events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+                ok = readAvailable();
+            }
+            if (ok && (events & EPOLLOUT)) {
+                ok = flushOutput();
+            }
+            break;
+
+        case ConnectionState::DISCONNECTED:
+            return;
+    }
+
+    if (!ok) {
+        failConnection(2);  // INTERNAL_ERROR
+        return;
+    }
+    updateInterest();
+    deliverCompleted();
+}
+
+void Http2Client::updateInterest() {
+    if (socket_fd_ < 0 || ring_) {
+        return;
     }
+    uint32_t events = state_ == ConnectionState::CONNECTING ? EPOLLOUT : EPOLLIN;
+    if (want_write_) {
+        events |= EPOLLOUT;
+    }
+    loop_->modify(socket_fd_, events);
+}
 
-    std::cout << "TLS handshake successful" << std::endl;
+bool Http2Client::readAvailable() {
+    while (ssl_) {
+        size_t writable = std::min<size_t>(reader_.writable(), INT_MAX);
+        int ret = SSL_read(ssl_, reader_.writePointer(), static_cast<int>(writable));
+        if (ret <= 0) {
+            int err = SSL_get_error(ssl_, ret);
+            if (err == SSL_ERROR_WANT_READ) {
+                return true;
+            }
+            if (err == SSL_ERROR_WANT_WRITE) {
+                want_write_ = true;
+                return true;
+            }
+            if (err == SSL_ERROR_ZERO_RETURN) {
+                std::cerr << "Connection closed by peer" << std::endl;
+            } else {
+                std::cerr << "SSL_read error: " << err << std::endl;
+            }
+            return false;
+        }
+        reader_.commit(static_cast<size_t>(ret));
+        if (!parseFrames()) {
+            return false;
+        }
+        // 内存 BIO 中的密文不计入 SSL_has_pending，io_uring 模式必须读到 WANT_READ
+        if (!ring_ && ssl_ && !SSL_has_pending(ssl_)) {
+            return true;
+        }
+    }
     return true;
 }
 
-int Http2Client::socketRead(uint8_t* buffer, size_t size) {
-    if (!ssl_) return -1;
-    
-    int ret = SSL_read(ssl_, buffer, size);
-    if (ret < 0) {
-        int err = SSL_get_error(ssl_, ret);
-        if (err != SSL_ERROR_WANT_READ && err != SSL_ERROR_WANT_WRITE) {
-            std::cerr << "SSL_read error: " << err << std::endl;
+bool Http2Client::parseFrames() {
+    FrameView frame;
+    // 回调可能断开连接，之后的帧不再分发
+    FrameHeader header;
+    parsing_ = true;
+    bool ok = true;
+    while (state_ != ConnectionState::DISCONNECTED && reader_.peek(header)) {
+        // 超过本端通告的 SETTINGS_MAX_FRAME_SIZE 的帧在接收负载之前拒绝
+        if (header.length > local_max_frame_size_) {
+            std::cerr << "Frame length " << header.length << " exceeds SETTINGS_MAX_FRAME_SIZE "
+                      << local_max_frame_size_ << std::endl;
+            failOpenStreams(0, 6);  // FRAME_SIZE_ERROR
+            ok = false;
+            break;
+        }
+        if (!reader_.next(frame)) {
+            break;
+        }
+        if (!dispatchFrame(frame)) {
+            ok = false;
+            break;
         }
     }
-    return ret;
+    parsing_ = false;
+    return ok;
 }
 
-int Http2Client::socketWrite(const uint8_t* buffer, size_t size) {
-    if (!ssl_) return -1;
-    
-    int ret = SSL_write(ssl_, buffer, size);
-    if (ret < 0) {
-        int err = SSL_get_error(ssl_, ret);
-        std::cerr << "SSL_write error: " << err << std::endl;
+bool Http2Client::flushOutput() {
+    while (ssl_ && send_offset_ < send_buffer_.size()) {
+        size_t remaining = std::min<size_t>(send_buffer_.size() - send_offset_, INT_MAX);
+        int ret = SSL_write(ssl_, send_buffer_.data() + send_offset_, static_cast<int>(remaining));
+        if (ret <= 0) {
+            int err = SSL_get_error(ssl_, ret);
+            if (err == SSL_ERROR_WANT_WRITE) {
+                want_write_ = true;
+                return true;
+            }
+            if (err == SSL_ERROR_WANT_READ) {
+                return true;  // 可读时重试
+            }
+            std::cerr << "SSL_write error: " << err << std::endl;
+            return false;
+        }
+        send_offset_ += ret;
     }
-    return ret;
+    send_buffer_.clear();
+    send_offset_ = 0;
+    want_write_ = false;
+    return !ring_ || flushCiphertext();
+}
+
+void Http2Client::armRingReceive() {
+    ring_recv_op_ = ring_->recvMultishot(socket_fd_, [this](int32_t result, uint32_t flags) {
+        onRingReceive(result, flags);
+    });
+}
+
+void Http2Client::onRingReceive(int32_t result, uint32_t flags) {
+    if (!(flags & IORING_CQE_F_MORE)) {
+        ring_recv_op_ = 0;
+    }
+
+    bool ok = true;
+    if (result > 0) {
+        uint16_t buffer_id = static_cast<uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT);
+        BIO_write(net_in_, ring_->receiveBuffer(buffer_id), result);
+        ring_->recycleReceiveBuffer(buffer_id);
+
+        if (state_ == ConnectionState::HANDSHAKING) {
+            ok = continueHandshake();
+        }
+        // 握手完成时服务器的 SETTINGS 可能已经在同一批密文中；
+        // SSL_read 自身产生的密文（如告警）不经过写队列，直接提交
+        if (ok && state_ != ConnectionState::HANDSHAKING) {
+            ok = readAvailable() && flushCiphertext();
+        }
+    } else if (result == 0) {
+        std::cerr << "Connection closed by peer" << std::endl;
+        ok = false;
+    } else if (result != -ENOBUFS && result != -EINTR) {
+        // -ENOBUFS：接收缓冲区暂时用尽，重新提交即可
+        std::cerr << "io_uring recv error: " << std::strerror(-result) << std::endl;
+        ok = false;
+    }
+
+    if (!ok) {
+        failConnection(2);  // INTERNAL_ERROR
+        return;
+    }
+    if (ring_ && ring_recv_op_ == 0) {
+        armRingReceive();
+    }
+    deliverCompleted();
+}
+
+bool Http2Client::flushCiphertext() {
+    if (!ring_ || ring_writes_ > 0) {
+        return true;  // 写链结束后继续
+    }
+
+    // 短写或被取消的密文已在队列前部，新密文排在后面
+    size_t pending = BIO_ctrl_pending(net_out_);
+    while (pending > 0) {
+        int slot = ring_->acquireSendSlot();
+        if (slot < 0) {
+            break;
+        }
+        size_t length = std::min(pending, IoUring::SEND_SLOT_SIZE);
+        BIO_read(net_out_, ring_->sendSlot(static_cast<uint16_t>(slot)), static_cast<int>(length));
+        ring_chunks_.push_back({slot, nullptr, 0, length, 0});
+        pending -= length;
+    }
+    if (pending > 0) {
+        auto spill = std::make_shared<std::vector<uint8_t>>(pending);
+        BIO_read(net_out_, spill->data(), static_cast<int>(pending));
+        ring_chunks_.push_back({-1, std::move(spill), 0, pending, 0});
+    }
+    if (ring_chunks_.empty()) {
+        return true;
+    }
+
+    // 整条链在同一次提交中：前一个写完成后内核才开始下一个
+    ring_->reserve(static_cast<unsigned>(ring_chunks_.size()));
+    for (size_t i = 0; i < ring_chunks_.size(); ++i) {
+        RingChunk& chunk = ring_chunks_[i];
+        bool link = i + 1 < ring_chunks_.size();
+        auto on_write = [this, i](int32_t result, uint32_t) {
+            onRingWrite(i, result);
+        };
+        if (chunk.slot >= 0) {
+            chunk.op = ring_->writeFixed(socket_fd_, static_cast<uint16_t>(chunk.slot),
+                                         chunk.offset, chunk.length, link, on_write);
+        } else {
+            chunk.op = ring_->send(socket_fd_, chunk.spill, chunk.offset, chunk.length,
+                                   link, on_write);
+        }
+        ++ring_writes_;
+    }
+    return true;
+}
+
+void Http2Client::onRingWrite(size_t index, int32_t result) {
+    RingChunk& chunk = ring_chunks_[index];
+    chunk.op = 0;
+    --ring_writes_;
+    if (result > 0) {
+        chunk.offset += static_cast<size_t>(result);
+        chunk.length -= static_cast<size_t>(result);
+    } else if (result != -ECANCELED && result != -EAGAIN && result != -EINTR) {
+        // 链中前一个写短写或失败时，后面的写以 -ECANCELED 结束，稍后重发
+        std::cerr << "io_uring write error: " << std::strerror(-result) << std::endl;
+        failConnection(2);  // INTERNAL_ERROR
+        return;
+    }
+    if (ring_writes_ > 0) {
+        return;
+    }
+
+    // 写链结束：归还写完的槽，重发剩余部分并提交新产生的密文
+    while (!ring_chunks_.empty() && ring_chunks_.front().length == 0) {
+        if (ring_chunks_.front().slot >= 0) {
+            ring_->releaseSendSlot(static_cast<uint16_t>(ring_chunks_.front().slot));
+        }
+        ring_chunks_.pop_front();
+    }
+    if (!flushCiphertext()) {
+        failConnection(2);
+    }
+}
+
+void Http2Client::stopRingTransport() {
+    if (!ring_) {
+        return;
+    }
+    if (ring_recv_op_ != 0) {
+        ring_->cancel(ring_recv_op_);
+    }
+    // 在途的写在最终完成时由环归还发送槽
+    for (const RingChunk& chunk : ring_chunks_) {
+        if (chunk.op != 0) {
+            ring_->cancel(chunk.op, chunk.slot);
+        } else if (chunk.slot >= 0) {
+            ring_->releaseSendSlot(static_cast<uint16_t>(chunk.slot));
+        }
+    }
+    ring_chunks_.clear();
+    ring_writes_ = 0;
+    ring_recv_op_ = 0;
+    ring_ = nullptr;
 }
 
 bool Http2Client::sendClientPreface() {
     const uint8_t* preface = (const uint8_t*)HTTP2_PREFACE;
     size_t preface_len = 24; // "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"
     
-    if (socketWrite(preface, preface_len) != (int)preface_len) {
-        std::cerr << "Failed to send HTTP/2 preface" << std::endl;
-        return false;
-    }
-    
-    std::cout << "HTTP/2 preface sent" << std::endl;
+    // 与随后的 SETTINGS 合并写出
+    send_buffer_.insert(send_buffer_.end(), preface, preface + preface_len);
+    scheduleFlush();
     return true;
 }
 
 bool Http2Client::sendSettings() {
-    // SETTINGS帧：type=4, flags=0, stream_id=0, payload=empty
+    // SETTINGS帧：type=4, flags=0, stream_id=0
+    // 默认值无需发送；内存治理器压低表大小时通告 SETTINGS_HEADER_TABLE_SIZE (0x1)，
+    // 推送总是关闭，头列表大小总是有上限
     std::vector<uint8_t> payload;
-    return sendFrame(FRAME_TYPE_SETTINGS, 0, 0, payload);
+    auto add_setting = [&payload](uint16_t id, uint32_t value) {
+        payload.insert(payload.end(), {static_cast<uint8_t>(id >> 8), static_cast<uint8_t>(id),
+                                       static_cast<uint8_t>(value >> 24), static_cast<uint8_t>(value >> 16),
+                                       static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value)});
+    };
+    size_t table_size = decoder_.advertisedTableSize();
+    if (table_size != 4096 || advertised_table_size_ != 4096) {
+        add_setting(0x1, static_cast<uint32_t>(table_size));
+    }
+    advertised_table_size_ = table_size;
+    add_setting(0x2, 0);  // SETTINGS_ENABLE_PUSH
+    if (stream_window_size_ != DEFAULT_WINDOW_SIZE) {
+        add_setting(0x4, stream_window_size_);  // SETTINGS_INITIAL_WINDOW_SIZE
+    }
+    if (local_max_frame_size_ != DEFAULT_MAX_FRAME_SIZE) {
+        add_setting(0x5, local_max_frame_size_);  // SETTINGS_MAX_FRAME_SIZE
+    }
+    add_setting(0x6, local_max_header_list_size_);  // SETTINGS_MAX_HEADER_LIST_SIZE，默认不限制
+    return sendFrame(FRAME_TYPE_SETTINGS, 0, 0, payload.data(), payload.size());
 }
 
 bool Http2Client::sendFrame(uint8_t type, uint8_t flags, uint32_t stream_id,
-                            const std::vector<uint8_t>& payload) {
-    std::vector<uint8_t> frame;
-    
-    // 帧头：3字节长度 + 1字节类型 + 1字节标志 + 4字节流ID
-    uint32_t length = payload.size();
-    
-    // 编码长度（3字节，大端）
-    frame.push_back((length >> 16) & 0xFF);
-    frame.push_back((length >> 8) & 0xFF);
-    frame.push_back(length & 0xFF);
-    
-    // 类型
-    frame.push_back(type);
-    
-    // 标志
-    frame.push_back(flags);
-    
-    // 流ID（4字节，大端，最高位必须为0）
-    frame.push_back((stream_id >> 24) & 0x7F);
-    frame.push_back((stream_id >> 16) & 0xFF);
-    frame.push_back((stream_id >> 8) & 0xFF);
-    frame.push_back(stream_id & 0xFF);
-    
-    // 添加负载
-    frame.insert(frame.end(), payload.begin(), payload.end());
-    
-    // 发送帧
-    if (socketWrite(frame.data(), frame.size()) != (int)frame.size()) {
+                            const uint8_t* payload, size_t length) {
+    if (!ssl_) {
         std::cerr << "Failed to send frame type: " << (int)type << std::endl;
         return false;
     }
-    
+
+    // 帧头：3字节长度 + 1字节类型 + 1字节标志 + 4字节流ID，直接写入写队列
+    size_t offset = send_buffer_.size();
+    send_buffer_.resize(offset + FRAME_HEADER_SIZE + length);
+    writeFrameHeader(send_buffer_.data() + offset, {static_cast<uint32_t>(length), type, flags, stream_id});
+    if (length > 0) {
+        std::memcpy(send_buffer_.data() + offset + FRAME_HEADER_SIZE, payload, length);
+    }
+    scheduleFlush();
     return true;
 }
 
-bool Http2Client::recvFrame(uint8_t& type, uint8_t& flags, uint32_t& stream_id,
-                            std::vector<uint8_t>& payload) {
-    uint8_t header[9];
-    
-    // 读取帧头
-    int bytes_read = socketRead(header, 9);
-    if (bytes_read != 9) {
-        if (bytes_read < 0) {
-            std::cerr << "Socket read error" << std::endl;
-        } else {
-            std::cerr << "Incomplete frame header. Expected 9 bytes, got " << bytes_read << std::endl;
+bool Http2Client::sendWindowUpdate(uint32_t stream_id, uint32_t increment) {
+    const uint8_t payload[] = {static_cast<uint8_t>((increment >> 24) & 0x7F), static_cast<uint8_t>(increment >> 16),
+                               static_cast<uint8_t>(increment >> 8), static_cast<uint8_t>(increment)};
+    return sendFrame(FRAME_TYPE_WINDOW_UPDATE, 0, stream_id, payload, sizeof(payload));
+}
+
+void Http2Client::consumeData(uint32_t stream_id, Stream* stream, uint32_t length) {
+    recv_credit_ += length;
+    returnCredit(0, recv_window_, recv_credit_, connection_window_target_);
+    if (stream) {
+        stream->recv_credit += length;
+        returnCredit(stream_id, stream->recv_window, stream->recv_credit, stream->window_size);
+    }
+}
+
+void Http2Client::releaseCredit(uint32_t stream_id, size_t length) {
+    auto it = streams_.find(stream_id);
+    if (it == streams_.end() || it->second.state == StreamState::CLOSED) {
+        return;
+    }
+    Stream& stream = it->second;
+    stream.recv_credit += static_cast<int64_t>(length);
+    returnCredit(stream_id, stream.recv_window, stream.recv_credit, stream.window_size);
+}
+
+uint32_t Http2Client::streamWindow(const Stream& stream) const {
+    return stream.deferred_credit ? std::min(stream_window_target_, stream_buffer_limit_)
+                                  : stream_window_target_;
+}
+
+void Http2Client::StreamCredit::consume(size_t length) const {
+    if (auto connection = connection_.lock()) {
+        (*connection)->releaseCredit(stream_id_, length);
+    }
+}
+
+void Http2Client::returnCredit(uint32_t stream_id, int64_t& window, int64_t& credit, uint32_t size) {
+    // 累计到窗口的一半再归还，避免每个 DATA 帧都产生一个 WINDOW_UPDATE；
+    // 窗口缩小后额度为负，先抵扣掉缩小的部分
+    if (credit > 0 && credit >= size / 2) {
+        sendWindowUpdate(stream_id, static_cast<uint32_t>(credit));
+        window += credit;
+        credit = 0;
+    }
+}
+
+void Http2Client::sampleData(uint32_t length, bool end_stream) {
+    if (!autotune_) {
+        return;
+    }
+    if (bdp_ping_pending_) {
+        bdp_bytes_ += length;
+        return;
+    }
+    if (end_stream) {
+        return;  // 单帧的小响应不值得测量
+    }
+    ++bdp_ping_id_;
+    uint8_t payload[8];
+    for (int i = 0; i < 8; ++i) {
+        payload[i] = static_cast<uint8_t>(bdp_ping_id_ >> (56 - 8 * i));
+    }
+    if (sendFrame(FRAME_TYPE_PING, 0, 0, payload, sizeof(payload))) {
+        bdp_ping_pending_ = true;
+        bdp_ping_sent_ = std::chrono::steady_clock::now();
+        bdp_bytes_ = length;
+        ++flow_stats_.pings;
+    }
+}
+
+void Http2Client::onBdpSample() {
+    bdp_ping_pending_ = false;
+    auto rtt = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - bdp_ping_sent_);
+    rtt = std::max(rtt, std::chrono::microseconds(1));
+    flow_stats_.rtt = flow_stats_.rtt.count() == 0 ? rtt : (flow_stats_.rtt * 7 + rtt) / 8;
+    flow_stats_.bdp = bdp_bytes_;
+    flow_stats_.delivery_rate = bdp_bytes_ * 1000000 / static_cast<uint64_t>(rtt.count());
+
+    uint32_t stream_window =
+        tuneWindow(stream_window_target_, stream_window_size_, autotune_max_window_, bdp_bytes_);
+    uint32_t connection_window =
+        tuneWindow(connection_window_target_, connection_window_size_, autotune_max_window_, bdp_bytes_);
+    if (stream_window > stream_window_target_ || connection_window > connection_window_target_) {
+        ++flow_stats_.increases;
+    } else if (stream_window < stream_window_target_ || connection_window < connection_window_target_) {
+        ++flow_stats_.decreases;
+    }
+    setWindowTargets(stream_window, connection_window);
+}
+
+uint32_t Http2Client::tuneWindow(uint32_t current, uint32_t base, uint32_t max_window, uint64_t bdp) {
+    uint64_t doubled = bdp * 2;
+    if (bdp * 3 >= uint64_t(current) * 2) {
+        return static_cast<uint32_t>(std::max<uint64_t>(current, std::min<uint64_t>(max_window, doubled)));
+    }
+    if (bdp * 4 < current) {
+        return static_cast<uint32_t>(std::max<uint64_t>(base, std::max<uint64_t>(doubled, current / 2)));
+    }
+    return current;
+}
+
+void Http2Client::setWindowTargets(uint32_t stream_window, uint32_t connection_window) {
+    if (connection_window != connection_window_target_) {
+        recv_credit_ += static_cast<int64_t>(connection_window) - connection_window_target_;
+        connection_window_target_ = connection_window;
+        returnCredit(0, recv_window_, recv_credit_, connection_window_target_);
+    }
+    if (stream_window != stream_window_target_) {
+        stream_window_target_ = stream_window;
+        for (auto& [stream_id, stream] : streams_) {
+            uint32_t window_size = streamWindow(stream);
+            if (stream.state != StreamState::CLOSED && window_size != stream.window_size) {
+                stream.recv_credit += static_cast<int64_t>(window_size) - stream.window_size;
+                stream.window_size = window_size;
+                returnCredit(stream_id, stream.recv_window, stream.recv_credit, stream.window_size);
+            }
         }
+    }
+}
+
+void Http2Client::resetStream(uint32_t stream_id, Stream& stream, uint32_t error_code) {
+    const uint8_t payload[] = {static_cast<uint8_t>(error_code >> 24), static_cast<uint8_t>(error_code >> 16),
+                               static_cast<uint8_t>(error_code >> 8), static_cast<uint8_t>(error_code)};
+    sendFrame(FRAME_TYPE_RST_STREAM, 0, stream_id, payload, sizeof(payload));
+    closeStream(stream_id, stream, error_code);
+}
+
+void Http2Client::scheduleFlush() {
+    if (flush_scheduled_) {
+        return;
+    }
+    flush_scheduled_ = true;
+    flush_task_ = loop_->defer([this] {
+        flush_scheduled_ = false;
+        if (!flush()) {
+            failConnection(2);  // INTERNAL_ERROR
+        }
+    });
+}
+
+bool Http2Client::flush() {
+    if (!ssl_) {
         return false;
     }
-    
-    // 解析长度（3字节，大端）
-    uint32_t length = ((uint32_t)header[0] << 16) | ((uint32_t)header[1] << 8) | header[2];
-    
-    // 解析类型
-    type = header[3];
-    
-    // 解析标志
-    flags = header[4];
-    
-    // 解析流ID
-    stream_id = (((uint32_t)header[5] & 0x7F) << 24) | 
-                ((uint32_t)header[6] << 16) | 
-                ((uint32_t)header[7] << 8) | 
-                header[8];
-    
-    // 检查帧长度是否合理
-    if (length > 16384) {  // 默认最大帧大小
-        std::cerr << "WARNING: Frame length " << length << " exceeds expected size" << std::endl;
+    if (!flushOutput()) {
+        return false;
     }
-    
-    // 读取负载
-    payload.clear();
-    if (length > 0) {
-        payload.resize(length);
-        int read_bytes = socketRead(payload.data(), length);
-        if (read_bytes != (int)length) {
-            std::cerr << "Failed to read frame payload. Expected: " << length 
-                     << ", Got: " << read_bytes << std::endl;
-            // 继续处理，可能是SETTINGS ACK没有负载
-            if (read_bytes > 0) {
-                payload.resize(read_bytes);
-            } else {
-                payload.clear();
+    updateInterest();
+    return true;
+}
+
+uint32_t Http2Client::applyPeerSettings(const uint8_t* payload, size_t length) {
+    // 每个参数：2字节标识符 + 4字节值
+    for (size_t pos = 0; pos + 6 <= length; pos += 6) {
+        uint16_t id = ((uint16_t)payload[pos] << 8) | payload[pos + 1];
+        uint32_t value = ((uint32_t)payload[pos + 2] << 24) | ((uint32_t)payload[pos + 3] << 16) |
+                         ((uint32_t)payload[pos + 4] << 8) | payload[pos + 5];
+        if (id == 0x1) {  // SETTINGS_HEADER_TABLE_SIZE：编码器动态表的上限
+            encoder_.setMaxTableSize(std::min<uint32_t>(value, MAX_ENCODER_TABLE_SIZE));
+        } else if (id == 0x2) {  // SETTINGS_ENABLE_PUSH：服务器只能发送 0
+            if (value != 0) {
+                std::cerr << "Invalid SETTINGS_ENABLE_PUSH from server: " << value << std::endl;
+                return 1;  // PROTOCOL_ERROR
+            }
+        } else if (id == 0x3) {  // SETTINGS_MAX_CONCURRENT_STREAMS
+            peer_max_concurrent_streams_ = value;
+        } else if (id == 0x4) {  // SETTINGS_INITIAL_WINDOW_SIZE
+            if (value > MAX_WINDOW_SIZE) {
+                std::cerr << "Invalid SETTINGS_INITIAL_WINDOW_SIZE: " << value << std::endl;
+                return 3;  // FLOW_CONTROL_ERROR
+            }
+            // 新的初始窗口按差值作用于所有已打开的流（RFC 9113 6.9.2）
+            int64_t delta = static_cast<int64_t>(value) - peer_initial_window_size_;
+            for (auto& [stream_id, stream] : streams_) {
+                stream.send_window += delta;
+                if (stream.send_window > MAX_WINDOW_SIZE) {
+                    std::cerr << "Stream " << stream_id << " send window overflow" << std::endl;
+                    return 3;  // FLOW_CONTROL_ERROR
+                }
             }
+            peer_initial_window_size_ = value;
+        } else if (id == 0x5) {  // SETTINGS_MAX_FRAME_SIZE
+            if (value < DEFAULT_MAX_FRAME_SIZE || value > MAX_ALLOWED_FRAME_SIZE) {
+                std::cerr << "Invalid SETTINGS_MAX_FRAME_SIZE: " << value << std::endl;
+                return 1;  // PROTOCOL_ERROR
+            }
+            peer_max_frame_size_ = value;
+        } else if (id == 0x6) {  // SETTINGS_MAX_HEADER_LIST_SIZE
+            peer_max_header_list_size_ = value;
         }
     }
-    
-    return true;
+    return 0;
+}
+
+RequestTemplate& Http2Client::requestTemplate(const std::string& method) {
+    auto it = request_templates_.find(method);
+    if (it == request_templates_.end()) {
+        it = request_templates_.emplace(method, RequestTemplate({
+            {":method", method},
+            {":scheme", "https"},
+            {":authority", host_},
+        })).first;
+    }
+    return it->second;
 }
 
 bool Http2Client::sendHeadersFrame(uint32_t stream_id, const std::string& method,
                                   const std::string& path,
                                   const std::vector<std::pair<std::string, std::string>>& headers,
                                   bool end_stream) {
-    // 手动构建HPACK编码的头部
-    // 使用静态表的索引和字面值编码
-    std::vector<uint8_t> encoded_headers;
-    
-    std::cout << "Encoding headers for request:" << std::endl;
-    
-    // :method GET = static table index 2
-    std::cout << "  :method: " << method << " (static index 2)" << std::endl;
-    encoded_headers.push_back(0x82);  // 10000010 = indexed header field, index 2
-    
-    // :scheme https = static table index 7
-    std::cout << "  :scheme: https (static index 7)" << std::endl;
-    encoded_headers.push_back(0x87);  // 10000111 = indexed header field, index 7
-    
-    // Helper lambda to encode a string according to RFC 7541
-    auto encodeString = [](const std::string& str) -> std::vector<uint8_t> {
-        std::vector<uint8_t> encoded;
-        uint64_t length = str.length();
-        
-        // H flag = 0 (not Huffman encoded), then encode length with 7-bit prefix
-        if (length < 127) {
-            encoded.push_back(static_cast<uint8_t>(length));
-        } else {
-            encoded.push_back(127);  // 7 bits all set to 1
-            length -= 127;
-            
-            while (length >= 128) {
-                encoded.push_back(static_cast<uint8_t>((length & 0x7F) | 0x80));
-                length >>= 7;
-            }
-            encoded.push_back(static_cast<uint8_t>(length & 0x7F));
-        }
-        
-        // Append string data
-        encoded.insert(encoded.end(), str.begin(), str.end());
-        return encoded;
-    };
-    
-    // :authority = static table index 1, literal value
-    std::cout << "  :authority: " << host_ << std::endl;
-    encoded_headers.push_back(0x41);  // 01000001 = literal with incremental indexing, index 1
-    auto authority_encoded = encodeString(host_);
-    encoded_headers.insert(encoded_headers.end(), authority_encoded.begin(), authority_encoded.end());
-    
-    // :path = static table index 4, literal value
-    std::cout << "  :path: " << path << std::endl;
+    // 固定部分（:method、:scheme、:authority）由模板缓存，
+    // 只有 :path 和自定义头需要逐次编码；头块直接写入写队列
+    if (!ssl_) {
+        std::cerr << "Failed to send HEADERS frame" << std::endl;
+        return false;
+    }
     std::string full_path = path.empty() ? "/" : path;
-    encoded_headers.push_back(0x44);  // 01000100 = literal with incremental indexing, index 4
-    auto path_encoded = encodeString(full_path);
-    encoded_headers.insert(encoded_headers.end(), path_encoded.begin(), path_encoded.end());
-    
-    // Add custom headers if any
-    for (const auto& [name, value] : headers) {
-        std::cout << "  " << name << ": " << value << std::endl;
-        // Use literal without indexing (0000xxxx)
-        encoded_headers.push_back(0x00);  // Literal without indexing
-        // Encode name as string
-        auto name_encoded = encodeString(name);
-        encoded_headers.insert(encoded_headers.end(), name_encoded.begin(), name_encoded.end());
-        // Encode value as string
-        auto value_encoded = encodeString(value);
-        encoded_headers.insert(encoded_headers.end(), value_encoded.begin(), value_encoded.end());
+
+    // 内存治理器调整了解码器表大小时重新通告
+    if (decoder_.advertisedTableSize() != advertised_table_size_ && !sendSettings()) {
+        return false;
     }
     
-    std::cout << "Encoded headers size: " << encoded_headers.size() << " bytes" << std::endl;
+    HeaderFrameBuilder builder(send_buffer_, stream_id, peer_max_frame_size_);
+    requestTemplate(method).encode(encoder_, {{":path", full_path}}, builder.block());
+    encoder_.encodeFields(headers, builder.block());
+    builder.finish(end_stream);
     
-    // 发送HEADERS帧
-    uint8_t flags = FLAG_END_HEADERS;
-    if (end_stream) {
-        flags |= FLAG_END_STREAM;
+    scheduleFlush();
+    return true;
+}
+
+namespace {
+
+// 解析 :status 的三位数字，格式异常时按 200 处理
+int parseStatusCode(std::string_view value) {
+    if (value.empty() || value.size() > 3) {
+        return 200;
     }
-    
-    if (!sendFrame(FRAME_TYPE_HEADERS, flags, stream_id, encoded_headers)) {
-        std::cerr << "Failed to send HEADERS frame" << std::endl;
+    int code = 0;
+    for (char c : value) {
+        if (c < '0' || c > '9') {
+            return 200;
+        }
+        code = code * 10 + (c - '0');
+    }
+    return code;
+}
+
+// 去掉 HEADERS/DATA 帧负载中的填充和优先级字段，格式错误时返回 false
+bool stripPaddingAndPriority(FrameView& frame, bool has_priority) {
+    size_t start = 0;
+    size_t padding = 0;
+    if (frame.header.flags & FLAG_PADDED) {
+        if (frame.length == 0) {
+            return false;
+        }
+        padding = frame.payload[0];
+        start = 1;
+    }
+    if (has_priority && (frame.header.flags & FLAG_PRIORITY)) {
+        start += 5;
+    }
+    if (start + padding > frame.length) {
         return false;
     }
-    
-    std::cout << "HEADERS frame sent successfully" << std::endl;
+    frame.payload += start;
+    frame.length -= start + padding;
     return true;
 }
 
-Http2Client::Response Http2Client::receiveResponse(uint32_t stream_id) {
-    Response response;
-    response.status_code = 200;  // 默认200
-    
-    std::vector<uint8_t> header_block;
-    int frames_received = 0;
-    const int MAX_FRAMES = 100;  // 防止无限循环
-    
-    while (frames_received < MAX_FRAMES) {
-        frames_received++;
-        uint8_t type;
-        uint8_t flags;
-        uint32_t recv_stream_id;
-        std::vector<uint8_t> payload;
-        
-        if (!recvFrame(type, flags, recv_stream_id, payload)) {
-            std::cerr << "Failed to receive frame" << std::endl;
+const char* errorCodeName(uint32_t error_code) {
+    switch (error_code) {
+        case 0: return "NO_ERROR";
+        case 1: return "PROTOCOL_ERROR";
+        case 2: return "INTERNAL_ERROR";
+        case 3: return "FLOW_CONTROL_ERROR";
+        case 4: return "SETTINGS_TIMEOUT";
+        case 5: return "STREAM_CLOSED";
+        case 6: return "FRAME_SIZE_ERROR";
+        case 7: return "REFUSED_STREAM";
+        case 8: return "CANCEL";
+        case 9: return "COMPRESSION_ERROR";
+        case 10: return "CONNECT_ERROR";
+        case 11: return "ENHANCE_YOUR_CALM";
+        case 12: return "INADEQUATE_SECURITY";
+    }
+    return "UNKNOWN";
+}
+
+// 头字段列表大小：每个字段的名称、值长度加 32 字节开销（RFC 9113 6.5.2）
+size_t headerListSize(const std::vector<std::pair<std::string, std::string>>& headers) {
+    size_t size = 0;
+    for (const auto& [name, value] : headers) {
+        size += name.size() + value.size() + 32;
+    }
+    return size;
+}
+
+uint32_t readUint32(const uint8_t* data) {
+    return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) |
+           ((uint32_t)data[2] << 8) | data[3];
+}
+
+} // namespace
+
+uint32_t Http2Client::submit(const std::string& method, const std::string& path,
+                             const std::vector<std::pair<std::string, std::string>>& headers) {
+    if (!isConnected()) {
+        std::cerr << "Not connected" << std::endl;
+        return 0;
+    }
+
+    // 达到对端的 SETTINGS_MAX_CONCURRENT_STREAMS 时先运行事件循环，等待流结束
+    runUntil([this] { return active_streams_ < peer_max_concurrent_streams_ || !isConnected(); });
+    if (active_streams_ >= peer_max_concurrent_streams_) {
+        std::cerr << "Timed out waiting for a free stream slot" << std::endl;
+        return 0;
+    }
+    return openStream(method, path, headers, nullptr, StreamHandler());
+}
+
+void Http2Client::submitAsync(const std::string& method, const std::string& path,
+                              const std::vector<std::pair<std::string, std::string>>& headers,
+                              ResponseCallback on_response, StreamHandler handler) {
+    if (state_ == ConnectionState::DISCONNECTED || goaway_received_) {
+        Response response;
+        response.error_code = 7;  // REFUSED_STREAM：请求未发出，可以重试
+        on_response(std::move(response));
+        return;
+    }
+
+    // 连接尚未就绪或并发流已满时排队，流结束后按提交顺序发出
+    pending_requests_.push_back({method, path, headers, std::move(on_response), std::move(handler)});
+    startPendingRequests();
+}
+
+uint32_t Http2Client::openStream(const std::string& method, const std::string& path,
+                                 const std::vector<std::pair<std::string, std::string>>& headers,
+                                 ResponseCallback on_response, StreamHandler handler) {
+    if (goaway_received_) {
+        std::cerr << "Connection is going away, cannot open new streams" << std::endl;
+        return 0;
+    }
+    if (next_stream_id_ > MAX_STREAM_ID) {
+        std::cerr << "Stream IDs exhausted on this connection" << std::endl;
+        return 0;
+    }
+
+    // 超过对端 SETTINGS_MAX_HEADER_LIST_SIZE 的请求必然被拒绝，不发送
+    size_t list_size = headerListSize(requestTemplate(method).fixedHeaders()) +
+                       headerListSize(headers) + std::strlen(":path") + std::max<size_t>(path.size(), 1) + 32;
+    if (list_size > peer_max_header_list_size_) {
+        std::cerr << "Request header list (" << list_size << " bytes) exceeds peer's "
+                  << "SETTINGS_MAX_HEADER_LIST_SIZE " << peer_max_header_list_size_ << std::endl;
+        return 0;
+    }
+
+    // 客户端发起的流使用奇数ID，且必须单调递增
+    uint32_t stream_id = next_stream_id_;
+    next_stream_id_ += 2;
+
+    if (!sendHeadersFrame(stream_id, method, path, headers, true)) {
+        std::cerr << "Failed to send " << method << " request" << std::endl;
+        return 0;
+    }
+
+    // 请求没有请求体，HEADERS 携带 END_STREAM，本端立即半关闭
+    Stream& stream = streams_[stream_id];
+    stream.state = StreamState::HALF_CLOSED_LOCAL;
+    stream.response.status_code = 200;  // 默认200
+    stream.on_response = std::move(on_response);
+    stream.handler = std::move(handler);
+    stream.deferred_credit = static_cast<bool>(stream.handler.on_open);
+    stream.recv_window = stream_window_size_;
+    stream.window_size = streamWindow(stream);
+    // 首个 DATA 后补足（或扣留）到流的窗口大小
+    stream.recv_credit = static_cast<int64_t>(stream.window_size) - stream_window_size_;
+    stream.send_window = peer_initial_window_size_;
+    ++active_streams_;
+    if (stream.deferred_credit) {
+        stream.handler.on_open(StreamCredit(connection_token_, stream_id));
+    }
+    return stream_id;
+}
+
+Http2Client::Response Http2Client::wait(uint32_t stream_id) {
+    auto it = streams_.find(stream_id);
+    if (it == streams_.end()) {
+        return Response();
+    }
+
+    // 事件循环可能分发其他流的帧；流表节点地址在插入和删除其他流时保持不变
+    Stream& stream = it->second;
+    if (!runUntil([&stream] { return stream.state == StreamState::CLOSED; })) {
+        std::cerr << "Timed out waiting for stream " << stream_id << std::endl;
+        // 放弃该流：通知对端取消，之后到达的帧按未知流处理
+        resetStream(stream_id, stream, 8);  // CANCEL
+    }
+
+    Response response = std::move(stream.response);
+    streams_.erase(stream_id);
+    return response;
+}
+
+size_t Http2Client::activeStreams() const {
+    return active_streams_;
+}
+
+size_t Http2Client::templateHits() const {
+    size_t hits = 0;
+    for (const auto& [method, request_template] : request_templates_) {
+        hits += request_template.hits();
+    }
+    return hits;
+}
+
+void Http2Client::setReceiveWindow(uint32_t stream_window, uint32_t connection_window) {
+    stream_window_size_ = std::min(stream_window, MAX_WINDOW_SIZE);
+    connection_window_size_ = std::clamp(connection_window, DEFAULT_WINDOW_SIZE, MAX_WINDOW_SIZE);
+}
+
+void Http2Client::setMaxFrameSize(uint32_t size) {
+    local_max_frame_size_ = std::clamp(size, DEFAULT_MAX_FRAME_SIZE, MAX_ALLOWED_FRAME_SIZE);
+}
+
+void Http2Client::setMaxHeaderListSize(uint32_t size) {
+    local_max_header_list_size_ = size;
+}
+
+void Http2Client::setStreamBufferLimit(uint32_t limit) {
+    stream_buffer_limit_ = std::clamp(limit, 1u, MAX_WINDOW_SIZE);
+}
+
+void Http2Client::setWindowAutoTuning(bool enabled, uint32_t max_window) {
+    autotune_ = enabled;
+    autotune_max_window_ = std::min(max_window, MAX_WINDOW_SIZE);
+}
+
+Http2Client::FlowControlStats Http2Client::flowControlStats() const {
+    FlowControlStats stats = flow_stats_;
+    stats.stream_window = stream_window_target_;
+    stats.connection_window = connection_window_target_;
+    return stats;
+}
+
+void Http2Client::setTimeout(int timeout_ms) {
+    timeout_ms_ = timeout_ms;
+}
+
+bool Http2Client::dispatchFrame(FrameView& frame) {
+    uint8_t type = frame.header.type;
+    uint8_t flags = frame.header.flags;
+    uint32_t stream_id = frame.header.stream_id;
+
+    // 头块必须连续传输：未结束的头块之后只能是同一流的 CONTINUATION
+    if (header_block_stream_ != 0 &&
+        (type != FRAME_TYPE_CONTINUATION || stream_id != header_block_stream_)) {
+        std::cerr << "Expected CONTINUATION for stream " << header_block_stream_ << std::endl;
+        failOpenStreams(0, 1);
+        return false;
+    }
+
+    switch (type) {
+        case FRAME_TYPE_SETTINGS: {
+            if (stream_id != 0 || (flags & FLAG_ACK ? frame.length != 0 : frame.length % 6 != 0)) {
+                std::cerr << "Malformed SETTINGS frame" << std::endl;
+                failOpenStreams(0, stream_id != 0 ? 1 : 6);  // PROTOCOL_ERROR / FRAME_SIZE_ERROR
+                return false;
+            }
+            // 应用参数并发送SETTINGS ACK
+            if (!(flags & FLAG_ACK)) {
+                if (uint32_t error_code = applyPeerSettings(frame.payload, frame.length)) {
+                    failOpenStreams(0, error_code);
+                    return false;
+                }
+                if (!sendFrame(FRAME_TYPE_SETTINGS, FLAG_ACK, 0)) {
+                    return false;
+                }
+                // 服务器的第一个SETTINGS帧完成连接建立
+                if (state_ == ConnectionState::AWAITING_SETTINGS) {
+                    state_ = ConnectionState::READY;
+                    finishConnect(true);
+                }
+                // 排队的请求在本批帧处理完后（deliverCompleted）发出：服务器常把
+                // MAX_CONCURRENT_STREAMS 放在紧随其后的另一个 SETTINGS 帧中
+            }
             break;
         }
-        
-        std::cout << "Received frame type: " << (int)type << " flags: " << (int)flags 
-                  << " stream_id: " << recv_stream_id << " payload_size: " << payload.size() << std::endl;
-        
-        // 处理不同的帧类型
-        switch (type) {
-            case FRAME_TYPE_SETTINGS: {
-                // 发送SETTINGS ACK
-                if (!(flags & 0x01)) { // 如果没有设置ACK标志
-                    std::cout << "Sending SETTINGS ACK" << std::endl;
-                    sendFrame(FRAME_TYPE_SETTINGS, 0x01, 0, {});
+
+        case FRAME_TYPE_PUSH_PROMISE: {
+            // 已通告 SETTINGS_ENABLE_PUSH = 0
+            std::cerr << "Received PUSH_PROMISE with push disabled" << std::endl;
+            failOpenStreams(0, 1);  // PROTOCOL_ERROR
+            return false;
+        }
+
+        case FRAME_TYPE_PING: {
+            // 发送PING ACK
+            if (!(flags & FLAG_ACK)) {
+                sendFrame(FRAME_TYPE_PING, FLAG_ACK, 0, frame.payload, frame.length);
+            } else if (bdp_ping_pending_ && frame.length == 8) {
+                uint64_t id = 0;
+                for (int i = 0; i < 8; ++i) {
+                    id = (id << 8) | frame.payload[i];
+                }
+                if (id == bdp_ping_id_) {
+                    onBdpSample();
                 }
-                break;
             }
-            
-            case FRAME_TYPE_PING: {
-                // 发送PING ACK
-                std::cout << "Received PING, sending PONG" << std::endl;
-                std::vector<uint8_t> ping_data(payload.begin(), payload.end());
-                sendFrame(FRAME_TYPE_PING, 0x01, 0, ping_data);
-                break;
+            break;
+        }
+
+        case FRAME_TYPE_HEADERS:
+        case FRAME_TYPE_CONTINUATION: {
+            // CONTINUATION 只能接在未结束的头块之后（RFC 9113 6.10）
+            if (type == FRAME_TYPE_CONTINUATION && header_block_stream_ == 0) {
+                std::cerr << "CONTINUATION without an open header block on stream " << stream_id << std::endl;
+                goAway(1);  // PROTOCOL_ERROR
+                return false;
+            }
+            // 头块不解码就无法与对端保持动态表同步，超限时只能关闭连接（RFC 9113 4.3）
+            if (header_block_.size() + frame.length > local_max_header_list_size_) {
+                std::cerr << "Header block on stream " << stream_id << " exceeds "
+                          << local_max_header_list_size_ << " bytes" << std::endl;
+                header_block_.clear();
+                header_block_stream_ = 0;
+                goAway(9);  // COMPRESSION_ERROR
+                return false;
             }
-            
-            case FRAME_TYPE_HEADERS: {
-                if (recv_stream_id == stream_id) {
-                    std::cout << "\n=== Received HEADERS Frame ===" << std::endl;
-                    std::cout << "Stream ID: " << stream_id << std::endl;
-                    std::cout << "Payload size: " << payload.size() << " bytes" << std::endl;
-                    
-                    header_block.insert(header_block.end(), payload.begin(), payload.end());
-                    
-                    if (flags & FLAG_END_HEADERS) {
-                        std::cout << "\n=== Header Block Complete (END_HEADERS flag set) ===" << std::endl;
-                        std::cout << "Total header block size: " << header_block.size() << " bytes\n" << std::endl;
-                        
-                        // Show hex dump of the header block
-                        std::cout << "Header block hex dump:" << std::endl;
-                        for (size_t i = 0; i < header_block.size(); ++i) {
-                            if (i % 16 == 0) {
-                                std::cout << "  " << std::hex << std::setfill('0') << std::setw(4) << i << ": ";
-                            }
-                            std::cout << std::hex << std::setfill('0') << std::setw(2) << (int)header_block[i] << " ";
-                            if (i % 16 == 15) {
-                                std::cout << std::endl;
-                            }
-                        }
-                        if (header_block.size() % 16 != 0) {
-                            std::cout << std::endl;
-                        }
-                        std::cout << std::dec << std::endl;
-                        
-                        // 尝试解码头部
-                        std::cout << "=== Decoding Headers ===" << std::endl;
-                        try {
-                            auto decoded = HPACK::decode(header_block);
-                            std::cout << "\nSuccessfully decoded " << decoded.size() << " headers:" << std::endl;
-                            for (const auto& [name, value] : decoded) {
-                                if (name == ":status") {
-                                    try {
-                                        response.status_code = std::stoi(value);
-                                    } catch (...) {
-                                        response.status_code = 200;
-                                    }
-                                    std::cout << "  " << name << ": " << value << " (HTTP Status)" << std::endl;
-                                } else {
-                                    response.headers.push_back({name, value});
-                                    std::cout << "  " << name << ": " << value << std::endl;
-                                }
-                            }
-                        } catch (const std::exception& e) {
-                            std::cerr << "\n✗ Error decoding headers: " << e.what() << std::endl;
-                            std::cerr << "Continuing without decoded headers..." << std::endl;
-                        }
-                    }
-                    if (flags & FLAG_END_STREAM) {
-                        std::cout << "\nResponse stream ended" << std::endl;
-                        return response;
-                    }
+            if (type == FRAME_TYPE_HEADERS) {
+                if (!stripPaddingAndPriority(frame, true)) {
+                    std::cerr << "Malformed HEADERS frame on stream " << stream_id << std::endl;
+                    failOpenStreams(0, 1);
+                    return false;
+                }
+                header_block_stream_ = stream_id;
+                header_block_end_stream_ = (flags & FLAG_END_STREAM) != 0;
+                if (flags & FLAG_END_HEADERS) {
+                    // 单帧头块：直接从接收环解码
+                    return onHeaderBlock(stream_id, frame.payload, frame.length);
                 }
+            }
+            header_block_.insert(header_block_.end(), frame.payload, frame.payload + frame.length);
+            if (flags & FLAG_END_HEADERS) {
+                return onHeaderBlock(stream_id, header_block_.data(), header_block_.size());
+            }
+            break;
+        }
+
+        case FRAME_TYPE_DATA: {
+            // 整个负载（包括填充）都计入流量控制
+            uint32_t flow_length = frame.header.length;
+            if (flow_length > recv_window_) {
+                std::cerr << "Connection flow control window exceeded" << std::endl;
+                failOpenStreams(0, 3);  // FLOW_CONTROL_ERROR
+                return false;
+            }
+            recv_window_ -= flow_length;
+            sampleData(flow_length, (flags & FLAG_END_STREAM) != 0);
+
+            auto it = streams_.find(stream_id);
+            if (it == streams_.end() || it->second.state == StreamState::CLOSED) {
+                consumeData(stream_id, nullptr, flow_length);
+                break;  // 已放弃或已结束的流：只归还连接级额度
+            }
+            Stream& stream = it->second;
+            if (flow_length > stream.recv_window) {
+                std::cerr << "Stream " << stream_id << " flow control window exceeded" << std::endl;
+                resetStream(stream_id, stream, 3);  // FLOW_CONTROL_ERROR
+                consumeData(stream_id, nullptr, flow_length);
                 break;
             }
-            
-            case FRAME_TYPE_DATA: {
-                if (recv_stream_id == stream_id) {
-                    std::cout << "Received DATA frame for stream " << stream_id 
-                              << " (" << payload.size() << " bytes)" << std::endl;
-                    response.body.insert(response.body.end(), payload.begin(), payload.end());
-                    if (flags & FLAG_END_STREAM) {
-                        std::cout << "Response stream ended" << std::endl;
-                        return response;
-                    }
-                }
+            stream.recv_window -= flow_length;
+            if (!stripPaddingAndPriority(frame, false)) {
+                resetStream(stream_id, stream, 1);  // PROTOCOL_ERROR
+                consumeData(stream_id, nullptr, flow_length);
                 break;
             }
-            
-            case FRAME_TYPE_GOAWAY: {
-                // 解析GOAWAY帧
-                uint32_t last_stream_id = 0;
-                uint32_t error_code = 0;
-                if (payload.size() >= 8) {
-                    last_stream_id = (((uint32_t)payload[0] & 0x7F) << 24) | 
-                                     ((uint32_t)payload[1] << 16) | 
-                                     ((uint32_t)payload[2] << 8) | 
-                                     payload[3];
-                    error_code = ((uint32_t)payload[4] << 24) | 
-                                ((uint32_t)payload[5] << 16) | 
-                                ((uint32_t)payload[6] << 8) | 
-                                payload[7];
+            if (stream.handler.on_data) {
+                // 流式模式：数据直接交给调用方，不在响应中累积
+                stream.handler.on_data(frame.payload, frame.length);
+            } else {
+                stream.response.body.insert(stream.response.body.end(), frame.payload,
+                                            frame.payload + frame.length);
+            }
+            // 流结束后不再需要流级额度；消费驱动的流只立即归还填充部分，
+            // 数据部分在调用方 consume() 之后归还
+            if (stream.deferred_credit) {
+                consumeData(stream_id, nullptr, flow_length);
+                if (!(flags & FLAG_END_STREAM)) {
+                    releaseCredit(stream_id, flow_length - frame.length);
                 }
-                
-                std::string error_name = "UNKNOWN";
-                switch (error_code) {
-                    case 0: error_name = "NO_ERROR"; break;
-                    case 1: error_name = "PROTOCOL_ERROR"; break;
-                    case 2: error_name = "INTERNAL_ERROR"; break;
-                    case 3: error_name = "FLOW_CONTROL_ERROR"; break;
-                    case 4: error_name = "SETTINGS_TIMEOUT"; break;
-                    case 5: error_name = "STREAM_CLOSED"; break;
-                    case 6: error_name = "FRAME_SIZE_ERROR"; break;
-                    case 7: error_name = "REFUSED_STREAM"; break;
-                    case 8: error_name = "CANCEL"; break;
-                    case 9: error_name = "COMPRESSION_ERROR"; break;
-                    case 10: error_name = "CONNECT_ERROR"; break;
-                    case 11: error_name = "ENHANCE_YOUR_CALM"; break;
-                    case 12: error_name = "INADEQUATE_SECURITY"; break;
+            } else {
+                consumeData(stream_id, (flags & FLAG_END_STREAM) ? nullptr : &stream, flow_length);
+            }
+            if (flags & FLAG_END_STREAM) {
+                closeStream(stream_id, it->second, 0);
+            }
+            break;
+        }
+
+        case FRAME_TYPE_RST_STREAM: {
+            auto it = streams_.find(stream_id);
+            if (it != streams_.end() && it->second.state != StreamState::CLOSED && frame.length >= 4) {
+                uint32_t error_code = readUint32(frame.payload);
+                std::cerr << "Stream " << stream_id << " reset: " << errorCodeName(error_code) << std::endl;
+                closeStream(stream_id, it->second, error_code);
+            }
+            break;
+        }
+
+        case FRAME_TYPE_GOAWAY: {
+            // 解析GOAWAY帧
+            uint32_t last_stream_id = 0;
+            uint32_t error_code = 0;
+            if (frame.length >= 8) {
+                last_stream_id = readUint32(frame.payload) & MAX_STREAM_ID;
+                error_code = readUint32(frame.payload + 4);
+            }
+            std::cerr << "Received GOAWAY frame: error=" << error_code << " (" << errorCodeName(error_code)
+                      << "), last_stream_id=" << last_stream_id << std::endl;
+
+            // 对端未处理 last_stream_id 之后的流，可以在新连接上重试；
+            // 其余的流在 NO_ERROR 时继续完成
+            goaway_received_ = true;
+            failOpenStreams(last_stream_id, 7);  // REFUSED_STREAM
+            if (error_code != 0) {
+                failOpenStreams(0, error_code);
+                return false;
+            }
+            break;
+        }
+
+        case FRAME_TYPE_WINDOW_UPDATE: {
+            if (frame.length != 4) {
+                std::cerr << "Malformed WINDOW_UPDATE frame" << std::endl;
+                failOpenStreams(0, 6);  // FRAME_SIZE_ERROR
+                return false;
+            }
+            uint32_t increment = readUint32(frame.payload) & MAX_WINDOW_SIZE;
+            if (stream_id == 0) {
+                send_window_ += increment;
+                if (increment == 0 || send_window_ > MAX_WINDOW_SIZE) {
+                    std::cerr << "Invalid connection WINDOW_UPDATE: " << increment << std::endl;
+                    failOpenStreams(0, increment == 0 ? 1 : 3);
+                    return false;
                 }
-                
-                std::cerr << "Received GOAWAY frame: error=" << error_code << " (" << error_name 
-                          << "), last_stream_id=" << last_stream_id << std::endl;
-                return response;
-            }
-            
-            case FRAME_TYPE_WINDOW_UPDATE: {
-                // 忽略WINDOW_UPDATE
                 break;
             }
-            
-            default:
-                // 忽略其他帧类型
-                std::cout << "Received unhandled frame type: " << (int)type << std::endl;
+            auto it = streams_.find(stream_id);
+            if (it == streams_.end() || it->second.state == StreamState::CLOSED) {
                 break;
+            }
+            it->second.send_window += increment;
+            if (increment == 0) {
+                resetStream(stream_id, it->second, 1);  // PROTOCOL_ERROR
+            } else if (it->second.send_window > MAX_WINDOW_SIZE) {
+                resetStream(stream_id, it->second, 3);  // FLOW_CONTROL_ERROR
+            }
+            break;
         }
+
+        default:
+            // 忽略其他帧类型
+            break;
     }
-    
-    if (frames_received >= MAX_FRAMES) {
-        std::cerr << "Reached maximum frame limit" << std::endl;
-    }
-    
-    return response;
+    return true;
 }
 
-bool Http2Client::connect() {
-    if (!createSocket()) {
+bool Http2Client::onHeaderBlock(uint32_t stream_id, const uint8_t* block, size_t length) {
+    // 放弃的流也必须解码头块，保持与对端的动态表同步
+    auto it = streams_.find(stream_id);
+    Stream* stream = it != streams_.end() && it->second.state != StreamState::CLOSED ? &it->second : nullptr;
+
+    try {
+        // 字段视图直接在流 arena 中构造，不经过临时字符串
+        bool valid = decoder_.decodeViews(block, length,
+                             [&](std::string_view name, std::string_view value) {
+            if (!stream) {
+                return;
+            }
+            if (stream->headers_complete) {
+                // 最终响应头之后的头块是尾部字段
+                stream->response.trailers.emplace_back(name, value);
+            } else if (name == ":status") {
+                stream->response.status_code = parseStatusCode(value);
+            } else {
+                stream->response.headers.emplace_back(name, value);
+            }
+        });
+        if (!valid) {
+            throw std::runtime_error("malformed header block");
+        }
+    } catch (const std::exception& e) {
+        // 解码失败后动态表已与对端不一致，连接无法继续使用（RFC 9113 4.3）
+        std::cerr << "\n✗ Error decoding headers: " << e.what() << std::endl;
+        goAway(9);  // COMPRESSION_ERROR
         return false;
     }
-    
-    if (!performTlsHandshake()) {
-        close(socket_fd_);
-        socket_fd_ = -1;
-        return false;
+
+    header_block_.clear();
+    header_block_stream_ = 0;
+    if (stream && !stream->headers_complete) {
+        if (stream->response.status_code < 200) {
+            // 1xx 信息响应：丢弃，继续等待最终响应头
+            stream->response.headers.clear();
+            stream->response.status_code = 200;
+        } else {
+            stream->headers_complete = true;
+            if (stream->handler.on_headers) {
+                stream->handler.on_headers(stream->response);
+            }
+        }
     }
-    
-    // 发送HTTP/2客户端前言
-    if (!sendClientPreface()) {
-        disconnect();
-        return false;
+    if (stream && header_block_end_stream_) {
+        closeStream(stream_id, *stream, 0);
     }
-    
-    // 发送空的SETTINGS帧
-    if (!sendSettings()) {
-        disconnect();
+    return true;
+}
+
+void Http2Client::closeStream(uint32_t stream_id, Stream& stream, uint32_t error_code) {
+    stream.state = StreamState::CLOSED;
+    stream.response.error_code = error_code;
+    --active_streams_;
+    if (stream.on_response) {
+        completed_.push_back(stream_id);
+    }
+}
+
+void Http2Client::failOpenStreams(uint32_t after_stream_id, uint32_t error_code) {
+    for (auto& [id, stream] : streams_) {
+        if (id > after_stream_id && stream.state != StreamState::CLOSED) {
+            closeStream(id, stream, error_code);
+        }
+    }
+}
+
+void Http2Client::goAway(uint32_t error_code) {
+    failOpenStreams(0, error_code);
+    // 不接受服务器推送，最后处理的对端发起流ID总是 0
+    const uint8_t payload[] = {0, 0, 0, 0,
+                               static_cast<uint8_t>(error_code >> 24), static_cast<uint8_t>(error_code >> 16),
+                               static_cast<uint8_t>(error_code >> 8), static_cast<uint8_t>(error_code)};
+    // 调用方随后关闭连接，尽力立即写出而不等延迟任务
+    if (sendFrame(FRAME_TYPE_GOAWAY, 0, 0, payload, sizeof(payload))) {
+        flush();
+    }
+}
+
+void Http2Client::deliverCompleted() {
+    // 回调可能提交新请求或结束其他流，因此逐个取出
+    while (!completed_.empty()) {
+        uint32_t stream_id = completed_.front();
+        completed_.pop_front();
+        auto it = streams_.find(stream_id);
+        if (it == streams_.end()) {
+            continue;
+        }
+        ResponseCallback on_response = std::move(it->second.on_response);
+        Response response = std::move(it->second.response);
+        streams_.erase(it);
+        on_response(std::move(response));
+    }
+    startPendingRequests();
+}
+
+void Http2Client::startPendingRequests() {
+    while (state_ == ConnectionState::READY && !pending_requests_.empty() &&
+           active_streams_ < peer_max_concurrent_streams_) {
+        PendingRequest request = std::move(pending_requests_.front());
+        pending_requests_.pop_front();
+        if (openStream(request.method, request.path, request.headers,
+                       request.on_response, std::move(request.handler)) == 0) {
+            Response response;
+            response.error_code = 7;  // REFUSED_STREAM
+            request.on_response(std::move(response));
+        }
+    }
+}
+
+void Http2Client::failConnection(uint32_t error_code) {
+    if (state_ != ConnectionState::READY) {
+        finishConnect(false);
+    }
+    failOpenStreams(0, error_code);
+    cleanup();
+
+    // 排队的请求从未发出
+    while (!pending_requests_.empty()) {
+        PendingRequest request = std::move(pending_requests_.front());
+        pending_requests_.pop_front();
+        Response response;
+        response.error_code = 7;  // REFUSED_STREAM
+        request.on_response(std::move(response));
+    }
+    deliverCompleted();
+}
+
+void Http2Client::finishConnect(bool connected) {
+    ConnectCallback on_connected = std::move(connect_callback_);
+    connect_callback_ = nullptr;
+    if (on_connected) {
+        on_connected(connected);
+    }
+}
+
+bool Http2Client::runUntil(const std::function<bool()>& done) {
+    if (parsing_ && !done()) {
+        std::cerr << "Synchronous call from a frame callback of the same connection" << std::endl;
         return false;
     }
-    
-    // 接收和处理服务器初始化帧
-    std::cout << "Waiting for server initialization..." << std::endl;
-    
-    int settings_count = 0;
-    for (int i = 0; i < 20; ++i) {
-        uint8_t type;
-        uint8_t flags;
-        uint32_t stream_id;
-        std::vector<uint8_t> payload;
-        
-        if (!recvFrame(type, flags, stream_id, payload)) {
-            std::cerr << "Timeout reading initialization frames" << std::endl;
-            break;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms_);
+    while (!done()) {
+        if (state_ == ConnectionState::DISCONNECTED) {
+            return done();
         }
-        
-        std::cout << "Init frame #" << (i+1) << " - Type: " << (int)type 
-                  << " Flags: " << (int)flags << " Stream: " << stream_id 
-                  << " Payload size: " << payload.size() << std::endl;
-        
-        switch (type) {
-            case FRAME_TYPE_SETTINGS: {
-                settings_count++;
-                if (!(flags & 0x01)) {  // ACK flag
-                    // 如果不是ACK，则发送ACK
-                    std::cout << "Sending SETTINGS ACK" << std::endl;
-                    sendFrame(FRAME_TYPE_SETTINGS, 0x01, 0, {});
-                }
-                if (settings_count >= 1) {
-                    std::cout << "Server SETTINGS received, ready for requests" << std::endl;
-                    return true;
-                }
-                break;
-            }
-            
-            case FRAME_TYPE_WINDOW_UPDATE: {
-                // 忽略WINDOW_UPDATE
-                std::cout << "Ignoring WINDOW_UPDATE" << std::endl;
-                break;
-            }
-            
-            case FRAME_TYPE_GOAWAY: {
-                std::cerr << "Received GOAWAY during initialization" << std::endl;
-                return false;
-            }
-            
-            default:
-                std::cout << "Unexpected frame type: " << (int)type << " during init" << std::endl;
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (remaining <= 0) {
+            return false;
         }
+        loop_->runOnce(static_cast<int>(remaining));
     }
-    
     return true;
 }
 
+void Http2Client::connectAsync(ConnectCallback on_connected) {
+    if (state_ != ConnectionState::DISCONNECTED) {
+        cleanup();
+    }
+
+    // 新连接的HPACK上下文从空动态表开始（保留已分配的缓冲区）
+    encoder_.reset();
+    decoder_.reset();
+    encoder_.setMemoryGovernor(&HpackMemoryGovernor::global());
+    decoder_.setMemoryGovernor(&HpackMemoryGovernor::global());
+    advertised_table_size_ = 4096;
+    request_templates_.clear();
+    peer_max_frame_size_ = DEFAULT_MAX_FRAME_SIZE;
+    peer_max_header_list_size_ = UINT32_MAX;
+    stream_window_target_ = stream_window_size_;
+    connection_window_target_ = connection_window_size_;
+    recv_window_ = DEFAULT_WINDOW_SIZE;
+    recv_credit_ = 0;
+    bdp_ping_pending_ = false;
+    bdp_bytes_ = 0;
+    flow_stats_ = FlowControlStats();
+    connection_token_ = std::make_shared<Http2Client*>(this);
+    send_window_ = DEFAULT_WINDOW_SIZE;
+    peer_initial_window_size_ = DEFAULT_WINDOW_SIZE;
+    streams_.clear();
+    completed_.clear();
+    next_stream_id_ = 1;
+    active_streams_ = 0;
+    peer_max_concurrent_streams_ = UINT32_MAX;
+    header_block_.clear();
+    header_block_stream_ = 0;
+    goaway_received_ = false;
+    reader_.clear();
+    send_buffer_.clear();
+    send_offset_ = 0;
+    want_write_ = false;
+    connect_callback_ = std::move(on_connected);
+
+    if (!createSocket()) {
+        finishConnect(false);
+        return;
+    }
+    state_ = ConnectionState::CONNECTING;
+    if (!loop_->add(socket_fd_, EPOLLOUT, [this](uint32_t events) { onSocketEvent(events); })) {
+        std::cerr << "Failed to register socket with event loop" << std::endl;
+        failConnection(2);
+    }
+}
+
+bool Http2Client::connect() {
+    if (parsing_) {
+        std::cerr << "Synchronous call from a frame callback of the same connection" << std::endl;
+        return false;
+    }
+    bool done = false;
+    bool connected = false;
+    connectAsync([&](bool result) {
+        done = true;
+        connected = result;
+    });
+
+    // 接收和处理服务器初始化帧
+    if (!runUntil([&done] { return done; })) {
+        std::cerr << "Timeout waiting for server SETTINGS" << std::endl;
+        connect_callback_ = nullptr;
+        cleanup();
+        return false;
+    }
+    return connected;
+}
+
 void Http2Client::disconnect() {
     cleanup();
 }
 
 bool Http2Client::isConnected() const {
-    return socket_fd_ >= 0 && ssl_ != nullptr;
+    return state_ == ConnectionState::AWAITING_SETTINGS || state_ == ConnectionState::READY;
 }
 
 Http2Client::Response Http2Client::get(
     const std::string& path,
     const std::vector<std::pair<std::string, std::string>>& headers) {
-    
-    Response response;
-    
-    if (!isConnected()) {
-        std::cerr << "Not connected" << std::endl;
-        return response;
+    uint32_t stream_id = submit("GET", path, headers);
+    if (stream_id == 0) {
+        return Response();
     }
-    
-    // 使用流ID 1
-    uint32_t stream_id = 1;
-    
-    if (!sendHeadersFrame(stream_id, "GET", path, headers, true)) {
-        std::cerr << "Failed to send GET request" << std::endl;
-        return response;
-    }
-    
-    return receiveResponse(stream_id);
+    return wait(stream_id);
 }
 
 Http2Client::Response Http2Client::head(
     const std::string& path,
     const std::vector<std::pair<std::string, std::string>>& headers) {
-    
-    Response response;
-    
-    if (!isConnected()) {
-        std::cerr << "Not connected" << std::endl;
-        return response;
-    }
-    
-    // 使用流ID 1
-    uint32_t stream_id = 1;
-    
-    if (!sendHeadersFrame(stream_id, "HEAD", path, headers, true)) {
-        std::cerr << "Failed to send HEAD request" << std::endl;
-        return response;
+    uint32_t stream_id = submit("HEAD", path, headers);
+    if (stream_id == 0) {
+        return Response();
     }
-    
-    return receiveResponse(stream_id);
+    return wait(stream_id);
 }
 
 void Http2Client::cleanup() {
+    connection_token_.reset();
+    encoder_.setMemoryGovernor(nullptr);
+    decoder_.setMemoryGovernor(nullptr);
+    state_ = ConnectionState::DISCONNECTED;
+    if (flush_scheduled_) {
+        loop_->cancelDeferred(flush_task_);
+        flush_scheduled_ = false;
+    }
+    stopRingTransport();
+
     if (ssl_) {
         SSL_shutdown(ssl_);
-        SSL_free(ssl_);
+        SSL_free(ssl_);  // 同时释放内存 BIO
         ssl_ = nullptr;
+        net_in_ = nullptr;
+        net_out_ = nullptr;
     }
     
     if (ssl_ctx_) {
@@ -677,6 +1491,7 @@ void Http2Client::cleanup() {
     }
     
     if (socket_fd_ >= 0) {
+        loop_->remove(socket_fd_);
         close(socket_fd_);
         socket_fd_ = -1;
     }
@@ -1,14 +1,20 @@
 #include "http2_client.h"
 #include <iostream>
 #include <iomanip>
+#include <cstring>
+
+int main(int argc, char* argv[]) {
+    // --io-uring：socket 读写走 io_uring 后端
+    bool use_uring = argc > 1 && std::strcmp(argv[1], "--io-uring") == 0;
 
-int main() {
     std::cout << "=== HTTP/2 Client Test ===" << std::endl;
     std::cout << "Connecting to example.com..." << std::endl << std::endl;
 
     try {
         // 创建HTTP/2客户端
-        http2::Http2Client client("example.com", 443);
+        http2::EventLoop loop(use_uring ? http2::EventLoop::Backend::IO_URING
+                                        : http2::EventLoop::Backend::EPOLL);
+        http2::Http2Client client("example.com", 443, &loop);
 
         // 连接到服务器
         if (!client.connect()) {
@@ -0,0 +1,396 @@
+#include "uring.h"
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+#include <string>
+
+namespace http2 {
+
+namespace {
+
+// 取消操作使用的 user_data，完成事件直接忽略
+constexpr uint64_t CANCEL_USER_DATA = 0;
+
+// provided buffer ring 的组ID
+constexpr uint16_t RECV_BUFFER_GROUP = 0;
+
+int sysSetup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int sysEnter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags,
+             const void* arg, size_t arg_size) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags,
+                                    arg, arg_size));
+}
+
+int sysRegister(int fd, unsigned opcode, const void* arg, unsigned nr_args) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+unsigned loadAcquire(const unsigned* p) {
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+void storeRelease(unsigned* p, unsigned value) {
+    __atomic_store_n(p, value, __ATOMIC_RELEASE);
+}
+
+[[noreturn]] void throwErrno(const char* what, int error) {
+    throw std::runtime_error(std::string(what) + ": " + std::strerror(error));
+}
+
+} // namespace
+
+IoUring::IoUring(unsigned entries)
+    : ring_fd_(-1), sq_entries_(0), sq_ring_(MAP_FAILED), sq_ring_size_(0),
+      sqes_(nullptr), sqes_size_(0), sqe_tail_(0), submitted_tail_(0),
+      buf_ring_(MAP_FAILED), buf_ring_size_(0), buf_ring_tail_(0),
+      next_id_(1), enter_calls_(0) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_COOP_TASKRUN;
+    ring_fd_ = sysSetup(entries, &params);
+    if (ring_fd_ < 0 && errno == EINVAL) {
+        // 旧内核不支持 COOP_TASKRUN
+        std::memset(&params, 0, sizeof(params));
+        ring_fd_ = sysSetup(entries, &params);
+    }
+    if (ring_fd_ < 0) {
+        throwErrno("io_uring_setup failed", errno);
+    }
+
+    try {
+        if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_EXT_ARG)) {
+            throw std::runtime_error("io_uring: kernel lacks SINGLE_MMAP/EXT_ARG");
+        }
+        sq_entries_ = params.sq_entries;
+
+        // SINGLE_MMAP：提交队列和完成队列共用一次映射
+        sq_ring_size_ = std::max<size_t>(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                                         params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+        sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ring_fd_, IORING_OFF_SQ_RING);
+        if (sq_ring_ == MAP_FAILED) {
+            throwErrno("io_uring ring mmap failed", errno);
+        }
+
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          ring_fd_, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) {
+            throwErrno("io_uring sqe mmap failed", errno);
+        }
+        sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+        auto* sq = static_cast<uint8_t*>(sq_ring_);
+        sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        auto* cq = sq;
+        cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        sqe_tail_ = submitted_tail_ = *sq_tail_;
+
+        setupBufferRing();
+        registerSendSlots();
+    } catch (...) {
+        releaseRing();
+        throw;
+    }
+}
+
+IoUring::~IoUring() {
+    releaseRing();
+}
+
+void IoUring::releaseRing() {
+    if (buf_ring_ != MAP_FAILED) {
+        munmap(buf_ring_, buf_ring_size_);
+        buf_ring_ = MAP_FAILED;
+    }
+    if (sqes_) {
+        munmap(sqes_, sqes_size_);
+        sqes_ = nullptr;
+    }
+    if (sq_ring_ != MAP_FAILED) {
+        munmap(sq_ring_, sq_ring_size_);
+        sq_ring_ = MAP_FAILED;
+    }
+    if (ring_fd_ >= 0) {
+        close(ring_fd_);  // 关闭时内核取消所有未完成的操作
+        ring_fd_ = -1;
+    }
+}
+
+bool IoUring::supported() {
+    static const bool result = [] {
+        try {
+            IoUring probe(8);
+            return true;
+        } catch (const std::exception&) {
+            return false;
+        }
+    }();
+    return result;
+}
+
+void IoUring::setupBufferRing() {
+    // 缓冲区描述环必须页对齐，用匿名映射分配
+    buf_ring_size_ = RECV_BUFFER_COUNT * sizeof(io_uring_buf);
+    buf_ring_ = mmap(nullptr, buf_ring_size_, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buf_ring_ == MAP_FAILED) {
+        throwErrno("buffer ring mmap failed", errno);
+    }
+
+    io_uring_buf_reg reg;
+    std::memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(buf_ring_);
+    reg.ring_entries = RECV_BUFFER_COUNT;
+    reg.bgid = RECV_BUFFER_GROUP;
+    if (sysRegister(ring_fd_, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        throwErrno("IORING_REGISTER_PBUF_RING failed", errno);
+    }
+
+    recv_buffers_.reset(new uint8_t[RECV_BUFFER_SIZE * RECV_BUFFER_COUNT]);
+    for (uint16_t id = 0; id < RECV_BUFFER_COUNT; ++id) {
+        recycleReceiveBuffer(id);
+    }
+}
+
+void IoUring::registerSendSlots() {
+    send_slots_.reset(new uint8_t[SEND_SLOT_SIZE * SEND_SLOT_COUNT]);
+    std::vector<iovec> iovecs(SEND_SLOT_COUNT);
+    for (uint16_t slot = 0; slot < SEND_SLOT_COUNT; ++slot) {
+        iovecs[slot].iov_base = send_slots_.get() + slot * SEND_SLOT_SIZE;
+        iovecs[slot].iov_len = SEND_SLOT_SIZE;
+        free_slots_.push_back(SEND_SLOT_COUNT - 1 - slot);
+    }
+    if (sysRegister(ring_fd_, IORING_REGISTER_BUFFERS, iovecs.data(), SEND_SLOT_COUNT) < 0) {
+        throwErrno("IORING_REGISTER_BUFFERS failed", errno);
+    }
+}
+
+const uint8_t* IoUring::receiveBuffer(uint16_t id) const {
+    return recv_buffers_.get() + id * RECV_BUFFER_SIZE;
+}
+
+void IoUring::recycleReceiveBuffer(uint16_t id) {
+    auto* bufs = static_cast<io_uring_buf*>(buf_ring_);
+    io_uring_buf& buf = bufs[buf_ring_tail_ & (RECV_BUFFER_COUNT - 1)];
+    buf.addr = reinterpret_cast<uint64_t>(recv_buffers_.get() + id * RECV_BUFFER_SIZE);
+    buf.len = RECV_BUFFER_SIZE;
+    buf.bid = id;
+    ++buf_ring_tail_;
+    // 环尾与第一个描述符的保留字段重叠
+    auto* ring = static_cast<io_uring_buf_ring*>(buf_ring_);
+    __atomic_store_n(&ring->tail, buf_ring_tail_, __ATOMIC_RELEASE);
+}
+
+int IoUring::acquireSendSlot() {
+    if (free_slots_.empty()) {
+        return -1;
+    }
+    uint16_t slot = free_slots_.back();
+    free_slots_.pop_back();
+    return slot;
+}
+
+uint8_t* IoUring::sendSlot(uint16_t slot) {
+    return send_slots_.get() + slot * SEND_SLOT_SIZE;
+}
+
+void IoUring::releaseSendSlot(uint16_t slot) {
+    free_slots_.push_back(slot);
+}
+
+io_uring_sqe* IoUring::nextSqe() {
+    if (sqe_tail_ - loadAcquire(sq_head_) >= sq_entries_) {
+        // 提交队列已满：先提交，不等待
+        enter(0, 0, 0);
+    }
+    unsigned index = sqe_tail_ & *sq_mask_;
+    io_uring_sqe* sqe = &sqes_[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sq_array_[index] = index;
+    ++sqe_tail_;
+    return sqe;
+}
+
+void IoUring::reserve(unsigned count) {
+    if (sq_entries_ - (sqe_tail_ - loadAcquire(sq_head_)) < count) {
+        enter(0, 0, 0);
+    }
+}
+
+uint64_t IoUring::track(Handler handler) {
+    uint64_t id = next_id_++;
+    operations_[id].handler = std::make_shared<Handler>(std::move(handler));
+    return id;
+}
+
+uint64_t IoUring::pollMultishot(int fd, uint32_t events, Handler handler) {
+    io_uring_sqe* sqe = nextSqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = events;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->user_data = track(std::move(handler));
+    return sqe->user_data;
+}
+
+uint64_t IoUring::recvMultishot(int fd, Handler handler) {
+    io_uring_sqe* sqe = nextSqe();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = RECV_BUFFER_GROUP;
+    sqe->user_data = track(std::move(handler));
+    return sqe->user_data;
+}
+
+uint64_t IoUring::writeFixed(int fd, uint16_t slot, size_t offset, size_t length, bool link,
+                             Handler handler) {
+    io_uring_sqe* sqe = nextSqe();
+    sqe->opcode = IORING_OP_WRITE_FIXED;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(sendSlot(slot) + offset);
+    sqe->len = static_cast<uint32_t>(length);
+    sqe->off = static_cast<uint64_t>(-1);  // socket 没有文件偏移
+    sqe->buf_index = slot;
+    sqe->flags = link ? IOSQE_IO_LINK : 0;
+    sqe->user_data = track(std::move(handler));
+    return sqe->user_data;
+}
+
+uint64_t IoUring::send(int fd, std::shared_ptr<const std::vector<uint8_t>> data, size_t offset,
+                       size_t length, bool link, Handler handler) {
+    io_uring_sqe* sqe = nextSqe();
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(data->data() + offset);
+    sqe->len = static_cast<uint32_t>(length);
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->flags = link ? IOSQE_IO_LINK : 0;
+    sqe->user_data = track(std::move(handler));
+    operations_[sqe->user_data].buffer = std::move(data);
+    return sqe->user_data;
+}
+
+void IoUring::cancel(uint64_t id, int release_slot) {
+    auto it = operations_.find(id);
+    if (it == operations_.end()) {
+        return;
+    }
+    it->second.handler.reset();
+    it->second.release_slot = release_slot;
+
+    io_uring_sqe* sqe = nextSqe();
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->addr = id;
+    sqe->user_data = CANCEL_USER_DATA;
+}
+
+int IoUring::enter(unsigned to_submit, unsigned min_complete, int timeout_ms) {
+    // 发布本地提交队列尾
+    if (sqe_tail_ != submitted_tail_) {
+        storeRelease(sq_tail_, sqe_tail_);
+    }
+    to_submit = sqe_tail_ - submitted_tail_;
+
+    unsigned flags = 0;
+    __kernel_timespec ts;
+    io_uring_getevents_arg arg;
+    std::memset(&arg, 0, sizeof(arg));
+    if (min_complete > 0) {
+        flags |= IORING_ENTER_GETEVENTS;
+        if (timeout_ms >= 0) {
+            ts.tv_sec = timeout_ms / 1000;
+            ts.tv_nsec = (timeout_ms % 1000) * 1000000L;
+            arg.ts = reinterpret_cast<uint64_t>(&ts);
+            flags |= IORING_ENTER_EXT_ARG;
+        }
+    }
+    if (to_submit == 0 && min_complete == 0) {
+        return 0;
+    }
+
+    ++enter_calls_;
+    int ret = flags & IORING_ENTER_EXT_ARG
+        ? sysEnter(ring_fd_, to_submit, min_complete, flags, &arg, sizeof(arg))
+        : sysEnter(ring_fd_, to_submit, min_complete, flags, nullptr, 0);
+    if (ret < 0) {
+        int error = errno;
+        if (error == ETIME || error == EINTR || error == EAGAIN || error == EBUSY) {
+            // 超时或被打断且没有提交任何操作，下次重试
+            return 0;
+        }
+        throwErrno("io_uring_enter failed", error);
+    }
+    submitted_tail_ += static_cast<unsigned>(ret);
+    return ret;
+}
+
+size_t IoUring::submitAndWait(int timeout_ms) {
+    // 已有完成事件时不等待
+    bool ready = loadAcquire(cq_tail_) != *cq_head_;
+    enter(0, ready || timeout_ms == 0 ? 0 : 1, timeout_ms);
+    return dispatchCompletions();
+}
+
+size_t IoUring::dispatchCompletions() {
+    size_t dispatched = 0;
+    // 每次都重新读取队头：回调中嵌套的分发可能已经取走后面的条目
+    unsigned head;
+    while ((head = *cq_head_) != loadAcquire(cq_tail_)) {
+        io_uring_cqe cqe = cqes_[head & *cq_mask_];
+        // 先释放完成队列条目，回调中可能继续提交和分发
+        storeRelease(cq_head_, head + 1);
+
+        if (cqe.user_data == CANCEL_USER_DATA) {
+            continue;
+        }
+        auto it = operations_.find(cqe.user_data);
+        if (it == operations_.end()) {
+            continue;
+        }
+        std::shared_ptr<Handler> handler = it->second.handler;
+        if (!(cqe.flags & IORING_CQE_F_MORE)) {
+            if (it->second.release_slot >= 0) {
+                releaseSendSlot(static_cast<uint16_t>(it->second.release_slot));
+            }
+            operations_.erase(it);
+        }
+        if (handler) {
+            (*handler)(cqe.res, cqe.flags);
+            ++dispatched;
+        } else if (cqe.flags & IORING_CQE_F_BUFFER) {
+            // 已取消的接收仍可能占用缓冲区
+            recycleReceiveBuffer(static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT));
+        }
+    }
+    return dispatched;
+}
+
+size_t IoUring::pending() const {
+    return operations_.size();
+}
+
+uint64_t IoUring::enterCalls() const {
+    return enter_calls_;
+}
+
+} // namespace http2
@@ -0,0 +1,421 @@
+#ifndef HTTP2_LOOPBACK_SERVER_H
+#define HTTP2_LOOPBACK_SERVER_H
+
+#include "frame.h"
+#include "hpack.h"
+#include <openssl/evp.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace http2 {
+
+/**
+ * @class LoopbackConnection
+ * @brief 回环服务器上的一个连接，由脚本逐帧驱动
+ *
+ * next() 返回客户端发来的下一帧。客户端的 SETTINGS 和 PING 自动回复 ACK
+ * （PING 可以关闭自动回复），WINDOW_UPDATE 和 SETTINGS_INITIAL_WINDOW_SIZE
+ * 更新服务器一侧的发送窗口，HEADERS 解码为请求头。发出的帧先排队，在下一次
+ * 阻塞读取之前一次写出，同一批请求的响应合并成一次 SSL_write。
+ */
+class LoopbackConnection {
+public:
+    struct Frame {
+        FrameHeader header{};
+        std::vector<uint8_t> payload;
+        std::vector<std::pair<std::string, std::string>> headers;  // HEADERS 帧解码后的请求头
+    };
+
+    explicit LoopbackConnection(SSL* ssl) : ssl_(ssl) {}
+
+    /**
+     * @brief 读取客户端的下一帧；连接关闭或读取超时时返回 false
+     */
+    bool next(Frame& frame) {
+        if (!pending_.empty()) {
+            frame = std::move(pending_.front());
+            pending_.pop_front();
+            return true;
+        }
+        return readFrame(frame);
+    }
+
+    /**
+     * @brief 读取帧直到类型匹配，跳过的帧丢弃
+     */
+    bool nextOfType(uint8_t type, Frame& frame) {
+        while (next(frame)) {
+            if (frame.header.type == type) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void send(uint8_t type, uint8_t flags, uint32_t stream_id,
+              const uint8_t* payload = nullptr, size_t length = 0) {
+        size_t offset = out_.size();
+        out_.resize(offset + FRAME_HEADER_SIZE + length);
+        writeFrameHeader(out_.data() + offset,
+                         {static_cast<uint32_t>(length), type, flags, stream_id});
+        if (length > 0) {
+            std::memcpy(out_.data() + offset + FRAME_HEADER_SIZE, payload, length);
+        }
+    }
+
+    void send(uint8_t type, uint8_t flags, uint32_t stream_id, const std::vector<uint8_t>& payload) {
+        send(type, flags, stream_id, payload.data(), payload.size());
+    }
+
+    /**
+     * @brief 发送 SETTINGS 帧（标识符/值）
+     */
+    void sendSettings(const std::vector<std::pair<uint16_t, uint32_t>>& settings = {}) {
+        std::vector<uint8_t> payload;
+        for (const auto& [id, value] : settings) {
+            const uint8_t entry[] = {static_cast<uint8_t>(id >> 8), static_cast<uint8_t>(id),
+                                     static_cast<uint8_t>(value >> 24), static_cast<uint8_t>(value >> 16),
+                                     static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value)};
+            payload.insert(payload.end(), entry, entry + sizeof(entry));
+        }
+        send(FRAME_TYPE_SETTINGS, 0, 0, payload);
+    }
+
+    /**
+     * @brief 用连接的编码器编码一个头块（需要按编码顺序发出）
+     */
+    std::vector<uint8_t> headerBlock(const std::vector<std::pair<std::string, std::string>>& fields) {
+        return encoder_.encode(fields);
+    }
+
+    /**
+     * @brief 发送响应头（单个 HEADERS 帧）
+     */
+    void sendHeaders(uint32_t stream_id, int status, bool end_stream,
+                     const std::vector<std::pair<std::string, std::string>>& headers = {}) {
+        std::vector<std::pair<std::string, std::string>> fields = {{":status", std::to_string(status)}};
+        fields.insert(fields.end(), headers.begin(), headers.end());
+        send(FRAME_TYPE_HEADERS, FLAG_END_HEADERS | (end_stream ? FLAG_END_STREAM : 0), stream_id,
+             headerBlock(fields));
+    }
+
+    /**
+     * @brief 在客户端通告的窗口和帧大小内发送 length 字节的响应体
+     *
+     * 窗口不足时读取帧等待 WINDOW_UPDATE，期间收到的其他帧留给 next()。
+     *
+     * @return false 如果连接关闭或超时
+     */
+    bool sendData(uint32_t stream_id, size_t length, bool end_stream, uint8_t fill = 'x') {
+        std::vector<uint8_t> chunk;
+        do {
+            int64_t window = std::min(connection_window_, streamWindow(stream_id));
+            while (window <= 0 && length > 0) {
+                Frame frame;
+                if (!readFrame(frame)) {
+                    return false;
+                }
+                if (frame.header.type != FRAME_TYPE_WINDOW_UPDATE) {
+                    pending_.push_back(std::move(frame));
+                }
+                window = std::min(connection_window_, streamWindow(stream_id));
+            }
+            size_t size = std::min<size_t>({length, static_cast<size_t>(std::max<int64_t>(window, 0)),
+                                            max_frame_size_});
+            length -= size;
+            chunk.assign(size, fill);
+            send(FRAME_TYPE_DATA, length == 0 && end_stream ? FLAG_END_STREAM : 0, stream_id, chunk);
+            connection_window_ -= static_cast<int64_t>(size);
+            stream_windows_[stream_id] = streamWindow(stream_id) - static_cast<int64_t>(size);
+        } while (length > 0);
+        return true;
+    }
+
+    /**
+     * @brief 写出排队的帧
+     */
+    bool flush() {
+        if (out_.empty()) {
+            return true;
+        }
+        bool ok = SSL_write(ssl_, out_.data(), static_cast<int>(out_.size())) > 0;
+        out_.clear();
+        return ok;
+    }
+
+    /**
+     * @brief 服务器一侧看到的客户端接收窗口（stream_id 为 0 时是连接级）
+     */
+    int64_t streamWindow(uint32_t stream_id) const {
+        if (stream_id == 0) {
+            return connection_window_;
+        }
+        auto it = stream_windows_.find(stream_id);
+        return it != stream_windows_.end() ? it->second : initial_window_;
+    }
+
+    /**
+     * @brief 客户端发来的 SETTINGS 参数（后到的覆盖先到的）
+     */
+    const std::map<uint16_t, uint32_t>& clientSettings() const {
+        return client_settings_;
+    }
+
+    // 收到的 WINDOW_UPDATE（流ID、增量），按到达顺序
+    std::vector<std::pair<uint32_t, uint32_t>> window_updates;
+
+    // 是否自动回复客户端的 PING
+    bool auto_ping_ack = true;
+
+private:
+    SSL* ssl_;
+    std::vector<uint8_t> in_;
+    std::vector<uint8_t> out_;
+    std::deque<Frame> pending_;
+    bool preface_seen_ = false;
+    HpackEncoder encoder_;
+    HpackDecoder decoder_;
+    std::vector<uint8_t> header_block_;
+    std::map<uint16_t, uint32_t> client_settings_;
+    int64_t connection_window_ = DEFAULT_WINDOW_SIZE;
+    int64_t initial_window_ = DEFAULT_WINDOW_SIZE;
+    size_t max_frame_size_ = DEFAULT_MAX_FRAME_SIZE;
+    std::map<uint32_t, int64_t> stream_windows_;
+
+    bool readFrame(Frame& frame) {
+        while (true) {
+            size_t pos = preface_seen_ ? 0 : 24;
+            if (in_.size() >= pos + FRAME_HEADER_SIZE) {
+                FrameHeader header = readFrameHeader(in_.data() + pos);
+                if (in_.size() - pos - FRAME_HEADER_SIZE >= header.length) {
+                    const uint8_t* payload = in_.data() + pos + FRAME_HEADER_SIZE;
+                    frame.header = header;
+                    frame.payload.assign(payload, payload + header.length);
+                    frame.headers.clear();
+                    in_.erase(in_.begin(), in_.begin() + pos + FRAME_HEADER_SIZE + header.length);
+                    preface_seen_ = true;
+                    onFrame(frame);
+                    return true;
+                }
+            }
+            if (!flush()) {
+                return false;
+            }
+            uint8_t buffer[16384];
+            int n = SSL_read(ssl_, buffer, sizeof(buffer));
+            if (n <= 0) {
+                return false;
+            }
+            in_.insert(in_.end(), buffer, buffer + n);
+        }
+    }
+
+    void onFrame(Frame& frame) {
+        const FrameHeader& header = frame.header;
+        const uint8_t* payload = frame.payload.data();
+        switch (header.type) {
+            case FRAME_TYPE_SETTINGS:
+                if (header.flags & FLAG_ACK) {
+                    break;
+                }
+                for (size_t pos = 0; pos + 6 <= header.length; pos += 6) {
+                    uint16_t id = static_cast<uint16_t>((payload[pos] << 8) | payload[pos + 1]);
+                    uint32_t value = readUint32(payload + pos + 2);
+                    client_settings_[id] = value;
+                    if (id == 0x4) {  // SETTINGS_INITIAL_WINDOW_SIZE
+                        for (auto& [stream_id, window] : stream_windows_) {
+                            window += static_cast<int64_t>(value) - initial_window_;
+                        }
+                        initial_window_ = value;
+                    } else if (id == 0x5) {  // SETTINGS_MAX_FRAME_SIZE
+                        max_frame_size_ = value;
+                    }
+                }
+                send(FRAME_TYPE_SETTINGS, FLAG_ACK, 0);
+                break;
+
+            case FRAME_TYPE_PING:
+                if (!(header.flags & FLAG_ACK) && auto_ping_ack) {
+                    send(FRAME_TYPE_PING, FLAG_ACK, 0, frame.payload);
+                }
+                break;
+
+            case FRAME_TYPE_WINDOW_UPDATE: {
+                uint32_t increment = readUint32(payload) & MAX_WINDOW_SIZE;
+                window_updates.emplace_back(header.stream_id, increment);
+                if (header.stream_id == 0) {
+                    connection_window_ += increment;
+                } else {
+                    stream_windows_[header.stream_id] = streamWindow(header.stream_id) + increment;
+                }
+                break;
+            }
+
+            case FRAME_TYPE_HEADERS:
+            case FRAME_TYPE_CONTINUATION:
+                header_block_.insert(header_block_.end(), frame.payload.begin(), frame.payload.end());
+                if (header.flags & FLAG_END_HEADERS) {
+                    frame.headers = decoder_.decode(header_block_.data(), header_block_.size());
+                    header_block_.clear();
+                }
+                break;
+        }
+    }
+
+    static uint32_t readUint32(const uint8_t* data) {
+        return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) |
+               (static_cast<uint32_t>(data[2]) << 8) | data[3];
+    }
+};
+
+/**
+ * @class LoopbackServer
+ * @brief 回环 HTTP/2 服务器：自签名证书，每个连接一个线程运行脚本
+ *
+ * 默认脚本对每个请求回复不带响应体的 200。测试用自己的脚本精确控制
+ * 发出的帧；脚本中的断言失败照常报告。
+ */
+class LoopbackServer {
+public:
+    using Script = std::function<void(LoopbackConnection& connection)>;
+
+    // 读取超过该时间没有数据时脚本中的 next() 返回 false，避免测试挂起
+    static constexpr int READ_TIMEOUT_MS = 10000;
+
+    explicit LoopbackServer(Script script = respondEmpty)
+        : script_(std::move(script)), ctx_(SSL_CTX_new(TLS_server_method())), listen_fd_(-1), port_(0) {
+        EVP_PKEY* key = EVP_PKEY_Q_keygen(nullptr, nullptr, "EC", "P-256");
+        X509* cert = X509_new();
+        ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+        X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+        X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+        X509_set_pubkey(cert, key);
+        X509_NAME* name = X509_get_subject_name(cert);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                                   reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+        X509_set_issuer_name(cert, name);
+        X509_sign(cert, key, EVP_sha256());
+        SSL_CTX_use_certificate(ctx_, cert);
+        SSL_CTX_use_PrivateKey(ctx_, key);
+        X509_free(cert);
+        EVP_PKEY_free(key);
+        SSL_CTX_set_alpn_select_cb(ctx_, selectH2, nullptr);
+
+        listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(addr);
+        if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+            listen(listen_fd_, 128) < 0 ||
+            getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &length) < 0) {
+            throw std::runtime_error("Failed to start loopback server");
+        }
+        port_ = ntohs(addr.sin_port);
+        acceptor_ = std::thread([this] { acceptLoop(); });
+    }
+
+    ~LoopbackServer() {
+        stop();
+        close(listen_fd_);
+        SSL_CTX_free(ctx_);
+    }
+
+    uint16_t port() const {
+        return port_;
+    }
+
+    /**
+     * @brief 停止接受连接并等待所有连接的脚本结束
+     *
+     * 之后可以安全地读取脚本写入的变量。客户端应先断开连接。
+     */
+    void stop() {
+        if (acceptor_.joinable()) {
+            shutdown(listen_fd_, SHUT_RDWR);
+            acceptor_.join();
+        }
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+        workers_.clear();
+    }
+
+    /**
+     * @brief 默认脚本：发送空 SETTINGS，对每个请求回复不带响应体的 200
+     */
+    static void respondEmpty(LoopbackConnection& connection) {
+        connection.sendSettings();
+        LoopbackConnection::Frame frame;
+        while (connection.next(frame)) {
+            if (frame.header.type == FRAME_TYPE_HEADERS && (frame.header.flags & FLAG_END_STREAM)) {
+                const uint8_t status_200[] = {0x88};  // 静态表索引 8 = :status 200
+                connection.send(FRAME_TYPE_HEADERS, FLAG_END_HEADERS | FLAG_END_STREAM,
+                                frame.header.stream_id, status_200, sizeof(status_200));
+            }
+        }
+    }
+
+private:
+    Script script_;
+    SSL_CTX* ctx_;
+    int listen_fd_;
+    uint16_t port_;
+    std::thread acceptor_;
+    std::vector<std::thread> workers_;
+
+    static int selectH2(SSL*, const unsigned char** out, unsigned char* out_len,
+                        const unsigned char* in, unsigned int in_len, void*) {
+        static const unsigned char h2[] = {2, 'h', '2'};
+        unsigned char* selected = nullptr;
+        if (SSL_select_next_proto(&selected, out_len, h2, sizeof(h2), in, in_len) !=
+            OPENSSL_NPN_NEGOTIATED) {
+            return SSL_TLSEXT_ERR_NOACK;
+        }
+        *out = selected;
+        return SSL_TLSEXT_ERR_OK;
+    }
+
+    void acceptLoop() {
+        while (true) {
+            int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd < 0) {
+                return;
+            }
+            workers_.emplace_back([this, fd] { serve(fd); });
+        }
+    }
+
+    void serve(int fd) {
+        timeval timeout{READ_TIMEOUT_MS / 1000, (READ_TIMEOUT_MS % 1000) * 1000};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        SSL* ssl = SSL_new(ctx_);
+        SSL_set_fd(ssl, fd);
+        if (SSL_accept(ssl) > 0) {
+            LoopbackConnection connection(ssl);
+            script_(connection);
+            connection.flush();
+        }
+        SSL_free(ssl);
+        close(fd);
+    }
+};
+
+} // namespace http2
+
+#endif // HTTP2_LOOPBACK_SERVER_H
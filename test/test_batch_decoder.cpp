@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include "batch_decoder.h"
+#include <memory>
+
+namespace http2 {
+
+/**
+ * Test cases for parallel batch decoding
+ */
+class BatchDecoderTest : public ::testing::Test {
+protected:
+    void SetUp() override {}
+
+    using HeaderList = std::vector<std::pair<std::string, std::string>>;
+
+    // 第 request 个请求：每个连接的 x-conn 字段不同，重复请求依赖动态表
+    static HeaderList requestHeaders(int connection, int request) {
+        return {
+            {":method", "GET"},
+            {":path", "/items/" + std::to_string(request % 3)},
+            {"x-conn", "connection-" + std::to_string(connection)},
+            {"x-seq", std::to_string(request)},
+        };
+    }
+};
+
+/**
+ * 测试多个连接的头块交错提交时，每个连接内的顺序被保持
+ */
+TEST_F(BatchDecoderTest, PreservesPerConnectionOrder) {
+    const int connections = 6;
+    const int requests = 20;
+
+    std::vector<std::unique_ptr<HpackDecoder>> decoders;
+    std::vector<HpackEncoder> encoders(connections);
+    std::vector<std::vector<uint8_t>> blocks;
+    std::vector<HeaderBlockJob> jobs;
+    std::vector<HeaderList> expected;
+
+    for (int c = 0; c < connections; ++c) {
+        decoders.push_back(std::make_unique<HpackDecoder>());
+    }
+    blocks.reserve(connections * requests);
+    for (int r = 0; r < requests; ++r) {
+        for (int c = 0; c < connections; ++c) {
+            expected.push_back(requestHeaders(c, r));
+            blocks.push_back(encoders[c].encode(expected.back()));
+            jobs.push_back({decoders[c].get(), blocks.back().data(), blocks.back().size(), {}});
+        }
+    }
+
+    BatchDecoder batch(4);
+    EXPECT_EQ(batch.threadCount(), 4);
+    batch.decode(jobs);
+
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        EXPECT_EQ(jobs[i].headers, expected[i]) << "job " << i;
+    }
+}
+
+/**
+ * 测试解码器状态跨批次延续，单线程模式不创建额外线程
+ */
+TEST_F(BatchDecoderTest, DecoderStateCarriesAcrossBatches) {
+    HpackEncoder encoder;
+    HpackDecoder decoder;
+    BatchDecoder batch(1);
+
+    for (int r = 0; r < 3; ++r) {
+        auto block = encoder.encode(requestHeaders(0, r));
+        std::vector<HeaderBlockJob> jobs = {{&decoder, block.data(), block.size(), {}}};
+        batch.decode(jobs);
+        EXPECT_EQ(jobs[0].headers, requestHeaders(0, r));
+    }
+    EXPECT_EQ(batch.lastStealCount(), 0);
+}
+
+} // namespace http2
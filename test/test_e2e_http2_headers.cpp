@@ -663,4 +663,59 @@ TEST_F(E2EHeadersTest, ALPNProtocolHeaders) {
     EXPECT_EQ(decoded.size(), headers.size());
 }
 
+/**
+ * 场景: Cookie 拆分的压缩率
+ * 大 Cookie 每次只变化一个 crumb，拆分后未变化的 crumb 命中动态表
+ */
+TEST_F(E2EHeadersTest, CookieCrumblingCompressionRatio) {
+    std::vector<std::string> crumbs;
+    for (int i = 0; i < 20; ++i) {
+        crumbs.push_back("crumb" + std::to_string(i) + "=" + std::string(40, 'a' + i));
+    }
+    auto makeRequest = [&](int version) {
+        std::string cookie;
+        for (size_t i = 0; i < crumbs.size(); ++i) {
+            if (i > 0) cookie += "; ";
+            cookie += (i == 7) ? "crumb7=v" + std::to_string(version) : crumbs[i];
+        }
+        return std::vector<std::pair<std::string, std::string>>{
+            {":method", "GET"},
+            {":scheme", "https"},
+            {":authority", "example.com"},
+            {":path", "/"},
+            {"cookie", cookie},
+        };
+    };
+
+    HpackEncoder crumbled;
+    HpackEncoder whole;
+    whole.setCookieCrumbling(false);
+    HpackDecoder decoder;
+
+    size_t crumbled_bytes = 0;
+    size_t whole_bytes = 0;
+    size_t raw_bytes = 0;
+    for (int version = 0; version < 10; ++version) {
+        auto request = makeRequest(version);
+        auto encoded = crumbled.encode(request);
+        crumbled_bytes += encoded.size();
+        whole_bytes += whole.encode(request).size();
+        raw_bytes += HPACK::encode(request).size();
+
+        // 解码端重新拼接后与原始 Cookie 一致
+        std::string joined;
+        for (const auto& [name, value] : decoder.decode(encoded.data(), encoded.size())) {
+            if (name == "cookie") {
+                if (!joined.empty()) joined += "; ";
+                joined += value;
+            }
+        }
+        EXPECT_EQ(joined, request[4].second);
+    }
+
+    std::cout << "Cookie bytes over 10 requests: raw=" << raw_bytes
+              << " whole=" << whole_bytes << " crumbled=" << crumbled_bytes << std::endl;
+    EXPECT_LT(crumbled_bytes * 4, whole_bytes);
+}
+
 } // namespace http2
@@ -0,0 +1,188 @@
+#include <gtest/gtest.h>
+#include "event_loop.h"
+#include <sys/epoll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+namespace http2 {
+
+/**
+ * Test cases for the epoll reactor
+ */
+class EventLoopTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_EQ(pipe2(pipe_a_, O_NONBLOCK), 0);
+        ASSERT_EQ(pipe2(pipe_b_, O_NONBLOCK), 0);
+    }
+
+    void TearDown() override {
+        for (int fd : {pipe_a_[0], pipe_a_[1], pipe_b_[0], pipe_b_[1]}) {
+            close(fd);
+        }
+    }
+
+    int pipe_a_[2];
+    int pipe_b_[2];
+};
+
+/**
+ * 测试可读事件分发到对应描述符的回调
+ */
+TEST_F(EventLoopTest, DispatchesReadableDescriptor) {
+    EventLoop loop;
+    int a_events = 0;
+    int b_events = 0;
+    ASSERT_TRUE(loop.add(pipe_a_[0], EPOLLIN, [&](uint32_t events) {
+        EXPECT_TRUE(events & EPOLLIN);
+        char c;
+        EXPECT_EQ(read(pipe_a_[0], &c, 1), 1);
+        ++a_events;
+    }));
+    ASSERT_TRUE(loop.add(pipe_b_[0], EPOLLIN, [&](uint32_t) { ++b_events; }));
+
+    EXPECT_EQ(loop.runOnce(0), 0);
+    ASSERT_EQ(write(pipe_a_[1], "x", 1), 1);
+    EXPECT_EQ(loop.runOnce(100), 1);
+    EXPECT_EQ(a_events, 1);
+    EXPECT_EQ(b_events, 0);
+}
+
+/**
+ * 测试回调中移除同一轮中稍后就绪的描述符
+ */
+TEST_F(EventLoopTest, RemoveDuringDispatch) {
+    EventLoop loop;
+    int calls = 0;
+    auto remove_both = [&](uint32_t) {
+        ++calls;
+        loop.remove(pipe_a_[0]);
+        loop.remove(pipe_b_[0]);
+    };
+    ASSERT_TRUE(loop.add(pipe_a_[0], EPOLLIN, remove_both));
+    ASSERT_TRUE(loop.add(pipe_b_[0], EPOLLIN, remove_both));
+    ASSERT_EQ(write(pipe_a_[1], "x", 1), 1);
+    ASSERT_EQ(write(pipe_b_[1], "x", 1), 1);
+
+    EXPECT_EQ(loop.runOnce(100), 1);
+    EXPECT_EQ(calls, 1);
+    EXPECT_EQ(loop.size(), 0);
+    loop.run();  // 没有描述符时立即返回
+}
+
+/**
+ * 测试修改关注的事件：写端从不关注变为关注可写
+ */
+TEST_F(EventLoopTest, ModifyInterest) {
+    EventLoop loop;
+    int writable = 0;
+    ASSERT_TRUE(loop.add(pipe_a_[1], 0, [&](uint32_t events) {
+        EXPECT_TRUE(events & EPOLLOUT);
+        ++writable;
+        loop.stop();
+    }));
+    EXPECT_EQ(loop.runOnce(0), 0);
+    EXPECT_TRUE(loop.modify(pipe_a_[1], EPOLLOUT));
+    loop.run();
+    EXPECT_EQ(writable, 1);
+    EXPECT_FALSE(loop.modify(pipe_b_[1], EPOLLOUT));
+}
+
+/**
+ * 测试延迟任务在本轮分发之后运行一次，任务中登记的任务在下一轮等待之前运行
+ */
+TEST_F(EventLoopTest, DeferredTasksRunAfterDispatch) {
+    EventLoop loop;
+    std::vector<std::string> order;
+    ASSERT_TRUE(loop.add(pipe_a_[0], EPOLLIN, [&](uint32_t) {
+        char c;
+        EXPECT_EQ(read(pipe_a_[0], &c, 1), 1);
+        order.push_back("event");
+        loop.defer([&] {
+            order.push_back("flush");
+            loop.defer([&] { order.push_back("next"); });
+        });
+    }));
+    ASSERT_EQ(write(pipe_a_[1], "x", 1), 1);
+
+    loop.runOnce(100);
+    EXPECT_EQ(order, (std::vector<std::string>{"event", "flush"}));
+    loop.runOnce(0);  // 等待之前运行
+    EXPECT_EQ(order, (std::vector<std::string>{"event", "flush", "next"}));
+}
+
+/**
+ * 测试取消延迟任务，包括被同一批中先运行的任务取消
+ */
+TEST_F(EventLoopTest, CancelDeferredTask) {
+    EventLoop loop;
+    int runs = 0;
+    uint64_t second = 0;
+    loop.defer([&] {
+        ++runs;
+        loop.cancelDeferred(second);
+    });
+    second = loop.defer([&] { ++runs; });
+    uint64_t third = loop.defer([&] { ++runs; });
+    loop.cancelDeferred(third);
+
+    loop.run();  // 只有延迟任务时运行完即返回
+    EXPECT_EQ(runs, 1);
+}
+
+/**
+ * 测试回调中嵌套调用 runOnce()：嵌套的一轮不覆盖外层取回的事件
+ */
+TEST_F(EventLoopTest, NestedRunOnceKeepsOuterEvents) {
+    EventLoop loop;
+    int pipe_c[2];
+    int pipe_d[2];
+    ASSERT_EQ(pipe2(pipe_c, O_NONBLOCK), 0);
+    ASSERT_EQ(pipe2(pipe_d, O_NONBLOCK), 0);
+
+    int outer_calls = 0;
+    int c_calls = 0;
+    int d_calls = 0;
+    bool nested = false;
+    // a、b 先运行的一个读空两者，唤醒 c、d 后嵌套分发；外层随后仍分发另一个
+    auto outer = [&](uint32_t) {
+        ++outer_calls;
+        if (nested) {
+            return;
+        }
+        nested = true;
+        char c;
+        EXPECT_EQ(read(pipe_a_[0], &c, 1), 1);
+        EXPECT_EQ(read(pipe_b_[0], &c, 1), 1);
+        EXPECT_EQ(write(pipe_c[1], "x", 1), 1);
+        EXPECT_EQ(write(pipe_d[1], "x", 1), 1);
+        EXPECT_EQ(loop.runOnce(0), 2);
+    };
+    ASSERT_TRUE(loop.add(pipe_a_[0], EPOLLIN, outer));
+    ASSERT_TRUE(loop.add(pipe_b_[0], EPOLLIN, outer));
+    ASSERT_TRUE(loop.add(pipe_c[0], EPOLLIN, [&](uint32_t) {
+        char c;
+        EXPECT_EQ(read(pipe_c[0], &c, 1), 1);
+        ++c_calls;
+    }));
+    ASSERT_TRUE(loop.add(pipe_d[0], EPOLLIN, [&](uint32_t) {
+        char c;
+        EXPECT_EQ(read(pipe_d[0], &c, 1), 1);
+        ++d_calls;
+    }));
+    ASSERT_EQ(write(pipe_a_[1], "x", 1), 1);
+    ASSERT_EQ(write(pipe_b_[1], "x", 1), 1);
+
+    EXPECT_EQ(loop.runOnce(100), 2);
+    EXPECT_EQ(outer_calls, 2);
+    EXPECT_EQ(c_calls, 1);
+    EXPECT_EQ(d_calls, 1);
+
+    for (int fd : {pipe_c[0], pipe_c[1], pipe_d[0], pipe_d[1]}) {
+        close(fd);
+    }
+}
+
+} // namespace http2
@@ -0,0 +1,209 @@
+#include <gtest/gtest.h>
+#include "frame.h"
+#include "hpack.h"
+#include <algorithm>
+#include <cstring>
+
+namespace http2 {
+
+/**
+ * Test cases for HTTP/2 frame helpers
+ */
+class FrameTest : public ::testing::Test {
+protected:
+    void SetUp() override {}
+
+    // 按帧头解析缓冲区中的所有帧
+    static std::vector<std::pair<FrameHeader, std::vector<uint8_t>>> splitFrames(
+        const std::vector<uint8_t>& buffer) {
+        std::vector<std::pair<FrameHeader, std::vector<uint8_t>>> frames;
+        size_t pos = 0;
+        while (pos + FRAME_HEADER_SIZE <= buffer.size()) {
+            FrameHeader header = readFrameHeader(&buffer[pos]);
+            pos += FRAME_HEADER_SIZE;
+            frames.emplace_back(header, std::vector<uint8_t>(buffer.begin() + pos,
+                                                             buffer.begin() + pos + header.length));
+            pos += header.length;
+        }
+        EXPECT_EQ(pos, buffer.size());
+        return frames;
+    }
+};
+
+/**
+ * Test frame header round trip
+ */
+TEST_F(FrameTest, FrameHeaderRoundTrip) {
+    uint8_t buffer[FRAME_HEADER_SIZE];
+    writeFrameHeader(buffer, {0x123456, FRAME_TYPE_HEADERS, FLAG_END_HEADERS, 0x7fffffff});
+    EXPECT_EQ(buffer[0], 0x12);
+    EXPECT_EQ(buffer[5], 0x7f);
+
+    FrameHeader header = readFrameHeader(buffer);
+    EXPECT_EQ(header.length, 0x123456u);
+    EXPECT_EQ(header.type, FRAME_TYPE_HEADERS);
+    EXPECT_EQ(header.flags, FLAG_END_HEADERS);
+    EXPECT_EQ(header.stream_id, 0x7fffffffu);
+}
+
+/**
+ * Test small header block fits in a single HEADERS frame
+ */
+TEST_F(FrameTest, SingleHeadersFrame) {
+    std::vector<uint8_t> out = {0xAA};  // 已有数据保持不变
+    HeaderFrameBuilder builder(out, 3);
+    HpackEncoder encoder;
+    encoder.encode({{":method", "GET"}, {":path", "/"}}, builder.block());
+    EXPECT_EQ(builder.finish(true), 1);
+
+    EXPECT_EQ(out[0], 0xAA);
+    std::vector<uint8_t> frames_only(out.begin() + 1, out.end());
+    auto frames = splitFrames(frames_only);
+    ASSERT_EQ(frames.size(), 1);
+    EXPECT_EQ(frames[0].first.type, FRAME_TYPE_HEADERS);
+    EXPECT_EQ(frames[0].first.flags, FLAG_END_HEADERS | FLAG_END_STREAM);
+    EXPECT_EQ(frames[0].first.stream_id, 3u);
+}
+
+/**
+ * Test large header block is split into HEADERS + CONTINUATION in place
+ */
+TEST_F(FrameTest, SplitIntoContinuationFrames) {
+    std::vector<std::pair<std::string, std::string>> headers = {
+        {":method", "GET"},
+        {":path", "/"},
+        {"authorization", "Bearer " + std::string(300, 'j')},
+        {"cookie", std::string(500, 'c')},
+    };
+
+    std::vector<uint8_t> out;
+    HeaderFrameBuilder builder(out, 5, 128);
+    HpackEncoder encoder;
+    encoder.encode(headers, builder.block());
+    size_t frame_count = builder.finish(false);
+    EXPECT_GT(frame_count, 2);
+
+    auto frames = splitFrames(out);
+    ASSERT_EQ(frames.size(), frame_count);
+
+    std::vector<uint8_t> block;
+    for (size_t i = 0; i < frames.size(); ++i) {
+        const FrameHeader& header = frames[i].first;
+        EXPECT_EQ(header.type, i == 0 ? FRAME_TYPE_HEADERS : FRAME_TYPE_CONTINUATION);
+        EXPECT_EQ((header.flags & FLAG_END_HEADERS) != 0, i + 1 == frames.size());
+        EXPECT_EQ(header.flags & FLAG_END_STREAM, 0);
+        EXPECT_LE(header.length, 128u);
+        EXPECT_EQ(header.stream_id, 5u);
+        block.insert(block.end(), frames[i].second.begin(), frames[i].second.end());
+    }
+
+    HpackDecoder decoder;
+    EXPECT_EQ(decoder.decode(block.data(), block.size()), headers);
+}
+
+// 构造一个负载为 fill 的帧
+static std::vector<uint8_t> makeFrame(uint8_t type, uint32_t stream_id, size_t length, uint8_t fill) {
+    std::vector<uint8_t> frame(FRAME_HEADER_SIZE + length, fill);
+    writeFrameHeader(frame.data(), {static_cast<uint32_t>(length), type, 0, stream_id});
+    return frame;
+}
+
+// 按 chunk 大小分多次写入读取器
+static void feed(FrameReader& reader, const std::vector<uint8_t>& bytes, size_t chunk) {
+    for (size_t pos = 0; pos < bytes.size(); pos += chunk) {
+        size_t length = std::min(chunk, bytes.size() - pos);
+        ASSERT_GE(reader.writable(), length);
+        std::memcpy(reader.writePointer(), bytes.data() + pos, length);
+        reader.commit(length);
+    }
+}
+
+/**
+ * 测试帧在多次不完整的写入后才被取出
+ */
+TEST_F(FrameTest, FrameReaderPartialWrites) {
+    FrameReader reader(4096);
+    auto frame = makeFrame(FRAME_TYPE_DATA, 3, 1000, 0xab);
+    FrameView view;
+
+    feed(reader, std::vector<uint8_t>(frame.begin(), frame.begin() + 5), 5);
+    EXPECT_FALSE(reader.next(view));
+    feed(reader, std::vector<uint8_t>(frame.begin() + 5, frame.begin() + 500), 100);
+    EXPECT_FALSE(reader.next(view));
+    feed(reader, std::vector<uint8_t>(frame.begin() + 500, frame.end()), 100);
+
+    ASSERT_TRUE(reader.next(view));
+    EXPECT_EQ(view.header.stream_id, 3u);
+    ASSERT_EQ(view.length, 1000u);
+    EXPECT_EQ(view.payload[0], 0xab);
+    EXPECT_EQ(view.payload[999], 0xab);
+    EXPECT_FALSE(reader.next(view));
+    EXPECT_EQ(reader.buffered(), 0u);
+}
+
+/**
+ * 测试跨越环尾的帧仍以连续视图返回，且可写空间总是连续的
+ */
+TEST_F(FrameTest, FrameReaderWrapsAround) {
+    FrameReader reader(4096);
+    size_t capacity = reader.capacity();
+    FrameView view;
+
+    // 每帧 1009 字节，多轮之后帧的起点落在环上各处
+    for (uint8_t round = 0; round < 40; ++round) {
+        auto frame = makeFrame(FRAME_TYPE_DATA, 1, 1000, round);
+        feed(reader, frame, 333);
+        ASSERT_TRUE(reader.next(view));
+        ASSERT_EQ(view.length, 1000u);
+        for (size_t i = 0; i < view.length; ++i) {
+            ASSERT_EQ(view.payload[i], round);
+        }
+        EXPECT_EQ(reader.writable(), capacity);
+    }
+}
+
+/**
+ * 测试超过容量的帧使缓冲区扩大，已缓冲的数据保留
+ */
+TEST_F(FrameTest, FrameReaderGrowsForLargeFrame) {
+    FrameReader reader(4096);
+    FrameView view;
+    auto small = makeFrame(FRAME_TYPE_PING, 0, 8, 0x11);
+    auto large = makeFrame(FRAME_TYPE_DATA, 5, 70000, 0x22);
+
+    feed(reader, small, small.size());
+    feed(reader, std::vector<uint8_t>(large.begin(), large.begin() + 2000), 2000);
+    ASSERT_TRUE(reader.next(view));
+    EXPECT_EQ(view.header.type, FRAME_TYPE_PING);
+    EXPECT_FALSE(reader.next(view));
+    EXPECT_GE(reader.capacity(), large.size());
+
+    feed(reader, std::vector<uint8_t>(large.begin() + 2000, large.end()), 16384);
+    ASSERT_TRUE(reader.next(view));
+    EXPECT_EQ(view.header.stream_id, 5u);
+    ASSERT_EQ(view.length, 70000u);
+    EXPECT_EQ(view.payload[0], 0x22);
+    EXPECT_EQ(view.payload[69999], 0x22);
+}
+
+/**
+ * 测试 peek 只读取帧头：负载尚未到达时也能检查帧长度，且不取出帧
+ */
+TEST_F(FrameTest, FrameReaderPeeksHeader) {
+    FrameReader reader(4096);
+    FrameHeader header;
+    FrameView view;
+    auto frame = makeFrame(FRAME_TYPE_DATA, 7, 100000, 0x33);
+
+    feed(reader, std::vector<uint8_t>(frame.begin(), frame.begin() + 4), 4);
+    EXPECT_FALSE(reader.peek(header));
+    feed(reader, std::vector<uint8_t>(frame.begin() + 4, frame.begin() + 20), 16);
+    ASSERT_TRUE(reader.peek(header));
+    EXPECT_EQ(header.length, 100000u);
+    EXPECT_EQ(header.stream_id, 7u);
+    EXPECT_EQ(reader.buffered(), 20u);
+    EXPECT_LT(reader.capacity(), frame.size());  // 只有 next() 才会扩大缓冲区
+    EXPECT_FALSE(reader.next(view));
+}
+
+} // namespace http2
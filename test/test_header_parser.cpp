@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include "header_parser.h"
+#include "hpack.h"
 
 namespace http2 {
 
@@ -83,4 +84,129 @@ TEST_F(HeaderParserTest, ParseHeaderBlock) {
     EXPECT_EQ(headers[0].second, "application/json");
 }
 
+/**
+ * Test pseudo-header summary bitmask for a request
+ */
+TEST_F(HeaderParserTest, ValidateRequestPseudoHeaders) {
+    std::vector<std::pair<std::string, std::string>> headers = {
+        {":method", "GET"},
+        {":scheme", "https"},
+        {":authority", "example.com"},
+        {":path", "/"},
+        {"te", "trailers"},
+    };
+
+    HeaderValidation summary;
+    EXPECT_TRUE(HeaderParser::validateHeaders(headers, &summary));
+    EXPECT_TRUE(summary.valid());
+    EXPECT_TRUE(summary.has(HeaderValidation::PSEUDO_METHOD | HeaderValidation::PSEUDO_PATH));
+    EXPECT_TRUE(summary.has(HeaderValidation::PSEUDO_SCHEME | HeaderValidation::PSEUDO_AUTHORITY));
+    EXPECT_FALSE(summary.has(HeaderValidation::PSEUDO_STATUS));
+}
+
+/**
+ * Test pseudo-header ordering, duplicates and unknown names
+ */
+TEST_F(HeaderParserTest, RejectMalformedPseudoHeaders) {
+    HeaderValidation summary;
+
+    EXPECT_FALSE(HeaderParser::validateHeaders(
+        {{":status", "200"}, {"content-type", "text/html"}, {":status", "404"}}, &summary));
+    EXPECT_STREQ(summary.error, "pseudo-header after regular header");
+
+    EXPECT_FALSE(HeaderParser::validateHeaders({{":status", "200"}, {":status", "404"}}, &summary));
+    EXPECT_STREQ(summary.error, "duplicate pseudo-header");
+
+    EXPECT_FALSE(HeaderParser::validateHeaders({{":method", "GET"}, {":method", "POST"}}));
+    EXPECT_FALSE(HeaderParser::validateHeaders({{":path", "/a"}, {":path", "/b"}}));
+    EXPECT_FALSE(HeaderParser::validateHeaders({{":foo", "bar"}}));
+    EXPECT_FALSE(HeaderParser::validateHeaders({{":status", "200"}, {":method", "GET"}}));
+}
+
+/**
+ * Test connection-specific headers are rejected
+ */
+TEST_F(HeaderParserTest, RejectConnectionSpecificHeaders) {
+    for (const char* name : {"connection", "keep-alive", "transfer-encoding", "upgrade"}) {
+        EXPECT_FALSE(HeaderParser::validateHeaders({{":status", "200"}, {name, "x"}})) << name;
+    }
+    EXPECT_FALSE(HeaderParser::validateHeaders({{":method", "GET"}, {"te", "gzip"}}));
+    EXPECT_TRUE(HeaderParser::validateHeaders({{":method", "GET"}, {"te", "trailers"}}));
+}
+
+/**
+ * Test empty values are accepted by the validator
+ */
+TEST_F(HeaderParserTest, ValidateEmptyValues) {
+    HeaderValidation summary;
+    EXPECT_TRUE(HeaderParser::validateHeaders(
+        {{":method", "GET"}, {"accept-encoding", ""}, {"x-empty", ""}}, &summary));
+    EXPECT_TRUE(summary.valid());
+
+    std::vector<uint8_t> buffer = HPACK::encode({{":status", "204"}, {"accept-encoding", ""}});
+    HeaderValidation validation;
+    auto headers = HeaderParser::parseHeaders(buffer.data(), buffer.size(), validation);
+    EXPECT_TRUE(validation.valid());
+    ASSERT_EQ(headers.size(), 2);
+    EXPECT_EQ(headers[1].second, "");
+
+    EXPECT_FALSE(HeaderParser::validateHeaders({{"x-split", std::string("a\r\nb")}}, &summary));
+    EXPECT_STREQ(summary.error, "invalid header value");
+}
+
+/**
+ * Test field names with uppercase or forbidden characters are rejected
+ */
+TEST_F(HeaderParserTest, RejectInvalidFieldNames) {
+    HeaderValidation summary;
+    EXPECT_FALSE(HeaderParser::validateHeaders({{":status", "200"}, {"Content-Type", "text/html"}},
+                                               &summary));
+    EXPECT_STREQ(summary.error, "invalid header name");
+
+    EXPECT_FALSE(HeaderParser::validateHeaders({{":Method", "GET"}}));
+    EXPECT_FALSE(HeaderParser::validateHeaders({{"x header", "1"}}));
+    EXPECT_FALSE(HeaderParser::validateHeaders({{"x:header", "1"}}));
+    EXPECT_TRUE(HeaderParser::validateHeaders({{"x-header_2.v", "1"}}));
+}
+
+/**
+ * Test validation runs inline with HPACK decoding
+ */
+TEST_F(HeaderParserTest, ParseAndValidateInline) {
+    std::vector<uint8_t> valid = HPACK::encode({{":status", "200"}, {"server", "test"}});
+    HeaderValidation validation;
+    auto headers = HeaderParser::parseHeaders(valid.data(), valid.size(), validation);
+    EXPECT_TRUE(validation.valid());
+    EXPECT_TRUE(validation.has(HeaderValidation::PSEUDO_STATUS));
+    ASSERT_EQ(headers.size(), 2);
+    EXPECT_EQ(headers[1].second, "test");
+
+    std::vector<uint8_t> invalid = HPACK::encode({{":status", "200"}, {"connection", "close"}});
+    headers = HeaderParser::parseHeaders(invalid.data(), invalid.size(), validation);
+    EXPECT_FALSE(validation.valid());
+    EXPECT_TRUE(headers.empty());
+}
+
+/**
+ * Test cookie crumbs are rejoined only when requested
+ */
+TEST_F(HeaderParserTest, JoinCookieCrumbs) {
+    std::vector<uint8_t> buffer = HPACK::encode({
+        {":method", "GET"},
+        {"cookie", "a=1"},
+        {"accept", "*/*"},
+        {"cookie", "b=2"},
+        {"cookie", "c=3"},
+    });
+
+    auto split = HeaderParser::parseHeaders(buffer.data(), buffer.size());
+    EXPECT_EQ(split.size(), 5);
+
+    auto joined = HeaderParser::parseHeaders(buffer.data(), buffer.size(), true);
+    ASSERT_EQ(joined.size(), 3);
+    EXPECT_EQ(joined[1].first, "cookie");
+    EXPECT_EQ(joined[1].second, "a=1; b=2; c=3");
+    EXPECT_EQ(joined[2].first, "accept");
+}
+
 } // namespace http2
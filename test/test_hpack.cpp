@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 #include "hpack.h"
+#include "hpack_const.h"
+#include "stream_arena.h"
 
 namespace http2 {
 
@@ -286,11 +288,106 @@ TEST_F(StringCoderTest, DecodeInsufficientBuffer_Data) {
 }
 
 /**
- * Test Huffman encoding throws not implemented error
+ * Test Huffman encoding against RFC 7541 C.4.1 ("www.example.com")
  */
-TEST_F(StringCoderTest, HuffmanNotImplemented) {
-    EXPECT_THROW(StringCoder::encodeString("hello", true),
-                 std::runtime_error);
+TEST_F(StringCoderTest, EncodeHuffman) {
+    std::vector<uint8_t> expected = {
+        0x8c, 0xf1, 0xe3, 0xc2, 0xe5, 0xf2, 0x3a, 0x6b, 0xa0, 0xab, 0x90, 0xf4, 0xff,
+    };
+    EXPECT_EQ(StringCoder::encodeString("www.example.com", true), expected);
+
+    auto encoded = StringCoder::encodeString("hello", true);
+    auto [decoded, consumed] = StringCoder::decodeString(encoded.data(), encoded.size());
+    EXPECT_EQ(decoded, "hello");
+    EXPECT_EQ(consumed, encoded.size());
+}
+
+/**
+ * Test the Huffman length estimate matches the actual encoding, on both the
+ * short (scalar) and long (vectorized) paths
+ */
+TEST_F(StringCoderTest, HuffmanEncodedLength) {
+    EXPECT_EQ(StringCoder::huffmanEncodedLength(""), 0);
+    EXPECT_EQ(StringCoder::huffmanEncodedLength("www.example.com"), 12);
+
+    std::string all_bytes;
+    for (int c = 0; c < 256; ++c) {
+        all_bytes.push_back(static_cast<char>(c));
+    }
+    for (size_t length : {1, 7, 8, 15, 16, 17, 33, 100, 256}) {
+        std::string str = all_bytes.substr(256 - length);
+        auto encoded = StringCoder::encodeString(str, true);
+        auto [prefix, prefix_length] = IntegerEncoder::decodeInteger(encoded.data(), encoded.size(), 7);
+        EXPECT_EQ(StringCoder::huffmanEncodedLength(str), prefix) << "length " << length;
+        EXPECT_EQ(encoded.size(), prefix_length + prefix);
+    }
+}
+
+/**
+ * Test the encoder uses Huffman only when it is shorter than the raw string
+ */
+TEST_F(StringCoderTest, EncoderChoosesHuffmanWhenShorter) {
+    HpackEncoder encoder;
+    std::vector<uint8_t> block;
+    encoder.encodeFieldWithoutIndexing(":authority", "www.example.com", block);
+    ASSERT_EQ(block.size(), 14);
+    EXPECT_EQ(block[1], 0x8c);  // H=1, 12 bytes
+
+    // Bytes with long codes expand under Huffman and stay raw
+    block.clear();
+    encoder.encodeFieldWithoutIndexing("x-binary", "\x01\x02\x03", block);
+    EXPECT_EQ(block[block.size() - 4], 0x03);
+
+    HpackDecoder decoder;
+    EXPECT_EQ(decoder.decode(block.data(), block.size())[0].second, "\x01\x02\x03");
+}
+
+/**
+ * Test repeated long Huffman literals are served from the per-thread caches
+ */
+TEST_F(StringCoderTest, HuffmanCacheHits) {
+    HuffmanCache& encode_cache = HuffmanCache::encodeCache();
+    HuffmanCache& decode_cache = HuffmanCache::decodeCache();
+    encode_cache.clear();
+    decode_cache.clear();
+    encode_cache.resetStats();
+    decode_cache.resetStats();
+
+    std::string value = "session=0123456789abcdef0123456789abcdef";
+    auto first = StringCoder::encodeString(value, true);
+    auto second = StringCoder::encodeString(value, true);
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(encode_cache.stats().hits, 1);
+    EXPECT_EQ(encode_cache.stats().misses, 1);
+
+    for (int i = 0; i < 4; ++i) {
+        auto [decoded, consumed] = StringCoder::decodeString(first.data(), first.size());
+        EXPECT_EQ(decoded, value);
+    }
+    EXPECT_EQ(decode_cache.stats().hits, 3);
+    EXPECT_DOUBLE_EQ(decode_cache.stats().hitRate(), 0.75);
+
+    // Short strings bypass the cache
+    StringCoder::encodeString("short", true);
+    EXPECT_EQ(encode_cache.stats().hits + encode_cache.stats().misses, 2);
+}
+
+/**
+ * Test LRU eviction order
+ */
+TEST_F(StringCoderTest, HuffmanCacheEvictsLeastRecentlyUsed) {
+    HuffmanCache cache(2);
+    cache.insert("a", "1");
+    cache.insert("b", "2");
+    ASSERT_NE(cache.find("a"), nullptr);  // "b" becomes least recently used
+    cache.insert("c", "3");
+    EXPECT_EQ(cache.size(), 2);
+    EXPECT_EQ(cache.find("b"), nullptr);
+    ASSERT_NE(cache.find("a"), nullptr);
+    EXPECT_EQ(*cache.find("c"), "3");
+
+    cache.setCapacity(0);
+    EXPECT_EQ(cache.size(), 0);
 }
 
 // ============================================================================
@@ -978,9 +1075,11 @@ TEST_F(HuffmanDecodingTest, DecodeHTTP2ResponseHeaders) {
     if (data.size() > 9) {
         std::vector<uint8_t> hpack_data(data.begin() + 9, data.end());
         
-        // 尝试解码HPACK头数据
+        // 尝试解码HPACK头数据；头块以 8192 的动态表大小更新开头，
+        // 解码器需要按抓包时客户端通告的较大表大小构造
         try {
-            auto headers = HPACK::decode(hpack_data);
+            HpackDecoder decoder(8192);
+            auto headers = decoder.decode(hpack_data.data(), hpack_data.size());
             
             // 验证解码成功（不为空）
             EXPECT_FALSE(headers.empty());
@@ -1048,4 +1147,852 @@ TEST_F(HuffmanDecodingTest, PerformanceTest_LargeHeaderBlock) {
     EXPECT_EQ(headers.size(), decoded.size());
 }
 
+/**
+ * 测试所有 256 个符号的 Huffman 往返编解码（覆盖单次查表和长码路径）
+ */
+TEST_F(HuffmanDecodingTest, RoundTripAllSymbols) {
+    std::string all_bytes;
+    for (int c = 0; c < 256; ++c) {
+        all_bytes.push_back(static_cast<char>(c));
+    }
+    auto encoded = StringCoder::encodeString(all_bytes, true);
+    auto [decoded, consumed] = StringCoder::decodeString(encoded.data(), encoded.size());
+    EXPECT_EQ(decoded, all_bytes);
+    EXPECT_EQ(consumed, encoded.size());
+}
+
+/**
+ * 测试交错批量解码与逐个解码结果一致
+ */
+TEST_F(HuffmanDecodingTest, BatchMatchesSequential) {
+    std::vector<std::string> values = {
+        "", "a", "www.example.com", "text/html,application/xhtml+xml",
+        "Mozilla/5.0 (Windows NT 10.0; Win64; x64)", "{\"json\": [1, 2, 3]}",
+        "\x01\xff binary", "gzip",
+    };
+    std::vector<std::vector<uint8_t>> encoded;
+    std::vector<StringCoder::HuffmanSpan> spans;
+    for (const auto& value : values) {
+        encoded.push_back(StringCoder::encodeString(value, true));
+    }
+    for (const auto& bytes : encoded) {
+        auto [length, prefix] = IntegerEncoder::decodeInteger(bytes.data(), bytes.size(), 7);
+        spans.push_back({bytes.data() + prefix, static_cast<size_t>(length)});
+    }
+
+    std::vector<std::string> decoded(values.size());
+    StringCoder::decodeHuffmanBatch(spans.data(), spans.size(), decoded.data());
+    EXPECT_EQ(decoded, values);
+}
+
+/**
+ * 测试包含大量 Huffman 字面量的头块经批量路径解码，动态表正确更新
+ */
+TEST_F(HuffmanDecodingTest, DecoderBatchesBlockStrings) {
+    HpackEncoder encoder;
+    HpackDecoder decoder;
+    std::vector<std::pair<std::string, std::string>> headers;
+    for (int i = 0; i < 20; ++i) {
+        headers.emplace_back("x-field-" + std::to_string(i), "value number " + std::to_string(i));
+    }
+    for (int round = 0; round < 2; ++round) {
+        auto block = encoder.encode(headers);
+        EXPECT_EQ(decoder.decode(block.data(), block.size()), headers);
+    }
+    EXPECT_EQ(decoder.table().getIndexByNameValue("x-field-19", "value number 19"), 62);
+
+    // 截断的头块退回逐字段解码，已完整的字段仍然输出
+    auto block = HpackEncoder().encode(headers);
+    HpackDecoder truncated;
+    auto partial = truncated.decode(block.data(), block.size() - 3);
+    ASSERT_FALSE(partial.empty());
+    EXPECT_EQ(partial[0], headers[0]);
+}
+
+// ============================================================================
+// HpackEncoder / HpackDecoder Tests - 有状态编解码器测试
+// ============================================================================
+
+class StatefulCodecTest : public ::testing::Test {
+protected:
+    void SetUp() override {}
+};
+
+/**
+ * 测试重复请求时编码器使用动态表索引，且解码器保持同步
+ */
+TEST_F(StatefulCodecTest, RepeatedHeadersBecomeIndexed) {
+    HpackEncoder encoder;
+    HpackDecoder decoder;
+
+    std::vector<std::pair<std::string, std::string>> headers = {
+        {":method", "GET"},
+        {":scheme", "https"},
+        {":authority", "api.example.com"},
+        {":path", "/users"},
+        {"user-agent", "MyApp/1.0"},
+    };
+
+    auto first = encoder.encode(headers);
+    auto second = encoder.encode(headers);
+
+    // 第二次所有字段都是单字节索引
+    EXPECT_EQ(second.size(), headers.size());
+    EXPECT_LT(second.size(), first.size());
+
+    EXPECT_EQ(decoder.decode(first.data(), first.size()), headers);
+    EXPECT_EQ(decoder.decode(second.data(), second.size()), headers);
+}
+
+/**
+ * 测试 cookie 拆分为多个 crumb 编码
+ */
+TEST_F(StatefulCodecTest, CookieCrumbling) {
+    HpackEncoder encoder;
+    HpackDecoder decoder;
+
+    auto encoded = encoder.encode({{"cookie", "a=1; b=2;c=3"}});
+    auto decoded = decoder.decode(encoded.data(), encoded.size());
+
+    ASSERT_EQ(decoded.size(), 3);
+    EXPECT_EQ(decoded[0].second, "a=1");
+    EXPECT_EQ(decoded[1].second, "b=2");
+    EXPECT_EQ(decoded[2].second, "c=3");
+
+    encoder.setCookieCrumbling(false);
+    encoded = encoder.encode({{"cookie", "a=1; b=2"}});
+    decoded = decoder.decode(encoded.data(), encoded.size());
+    ASSERT_EQ(decoded.size(), 1);
+    EXPECT_EQ(decoded[0].second, "a=1; b=2");
+}
+
+/**
+ * 测试请求模板在头表状态不变时复用缓存的前缀
+ */
+TEST_F(StatefulCodecTest, RequestTemplateCachesPrefix) {
+    HpackEncoder encoder;
+    HpackDecoder decoder;
+    RequestTemplate request_template({
+        {":method", "GET"},
+        {":scheme", "https"},
+        {":authority", "api.example.com"},
+    });
+
+    for (int i = 0; i < 5; ++i) {
+        std::string path = "/items/" + std::to_string(i);
+        std::vector<uint8_t> block;
+        request_template.encode(encoder, {{":path", path}}, block);
+
+        auto decoded = decoder.decode(block.data(), block.size());
+        ASSERT_EQ(decoded.size(), 4);
+        EXPECT_EQ(decoded[2].second, "api.example.com");
+        EXPECT_EQ(decoded[3].first, ":path");
+        EXPECT_EQ(decoded[3].second, path);
+    }
+
+    // 第一次插入 :authority，第二次编码结果才可缓存，之后全部命中
+    EXPECT_EQ(request_template.misses(), 2);
+    EXPECT_EQ(request_template.hits(), 3);
+    // :path 不进入动态表
+    EXPECT_EQ(encoder.table().getIndexByNameValue(":path", "/items/4"), -1);
+}
+
+/**
+ * 测试头表变化后模板缓存失效
+ */
+TEST_F(StatefulCodecTest, RequestTemplateInvalidatedByTableChange) {
+    HpackEncoder encoder;
+    HpackDecoder decoder;
+    RequestTemplate request_template({{":method", "GET"}, {":authority", "a.example"}});
+
+    std::vector<uint8_t> block;
+    request_template.encode(encoder, {}, block);
+    request_template.encode(encoder, {}, block);
+    encoder.encode({{"x-new", "1"}}, block);  // 修改动态表，索引整体后移
+    request_template.encode(encoder, {}, block);
+
+    EXPECT_EQ(request_template.misses(), 3);
+    auto decoded = decoder.decode(block.data(), block.size());
+    ASSERT_EQ(decoded.size(), 7);
+    EXPECT_EQ(decoded[6].first, ":authority");
+    EXPECT_EQ(decoded[6].second, "a.example");
+}
+
+/**
+ * 测试无状态共享块可被多个不同状态的连接解码，且不修改动态表
+ */
+TEST_F(StatefulCodecTest, SharedBlockIsStateIndependent) {
+    std::vector<std::pair<std::string, std::string>> headers = {
+        {":status", "200"},
+        {"content-type", "text/event-stream"},
+        {"x-broadcast-id", "42"},
+    };
+    SharedHeaderBlock block = SharedHeaderBlock::encode(headers);
+
+    std::vector<HpackDecoder> connections(3);
+    connections[1].table().insertDynamic({"x-broadcast-id", "41"});
+    connections[2].table().insertDynamic({"content-type", "text/event-stream"});
+
+    for (auto& decoder : connections) {
+        uint64_t version = decoder.table().version();
+        EXPECT_EQ(decoder.decode(block.data(), block.size()), headers);
+        EXPECT_EQ(decoder.table().version(), version);
+    }
+
+    // 无状态编码器不修改自身头表
+    HpackEncoder encoder(4096, HpackEncoder::Mode::STATELESS);
+    uint64_t version = encoder.table().version();
+    EXPECT_EQ(encoder.encode(headers), *block.bytes());
+    EXPECT_EQ(encoder.table().version(), version);
+}
+
+/**
+ * 测试共享编码与有状态编码的压缩对比
+ */
+TEST_F(StatefulCodecTest, SharedBlockCompressionTradeOff) {
+    std::vector<std::pair<std::string, std::string>> headers = {
+        {":status", "200"},
+        {"content-type", "application/json"},
+        {"server", "broadcast/1.0"},
+        {"x-channel", "market-data"},
+    };
+
+    // 单次发送时两者接近：差别只在 4 位与 6 位名称索引前缀
+    auto single = SharedHeaderBlock::compare({headers});
+    EXPECT_LE(single.stateless_bytes, single.stateful_bytes + headers.size());
+
+    std::vector<std::vector<std::pair<std::string, std::string>>> sequence(10, headers);
+    auto repeated = SharedHeaderBlock::compare(sequence);
+    std::cout << "Stateless vs stateful over 10 blocks: " << repeated.stateless_bytes
+              << " / " << repeated.stateful_bytes << " (ratio " << repeated.ratio() << ")"
+              << std::endl;
+    EXPECT_GT(repeated.ratio(), 1.0);
+}
+
+/**
+ * 测试自适应索引：一次性的值不再挤占动态表，整体字节数少于全部索引
+ */
+TEST_F(StatefulCodecTest, AdaptiveIndexingBeatsAlwaysIndex) {
+    HpackEncoder always;
+    HpackEncoder adaptive;
+    adaptive.setAdaptiveIndexing(true);
+    HpackDecoder decoder;
+
+    size_t always_bytes = 0;
+    size_t adaptive_bytes = 0;
+    for (int i = 0; i < 300; ++i) {
+        std::vector<std::pair<std::string, std::string>> headers = {
+            {":method", "GET"},
+            {":authority", "api.example.com"},
+            {":path", "/v1/items/" + std::to_string(i % 7)},
+            {"user-agent", "MyApp/3.2.1 (iOS 17.2; iPhone15,2; Scale/3.00)"},
+            {"x-request-id", "req-" + std::to_string(i * 7919) + "-" + std::string(24, 'f')},
+            {"x-timestamp", std::to_string(1700000000000ULL + i * 37)},
+        };
+        always_bytes += always.encode(headers).size();
+        auto block = adaptive.encode(headers);
+        adaptive_bytes += block.size();
+        EXPECT_EQ(decoder.decode(block.data(), block.size()), headers);
+    }
+
+    EXPECT_LT(adaptive_bytes, always_bytes);
+    EXPECT_LT(adaptive.table().dynamicTable().evictionCount(),
+              always.table().dynamicTable().evictionCount());
+}
+
+/**
+ * 测试低熵敏感字段使用 never-indexed 表示
+ */
+TEST_F(StatefulCodecTest, AdaptiveIndexingNeverIndexesShortSecrets) {
+    HpackEncoder encoder;
+    encoder.setAdaptiveIndexing(true);
+
+    auto block = encoder.encode({{"authorization", "Basic YTpi"}});
+    ASSERT_FALSE(block.empty());
+    EXPECT_EQ(block[0] & 0xF0, 0x10);
+    EXPECT_EQ(encoder.table().getIndexByNameValue("authorization", "Basic YTpi"), -1);
+
+    HpackDecoder decoder;
+    auto decoded = decoder.decode(block.data(), block.size());
+    ASSERT_EQ(decoded.size(), 1);
+    EXPECT_EQ(decoded[0].second, "Basic YTpi");
+}
+
+/**
+ * 测试默认情况下长令牌按普通字段索引，重复请求只需引用表条目
+ */
+TEST_F(StatefulCodecTest, AdaptiveIndexingIndexesLongTokensByDefault) {
+    HpackEncoder encoder;
+    encoder.setAdaptiveIndexing(true);
+    std::string token = "Bearer " + std::string(120, 'k');
+
+    auto first = encoder.encode({{"authorization", token}});
+    EXPECT_GT(encoder.table().getIndexByNameValue("authorization", token), 0);
+    auto second = encoder.encode({{"authorization", token}});
+    ASSERT_EQ(second.size(), 1u);
+    EXPECT_EQ(second[0] & 0x80, 0x80);
+    EXPECT_LT(second.size(), first.size());
+}
+
+/**
+ * 测试开启 setNeverIndexCredentials 后长令牌形式的凭据同样不进入动态表
+ */
+TEST_F(StatefulCodecTest, AdaptiveIndexingNeverIndexesBearerTokens) {
+    HpackEncoder encoder;
+    encoder.setAdaptiveIndexing(true);
+    encoder.setNeverIndexCredentials(true);
+    std::string token = "Bearer " + std::string(120, 'k');
+
+    for (const char* name : {"authorization", "proxy-authorization"}) {
+        auto block = encoder.encode({{name, token}});
+        ASSERT_FALSE(block.empty());
+        EXPECT_EQ(block[0] & 0xF0, 0x10);
+        EXPECT_EQ(encoder.table().getIndexByNameValue(name, token), -1);
+    }
+}
+
+/**
+ * 测试自适应索引与 cookie 拆分同时开启时，未变化的长 crumb 仍被复用
+ */
+TEST_F(StatefulCodecTest, AdaptiveIndexingKeepsCookieCrumbReuse) {
+    HpackEncoder crumbled;
+    crumbled.setAdaptiveIndexing(true);
+    HpackEncoder whole;
+    whole.setAdaptiveIndexing(true);
+    whole.setCookieCrumbling(false);
+    HpackDecoder decoder;
+
+    size_t crumbled_bytes = 0;
+    size_t whole_bytes = 0;
+    size_t raw_bytes = 0;
+    for (int i = 0; i < 50; ++i) {
+        // 会话和偏好 crumb 不变，只有最后一个短 crumb 每次变化
+        std::string cookie = "session=" + std::string(32, 's') +
+                             "; prefs=theme-dark-lang-en-tz-utc; n=" + std::to_string(i);
+        std::vector<std::pair<std::string, std::string>> headers = {{"cookie", cookie}};
+        raw_bytes += cookie.size();
+        whole_bytes += whole.encode(headers).size();
+        auto block = crumbled.encode(headers);
+        crumbled_bytes += block.size();
+        auto decoded = decoder.decode(block.data(), block.size());
+        ASSERT_EQ(decoded.size(), 3u);
+        EXPECT_EQ(decoded[2].second, "n=" + std::to_string(i));
+    }
+
+    // 两个长 crumb 命中动态表后每个请求只剩几个字节
+    EXPECT_LT(crumbled_bytes * 4, whole_bytes);
+    EXPECT_LT(crumbled_bytes * 8, raw_bytes);
+}
+
+/**
+ * 测试动态表淘汰统计与淘汰距离
+ */
+TEST_F(DynamicTableTest, EvictionStatistics) {
+    DynamicTable table(100);
+    table.insert({"a", "1"});  // 34 字节
+    table.insert({"b", "2"});  // 34 字节
+    EXPECT_EQ(table.bytesUntilEviction(1), 32);   // 最旧条目：只剩空闲空间
+    EXPECT_EQ(table.bytesUntilEviction(0), 66);   // 空闲空间 + 更旧的条目
+    EXPECT_EQ(table.evictionCount(), 0);
+
+    table.insert({"c", "3"});
+    EXPECT_EQ(table.evictionCount(), 1);
+    EXPECT_EQ(table.maxSize(), 100);
+}
+
+/**
+ * 测试内存治理器按预算和注册数量计算每个动态表的上限
+ */
+TEST_F(StatefulCodecTest, GovernorDividesBudget) {
+    HpackMemoryGovernor governor(8192);
+    EXPECT_EQ(governor.tableSizeLimit(), 4096);
+
+    std::vector<HpackEncoder> encoders(5);
+    for (size_t i = 0; i < 4; ++i) {
+        encoders[i].setMemoryGovernor(&governor);
+    }
+    EXPECT_EQ(governor.tableSizeLimit(), 2048);
+
+    encoders[4].setMemoryGovernor(&governor);
+    EXPECT_EQ(governor.tableSizeLimit(), 1536);  // 8192 / 5 按 256 字节取整
+
+    auto metrics = governor.metrics();
+    EXPECT_EQ(metrics.encoders, 5);
+    EXPECT_EQ(metrics.decoders, 0);
+
+    encoders.clear();
+    EXPECT_EQ(governor.metrics().encoders, 0);
+    EXPECT_EQ(governor.tableSizeLimit(), 4096);
+}
+
+/**
+ * 测试内存压力下编码器缩小动态表并发送大小更新，解码端保持同步
+ */
+TEST_F(StatefulCodecTest, GovernorShrinksEncoderTable) {
+    HpackMemoryGovernor governor(4096);
+    HpackEncoder encoder;
+    HpackDecoder decoder;
+    encoder.setMemoryGovernor(&governor);
+
+    std::vector<std::pair<std::string, std::string>> headers;
+    for (int i = 0; i < 30; ++i) {
+        headers.emplace_back("x-header-" + std::to_string(i), "value-" + std::to_string(i));
+    }
+    auto block = encoder.encode(headers);
+    decoder.decode(block.data(), block.size());
+    EXPECT_GT(governor.metrics().table_bytes, 1024);
+
+    // 第二个连接注册后每个表只能使用 2048 字节
+    HpackDecoder other;
+    other.setMemoryGovernor(&governor);
+    EXPECT_EQ(other.advertisedTableSize(), 2048);
+
+    block = encoder.encode(headers);
+    ASSERT_GE(block.size(), 3);
+    EXPECT_EQ(block[0], 0x3f);  // Dynamic Table Size Update，2048 = 31 + 2017
+    EXPECT_EQ(encoder.table().dynamicTable().maxSize(), 2048);
+    EXPECT_EQ(decoder.decode(block.data(), block.size()), headers);
+    EXPECT_EQ(decoder.table().dynamicTable().maxSize(), 2048);
+    EXPECT_LE(governor.metrics().table_bytes, 2048);
+}
+
+/**
+ * 测试头块中途治理器上限变化时，大小更新只出现在下一个头块的开头
+ */
+TEST_F(StatefulCodecTest, GovernorLimitChangeWaitsForNextBlock) {
+    HpackMemoryGovernor governor(4096);
+    HpackEncoder encoder;
+    HpackDecoder decoder;
+    encoder.setMemoryGovernor(&governor);
+    RequestTemplate request_template({{":method", "GET"}, {":authority", "api.example.com"}});
+    std::vector<std::pair<std::string, std::string>> custom = {{"x-trace", "abc"}};
+
+    std::vector<uint8_t> block;
+    request_template.encode(encoder, {{":path", "/"}}, block);
+    size_t prefix = block.size();
+
+    // 另一个连接在模板与自定义字段之间注册，上限降为 2048
+    HpackEncoder other;
+    other.setMemoryGovernor(&governor);
+    encoder.encodeFields(custom, block);
+    for (size_t i = prefix; i < block.size(); ++i) {
+        EXPECT_NE(block[i] & 0xE0, 0x20) << "size update at offset " << i;
+    }
+    ASSERT_EQ(decoder.decode(block.data(), block.size()).size(), 4u);
+
+    // 下一个头块以大小更新开头；缓存的模板前缀中没有大小更新
+    block.clear();
+    request_template.encode(encoder, {{":path", "/next"}}, block);
+    encoder.encodeFields(custom, block);
+    ASSERT_GE(block.size(), 3u);
+    EXPECT_EQ(block[0], 0x3f);
+    auto decoded = decoder.decode(block.data(), block.size());
+    ASSERT_EQ(decoded.size(), 4u);
+    EXPECT_EQ(decoded[2].second, "/next");
+    EXPECT_EQ(decoder.table().dynamicTable().maxSize(), 2048u);
+
+    block.clear();
+    request_template.encode(encoder, {{":path", "/again"}}, block);
+    EXPECT_NE(block[0] & 0xE0, 0x20);
+    EXPECT_EQ(decoder.decode(block.data(), block.size()).size(), 3u);
+}
+
+/**
+ * 测试同一块之前先缩小后恢复的表大小按 RFC 7541 4.2 发送两次更新
+ */
+TEST_F(StatefulCodecTest, TableSizeUpdateSignalsMinimum) {
+    HpackEncoder encoder;
+    HpackDecoder decoder;
+    auto block = encoder.encode({{"x-a", "1"}});
+    decoder.decode(block.data(), block.size());
+
+    encoder.setMaxTableSize(0);
+    encoder.setMaxTableSize(4096);
+    block = encoder.encode({{"x-a", "1"}});
+    std::vector<uint8_t> expected_prefix = {0x20, 0x3f, 0xe1, 0x1f};
+    ASSERT_GE(block.size(), expected_prefix.size());
+    EXPECT_EQ(std::vector<uint8_t>(block.begin(), block.begin() + 4), expected_prefix);
+
+    auto decoded = decoder.decode(block.data(), block.size());
+    ASSERT_EQ(decoded.size(), 1);
+    EXPECT_EQ(decoded[0].second, "1");
+}
+
+/**
+ * 测试 reset() 后编解码器回到新连接状态，可以重新配对使用
+ */
+TEST_F(StatefulCodecTest, ResetRestoresInitialState) {
+    HpackEncoder encoder;
+    HpackDecoder decoder;
+    std::vector<std::pair<std::string, std::string>> headers = {{"x-session", "abc"}};
+
+    auto block = encoder.encode(headers);
+    decoder.decode(block.data(), block.size());
+    encoder.setMaxTableSize(1024);
+    ASSERT_GT(encoder.table().dynamicTable().entryCount(), 0);
+
+    encoder.reset();
+    decoder.reset();
+    EXPECT_EQ(encoder.table().dynamicTable().entryCount(), 0);
+    EXPECT_EQ(encoder.table().dynamicTable().maxSize(), 4096);
+    EXPECT_EQ(decoder.table().dynamicTable().entryCount(), 0);
+
+    // 重置后的第一个块与新建编码器的输出相同（没有待发送的大小更新）
+    EXPECT_EQ(encoder.encode(headers), HpackEncoder().encode(headers));
+}
+
+/**
+ * 测试对象池复用释放的对象，并遵守空闲内存上限
+ */
+TEST_F(StatefulCodecTest, PoolReusesCodecs) {
+    HpackDecoderPool::clear();
+    auto before = HpackDecoderPool::stats();
+
+    HpackDecoder* first;
+    {
+        auto decoder = HpackDecoderPool::acquire();
+        first = decoder.get();
+        HpackEncoder encoder;
+        auto block = encoder.encode({{"x-a", "1"}});
+        decoder->decode(block.data(), block.size());
+    }
+    EXPECT_EQ(HpackDecoderPool::stats().pooled, 1);
+    {
+        auto decoder = HpackDecoderPool::acquire();
+        EXPECT_EQ(decoder.get(), first);
+        EXPECT_EQ(decoder->table().dynamicTable().entryCount(), 0);
+    }
+    auto after = HpackDecoderPool::stats();
+    EXPECT_EQ(after.created - before.created, 1);
+    EXPECT_EQ(after.reused - before.reused, 1);
+
+    // 上限为 0 时释放的对象直接销毁
+    HpackDecoderPool::setMaxPooledBytes(0);
+    EXPECT_EQ(HpackDecoderPool::stats().pooled, 0);
+    HpackDecoderPool::acquire().reset();
+    EXPECT_EQ(HpackDecoderPool::stats().pooled, 0);
+    HpackDecoderPool::setMaxPooledBytes(1 << 20);
+}
+
+/**
+ * 统计上游分配次数的内存资源
+ */
+class CountingResource : public std::pmr::memory_resource {
+public:
+    size_t allocations = 0;
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        ++allocations;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+/**
+ * 测试解码到流 arena：上游分配次数与头字段数量无关
+ */
+TEST_F(StatefulCodecTest, ArenaDecodeAllocatesPerStream) {
+    auto upstream_allocations = [](size_t header_count) {
+        std::vector<std::pair<std::string, std::string>> headers;
+        for (size_t i = 0; i < header_count; ++i) {
+            headers.push_back({"x-header-" + std::to_string(i),
+                               "a value long enough to defeat small string storage " + std::to_string(i)});
+        }
+        HpackEncoder encoder;
+        HpackDecoder decoder;
+        auto block = encoder.encode(headers);
+
+        CountingResource upstream;
+        StreamArena arena(&upstream);
+        PmrHeaderList decoded(arena.resource());
+        decoder.decode(block.data(), block.size(), decoded);
+
+        EXPECT_EQ(decoded.size(), header_count);
+        EXPECT_EQ(std::string_view(decoded.back().first), headers.back().first);
+        EXPECT_EQ(std::string_view(decoded.back().second), headers.back().second);
+        return upstream.allocations;
+    };
+
+    // 小响应完全落在内联缓冲区；大响应只按几何增长申请少量大块
+    EXPECT_EQ(upstream_allocations(5), 0);
+    EXPECT_LE(upstream_allocations(40), 4);
+}
+
+/**
+ * 测试视图解码与字符串解码结果一致
+ */
+TEST_F(StatefulCodecTest, DecodeViewsMatchesDecode) {
+    HpackEncoder encoder;
+    HpackDecoder by_value;
+    HpackDecoder by_view;
+    std::vector<std::pair<std::string, std::string>> headers = {
+        {":method", "GET"}, {":path", "/index.html"}, {"x-trace", "abcdef"}};
+
+    for (int round = 0; round < 2; ++round) {
+        auto block = encoder.encode(headers);
+        std::vector<std::pair<std::string, std::string>> viewed;
+        by_view.decodeViews(block.data(), block.size(), [&](std::string_view name, std::string_view value) {
+            viewed.emplace_back(name, value);
+        });
+        EXPECT_EQ(viewed, by_value.decode(block.data(), block.size()));
+    }
+}
+
+/**
+ * 测试视图解码报告无效头块：越界索引与截断的字面量
+ */
+TEST_F(StatefulCodecTest, DecodeViewsReportsMalformedBlock) {
+    HpackDecoder decoder;
+    auto ignore = [](std::string_view, std::string_view) {};
+
+    // 索引 70 超出静态表，动态表为空
+    const uint8_t out_of_range[] = {0xc6};
+    EXPECT_FALSE(decoder.decodeViews(out_of_range, sizeof(out_of_range), ignore));
+
+    // 字面量声明长度 10，实际只有 2 字节
+    const uint8_t truncated[] = {0x40, 0x0a, 'a', 'b'};
+    EXPECT_FALSE(decoder.decodeViews(truncated, sizeof(truncated), ignore));
+
+    const uint8_t valid[] = {0x82, 0x84};  // :method GET, :path /
+    EXPECT_TRUE(decoder.decodeViews(valid, sizeof(valid), ignore));
+}
+
+/**
+ * 测试超过通告上限的动态表大小更新被拒绝，治理器上限同样生效
+ */
+TEST_F(StatefulCodecTest, DecodeViewsRejectsOversizedTableUpdate) {
+    HpackMemoryGovernor governor(4096);
+    HpackDecoder decoder;
+    auto ignore = [](std::string_view, std::string_view) {};
+
+    // 8192 = 31 + 8161，超过构造时的 4096
+    const uint8_t grow[] = {0x3f, 0xe1, 0x3f, 0x82};
+    EXPECT_FALSE(decoder.decodeViews(grow, sizeof(grow), ignore));
+    EXPECT_EQ(decoder.table().dynamicTable().maxSize(), 4096u);
+
+    // 第二个解码器注册后上限降为 2048：4096 不再允许，2048 允许
+    decoder.setMemoryGovernor(&governor);
+    HpackDecoder other;
+    other.setMemoryGovernor(&governor);
+    ASSERT_EQ(decoder.advertisedTableSize(), 2048u);
+    const uint8_t restore[] = {0x3f, 0xe1, 0x1f, 0x82};  // 4096 = 31 + 4065
+    EXPECT_FALSE(decoder.decodeViews(restore, sizeof(restore), ignore));
+    const uint8_t shrink[] = {0x3f, 0xe1, 0x0f, 0x82};   // 2048 = 31 + 2017
+    EXPECT_TRUE(decoder.decodeViews(shrink, sizeof(shrink), ignore));
+    EXPECT_EQ(decoder.table().dynamicTable().maxSize(), 2048u);
+}
+
+/**
+ * 测试出现在首个头字段之后的动态表大小更新被拒绝（RFC 7541 4.2）
+ */
+TEST_F(StatefulCodecTest, DecodeViewsRejectsTableUpdateAfterField) {
+    HpackDecoder decoder;
+    size_t fields = 0;
+    auto count = [&fields](std::string_view, std::string_view) { ++fields; };
+
+    // 开头连续的两个更新合法
+    const uint8_t leading[] = {0x20, 0x3f, 0xe1, 0x1f, 0x82};
+    EXPECT_TRUE(decoder.decodeViews(leading, sizeof(leading), count));
+    EXPECT_EQ(fields, 1u);
+
+    const uint8_t trailing[] = {0x82, 0x20, 0x84};
+    EXPECT_FALSE(decoder.decodeViews(trailing, sizeof(trailing), count));
+    EXPECT_EQ(decoder.table().dynamicTable().maxSize(), 4096u);
+
+    // 逐字段解码的容错路径同样不应用该更新（末尾的字面量被截断）
+    const uint8_t truncated[] = {0x82, 0x20, 0x40, 0x0a, 'a'};
+    EXPECT_FALSE(decoder.decodeViews(truncated, sizeof(truncated), count));
+    EXPECT_EQ(decoder.table().dynamicTable().maxSize(), 4096u);
+}
+
+// ============================================================================
+// Compile-time Encoding Tests - 编译期编码测试
+// ============================================================================
+
+namespace {
+
+constexpr ConstHeader AUTHORITY_HEADERS[] = {
+    {":method", "GET"},
+    {":authority", "www.example.com"},
+};
+constexpr auto AUTHORITY_BLOCK = HTTP2_CONST_HEADER_BLOCK(AUTHORITY_HEADERS);
+
+constexpr ConstHeader GRPC_HEADERS[] = {
+    {":method", "POST"},
+    {":scheme", "https"},
+    {"content-type", "application/grpc"},
+    {"te", "trailers"},
+};
+constexpr auto GRPC_BLOCK = HTTP2_CONST_HEADER_BLOCK(GRPC_HEADERS);
+
+// 在编译期即可验证：静态表索引 + RFC 7541 C.4.1 的 Huffman 编码
+static_assert(AUTHORITY_BLOCK.size() == 15, "indexed + name-indexed Huffman literal");
+static_assert(AUTHORITY_BLOCK[0] == 0x82, ":method GET is static index 2");
+static_assert(AUTHORITY_BLOCK[1] == 0x01, "literal without indexing, name index 1");
+static_assert(AUTHORITY_BLOCK[2] == 0x8c, "Huffman flag, 12 bytes");
+
+} // namespace
+
+class ConstEncodingTest : public ::testing::Test {
+protected:
+    void SetUp() override {}
+};
+
+/**
+ * 测试编译期生成的字节与 RFC 7541 C.4.1 示例一致
+ */
+TEST_F(ConstEncodingTest, MatchesRFC7541HuffmanExample) {
+    std::vector<uint8_t> expected = {
+        0x82, 0x01, 0x8c,
+        0xf1, 0xe3, 0xc2, 0xe5, 0xf2, 0x3a, 0x6b, 0xa0, 0xab, 0x90, 0xf4, 0xff,
+    };
+    EXPECT_EQ(std::vector<uint8_t>(AUTHORITY_BLOCK.begin(), AUTHORITY_BLOCK.end()), expected);
+}
+
+/**
+ * 测试常量头块可被任意状态的解码器解码
+ */
+TEST_F(ConstEncodingTest, DecodesWithAnyDecoderState) {
+    HpackDecoder fresh;
+    HpackDecoder used;
+    used.table().insertDynamic({"x-existing", "value"});
+
+    for (HpackDecoder* decoder : {&fresh, &used}) {
+        auto decoded = decoder->decode(GRPC_BLOCK.data(), GRPC_BLOCK.size());
+        ASSERT_EQ(decoded.size(), 4);
+        EXPECT_EQ(decoded[2].first, "content-type");
+        EXPECT_EQ(decoded[2].second, "application/grpc");
+        EXPECT_EQ(decoded[3].first, "te");
+        EXPECT_EQ(decoded[3].second, "trailers");
+    }
+    // 常量头块不会修改动态表
+    EXPECT_EQ(used.table().getIndexByName("x-existing"), 62);
+}
+
+// ============================================================================
+// Transcoding Tests - 头块转码测试
+// ============================================================================
+
+class TranscoderTest : public ::testing::Test {
+protected:
+    void SetUp() override {}
+};
+
+/**
+ * 测试转码后的头块在出站连接上解码得到相同的头列表，索引被正确翻译
+ */
+TEST_F(TranscoderTest, TranslatesIndicesBetweenConnections) {
+    HpackEncoder upstream;
+    HpackDecoder proxy_in;
+    HpackEncoder proxy_out;
+    HpackDecoder downstream;
+
+    // 出站连接已有不同的动态表内容，索引与入站连接不一致
+    std::vector<uint8_t> warmup;
+    proxy_out.encodeField("x-other", "1", warmup);
+    downstream.decode(warmup.data(), warmup.size());
+
+    std::vector<std::pair<std::string, std::string>> headers = {
+        {":method", "GET"},
+        {":path", "/api/items"},
+        {"x-request-id", "abc"},
+        {"user-agent", "test-client"},
+    };
+
+    for (int round = 0; round < 2; ++round) {
+        auto incoming = upstream.encode(headers);
+        std::vector<uint8_t> outgoing;
+        auto stats = HpackTranscoder::transcode(proxy_in, proxy_out,
+                                                incoming.data(), incoming.size(), outgoing);
+        EXPECT_EQ(stats.fields, headers.size());
+        EXPECT_EQ(downstream.decode(outgoing.data(), outgoing.size()), headers);
+    }
+    EXPECT_EQ(proxy_in.table().getIndexByNameValue("x-request-id", "abc"),
+              upstream.table().getIndexByNameValue("x-request-id", "abc"));
+}
+
+/**
+ * 测试不索引字面量的 Huffman 字节原样转发，永不索引保持不变
+ */
+TEST_F(TranscoderTest, PassesLiteralBytesThrough) {
+    HpackDecoder proxy_in;
+    HpackEncoder proxy_out;
+    HpackDecoder downstream;
+
+    std::vector<uint8_t> incoming(AUTHORITY_BLOCK.begin(), AUTHORITY_BLOCK.end());
+    // Never Indexed，字面量名称 "x-secret"，原始值 "s3cr3t"
+    incoming.push_back(0x10);
+    incoming.push_back(0x08);
+    for (char c : std::string("x-secret")) incoming.push_back(static_cast<uint8_t>(c));
+    incoming.push_back(0x06);
+    for (char c : std::string("s3cr3t")) incoming.push_back(static_cast<uint8_t>(c));
+
+    std::vector<uint8_t> outgoing;
+    auto stats = HpackTranscoder::transcode(proxy_in, proxy_out,
+                                            incoming.data(), incoming.size(), outgoing);
+    EXPECT_EQ(stats.fields, 3);
+    EXPECT_EQ(stats.passthrough_fields, 2);
+    EXPECT_EQ(outgoing, incoming);
+
+    auto decoded = downstream.decode(outgoing.data(), outgoing.size());
+    ASSERT_EQ(decoded.size(), 3);
+    EXPECT_EQ(decoded[1].second, "www.example.com");
+    EXPECT_EQ(decoded[2].first, "x-secret");
+    EXPECT_EQ(proxy_out.table().getIndexByName("x-secret"), -1);
+}
+
+/**
+ * 测试出站编码器的表被缩小后，转码得到的头块以大小更新开头
+ */
+TEST_F(TranscoderTest, EmitsPendingTableSizeUpdate) {
+    HpackEncoder upstream;
+    HpackDecoder proxy_in;
+    HpackEncoder proxy_out;
+    HpackDecoder downstream;
+    std::vector<std::pair<std::string, std::string>> headers = {
+        {":method", "GET"}, {"x-request-id", "abc"}};
+
+    proxy_out.setMaxTableSize(1024);
+    auto incoming = upstream.encode(headers);
+    std::vector<uint8_t> outgoing;
+    HpackTranscoder::transcode(proxy_in, proxy_out, incoming.data(), incoming.size(), outgoing);
+    ASSERT_GE(outgoing.size(), 3u);
+    EXPECT_EQ(outgoing[0], 0x3f);  // Dynamic Table Size Update，1024 = 31 + 993
+    EXPECT_EQ(downstream.decode(outgoing.data(), outgoing.size()), headers);
+    EXPECT_EQ(downstream.table().dynamicTable().maxSize(), 1024u);
+
+    // 更新只发送一次
+    outgoing.clear();
+    incoming = upstream.encode(headers);
+    HpackTranscoder::transcode(proxy_in, proxy_out, incoming.data(), incoming.size(), outgoing);
+    ASSERT_FALSE(outgoing.empty());
+    EXPECT_NE(outgoing[0] & 0xE0, 0x20);
+    EXPECT_EQ(downstream.decode(outgoing.data(), outgoing.size()), headers);
+}
+
+/**
+ * 测试入站头块中非法的动态表大小更新：超过通告上限或出现在头字段之后
+ */
+TEST_F(TranscoderTest, RejectsInvalidTableSizeUpdates) {
+    HpackDecoder proxy_in;
+    HpackEncoder proxy_out;
+    std::vector<uint8_t> outgoing;
+
+    const uint8_t grow[] = {0x3f, 0xe1, 0x3f, 0x82};  // 8192
+    EXPECT_THROW(HpackTranscoder::transcode(proxy_in, proxy_out, grow, sizeof(grow), outgoing),
+                 std::runtime_error);
+    EXPECT_EQ(proxy_in.table().dynamicTable().maxSize(), 4096u);
+
+    const uint8_t trailing[] = {0x82, 0x20};
+    EXPECT_THROW(HpackTranscoder::transcode(proxy_in, proxy_out, trailing, sizeof(trailing), outgoing),
+                 std::runtime_error);
+    EXPECT_EQ(proxy_in.table().dynamicTable().maxSize(), 4096u);
+}
+
 } // namespace http2
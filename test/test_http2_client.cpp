@@ -0,0 +1,988 @@
+#include <gtest/gtest.h>
+#include "http2_client.h"
+#include "loopback_server.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace http2 {
+
+/**
+ * Test cases for the HTTP/2 client against a scripted loopback server
+ */
+class Http2ClientTest : public ::testing::Test {
+protected:
+    using Frame = LoopbackConnection::Frame;
+
+    static void configure(Http2Client& client) {
+        client.setTimeout(5000);
+        client.setWindowAutoTuning(false);
+    }
+
+    static std::vector<uint8_t> uint32Payload(uint32_t value) {
+        return {static_cast<uint8_t>(value >> 24), static_cast<uint8_t>(value >> 16),
+                static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value)};
+    }
+
+    static uint32_t readUint32(const std::vector<uint8_t>& payload, size_t offset = 0) {
+        return (static_cast<uint32_t>(payload[offset]) << 24) | (static_cast<uint32_t>(payload[offset + 1]) << 16) |
+               (static_cast<uint32_t>(payload[offset + 2]) << 8) | payload[offset + 3];
+    }
+
+    // 服务器发出 PING 并读到客户端的 ACK：之前的帧都已被客户端处理
+    static bool roundTrip(LoopbackConnection& connection) {
+        const std::vector<uint8_t> id(8, 0x5a);
+        connection.send(FRAME_TYPE_PING, 0, 0, id);
+        Frame frame;
+        while (connection.next(frame)) {
+            if (frame.header.type == FRAME_TYPE_PING && (frame.header.flags & FLAG_ACK) && frame.payload == id) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 连接级之外，某个流收到的 WINDOW_UPDATE 增量之和
+    static uint64_t creditReturned(const LoopbackConnection& connection, uint32_t stream_id) {
+        uint64_t total = 0;
+        for (const auto& [id, increment] : connection.window_updates) {
+            if (id == stream_id) {
+                total += increment;
+            }
+        }
+        return total;
+    }
+
+    // 读到客户端发起的（非 ACK）PING
+    static bool awaitPing(LoopbackConnection& connection, Frame& frame) {
+        while (connection.nextOfType(FRAME_TYPE_PING, frame)) {
+            if (!(frame.header.flags & FLAG_ACK)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 运行共享的事件循环直到条件满足，最多 5 秒
+    template <typename Done>
+    static bool runUntil(EventLoop& loop, Done done) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!done() && std::chrono::steady_clock::now() < deadline) {
+            loop.runOnce(100);
+        }
+        return done();
+    }
+
+    // 服务器收到请求后用 violate 发出违规的帧；返回请求的错误码，连接应已关闭
+    template <typename Violate>
+    static uint32_t violateAfterRequest(Violate violate) {
+        LoopbackServer server([&](LoopbackConnection& connection) {
+            connection.sendSettings();
+            Frame frame;
+            ASSERT_TRUE(connection.nextOfType(FRAME_TYPE_HEADERS, frame));
+            violate(connection, frame.header.stream_id);
+            drain(connection);
+        });
+        Http2Client client("127.0.0.1", server.port());
+        configure(client);
+        EXPECT_TRUE(client.connect());
+        uint32_t error_code = client.get("/").error_code;
+        EXPECT_FALSE(client.isConnected());
+        return error_code;
+    }
+
+    static std::string header(const Http2Client::Response& response, const std::string& name,
+                              bool trailer = false) {
+        for (const auto& [field, value] : trailer ? response.trailers : response.headers) {
+            if (std::string_view(field) == name) {
+                return std::string(value);
+            }
+        }
+        return "";
+    }
+
+    // 读完客户端剩余的帧直到连接关闭
+    static void drain(LoopbackConnection& connection) {
+        Frame frame;
+        while (connection.next(frame)) {
+        }
+    }
+};
+
+/**
+ * 测试超过 65535 字节初始窗口的响应体：连接级和流级都要依赖 WINDOW_UPDATE
+ */
+TEST_F(Http2ClientTest, BodyLargerThanInitialWindow) {
+    constexpr size_t BODY = 200000;
+    uint64_t stream_credit = 0;
+    uint64_t connection_credit = 0;
+    LoopbackServer server([&](LoopbackConnection& connection) {
+        connection.sendSettings();
+        Frame request;
+        ASSERT_TRUE(connection.nextOfType(FRAME_TYPE_HEADERS, request));
+        connection.sendHeaders(request.header.stream_id, 200, false);
+        EXPECT_TRUE(connection.sendData(request.header.stream_id, BODY, true));
+        drain(connection);
+        stream_credit = creditReturned(connection, request.header.stream_id);
+        connection_credit = creditReturned(connection, 0);
+    });
+
+    Http2Client client("127.0.0.1", server.port());
+    configure(client);
+    client.setReceiveWindow(DEFAULT_WINDOW_SIZE, DEFAULT_WINDOW_SIZE);
+    ASSERT_TRUE(client.connect());
+    Http2Client::Response response = client.get("/");
+    EXPECT_EQ(response.error_code, 0u);
+    EXPECT_EQ(response.status_code, 200);
+    ASSERT_EQ(response.body.size(), BODY);
+    EXPECT_TRUE(std::all_of(response.body.begin(), response.body.end(), [](uint8_t c) { return c == 'x'; }));
+    client.disconnect();
+    server.stop();
+
+    EXPECT_GE(stream_credit, BODY - DEFAULT_WINDOW_SIZE);
+    EXPECT_GE(connection_credit, BODY - DEFAULT_WINDOW_SIZE);
+}
+
+/**
+ * 测试超过 16 MiB 默认连接窗口的响应体
+ */
+TEST_F(Http2ClientTest, BodyLargerThanConnectionWindow) {
+    constexpr size_t BODY = (16u << 20) + 12345;
+    LoopbackServer server([&](LoopbackConnection& connection) {
+        connection.sendSettings();
+        Frame request;
+        ASSERT_TRUE(connection.nextOfType(FRAME_TYPE_HEADERS, request));
+        connection.sendHeaders(request.header.stream_id, 200, false);
+        EXPECT_TRUE(connection.sendData(request.header.stream_id, BODY, true));
+        drain(connection);
+    });
+
+    Http2Client client("127.0.0.1", server.port());
+    configure(client);
+    ASSERT_TRUE(client.connect());
+    Http2Client::Response response = client.get("/");
+    EXPECT_EQ(response.error_code, 0u);
+    EXPECT_EQ(response.body.size(), BODY);
+}
+
+/**
+ * 测试流级额度累计到窗口的一半才归还，归还的是全部累计额度
+ */
+TEST_F(Http2ClientTest, WindowUpdateAtHalfWindow) {
+    constexpr uint32_t WINDOW = 65536;
+    uint64_t before_half = 0;
+    uint64_t at_half = 0;
+    LoopbackServer server([&](LoopbackConnection& connection) {
+        connection.sendSettings();
+        Frame request;
+        ASSERT_TRUE(connection.nextOfType(FRAME_TYPE_HEADERS, request));
+        uint32_t stream_id = request.header.stream_id;
+        connection.sendHeaders(stream_id, 200, false);
+        ASSERT_TRUE(connection.sendData(stream_id, WINDOW / 2 - 1, false));
+        ASSERT_TRUE(roundTrip(connection));
+        before_half = creditReturned(connection, stream_id);
+        ASSERT_TRUE(connection.sendData(stream_id, 1, false));
+        ASSERT_TRUE(roundTrip(connection));
+        at_half = creditReturned(connection, stream_id);
+        ASSERT_TRUE(connection.sendData(stream_id, 0, true));
+        drain(connection);
+    });
+
+    Http2Client client("127.0.0.1", server.port());
+    configure(client);
+    client.setReceiveWindow(WINDOW, 1u << 20);
+    ASSERT_TRUE(client.connect());
+    Http2Client::Response response = client.get("/");
+    EXPECT_EQ(response.body.size(), WINDOW / 2);
+    client.disconnect();
+    server.stop();
+
+    EXPECT_EQ(before_half, 0u);
+    EXPECT_EQ(at_half, WINDOW / 2);
+}
+
+/**
+ * 测试对端超出连接级接收窗口：所有流以 FLOW_CONTROL_ERROR 结束
+ */
+TEST_F(Http2ClientTest, ConnectionWindowOverrunIsFlowControlError) {
+    LoopbackServer server([&](LoopbackConnection& connection) {
+        connection.sendSettings();
+        Frame request;
+        ASSERT_TRUE(connection.nextOfType(FRAME_TYPE_HEADERS, request));
+        connection.sendHeaders(request.header.stream_id, 200, false);
+        // 不经过 sendData 的窗口检查：一帧就超出 65535 字节的连接窗口
+        connection.send(FRAME_TYPE_DATA, 0, request.header.stream_id, std::vector<uint8_t>(DEFAULT_WINDOW_SIZE + 1));
+        drain(connection);
+    });
+
+    Http2Client client("127.0.0.1", server.port());
+    configure(client);
+    client.setReceiveWindow(1u << 20, DEFAULT_WINDOW_SIZE);
+    ASSERT_TRUE(client.connect());
+    Http2Client::Response response = client.get("/");
+    EXPECT_EQ(response.error_code, 3u);  // FLOW_CONTROL_ERROR
+    EXPECT_FALSE(client.isConnected());
+}
+
+/**
+ * 测试对端超出流级接收窗口：只重置该流，连接继续可用
+ */
+TEST_F(Http2ClientTest, StreamWindowOverrunResetsStream) {
+    constexpr uint32_t WINDOW = 16384;
+    uint32_t reset_code = 0;
+    LoopbackServer server([&](LoopbackConnection& connection) {
+        connection.sendSettings();
+        Frame frame;
+        ASSERT_TRUE(connection.nextOfType(FRAME_TYPE_HEADERS, frame));
+        uint32_t stream_id = frame.header.stream_id;
+        connection.sendHeaders(stream_id, 200, false);
+        connection.send(FRAME_TYPE_DATA, 0, stream_id, std::vector<uint8_t>(WINDOW + 1));
+        ASSERT_TRUE(connection.nextOfType(FRAME_TYPE_RST_STREAM, frame));
+        EXPECT_EQ(frame.header.stream_id, stream_id);
+        reset_code = readUint32(frame.payload);
+        LoopbackServer::respondEmpty(connection);
+    });
+
+    Http2Client client("127.0.0.1", server.port());
+    configure(client);
+    client.setReceiveWindow(WINDOW, 1u << 20);
+    ASSERT_TRUE(client.connect());
+    EXPECT_EQ(client.get("/").error_code, 3u);  // FLOW_CONTROL_ERROR
+    EXPECT_TRUE(client.isConnected());
+    EXPECT_EQ(client.get("/").status_code, 200);
+    client.disconnect();
+    server.stop();
+
+    EXPECT_EQ(reset_code, 3u);
+}
+
+/**
+ * 测试增量为 0 的 WINDOW_UPDATE：流级重置该流，连接级是连接错误（PROTOCOL_ERROR）
+ */
+TEST_F(Http2ClientTest, ZeroIncrementWindowUpdate) {
+    uint32_t reset_code = 0;
+    LoopbackServer server([&](LoopbackConnection& connection) {
+        connection.sendSettings();
+        Frame frame;
+        ASSERT_TRUE(connection.nextOfType(FRAME_TYPE_HEADERS, frame));
+        connection.send(FRAME_TYPE_WINDOW_UPDATE, 0, frame.header.stream_id, uint32Payload(0));
+        ASSERT_TRUE(connection.nextOfType(FRAME_TYPE_RST_STREAM, frame));
+        reset_code = readUint32(frame.payload);
+
+        ASSERT_TRUE(connection.nextOfType(FRAME_TYPE_HEADERS, frame));
+        connection.send(FRAME_TYPE_WINDOW_UPDATE, 0, 0, uint32Payload(0));
+        drain(connection);
+    });
+
+    Http2Client client("127.0.0.1", server.port());
+    configure(client);
+    ASSERT_TRUE(client.connect());
+    EXPECT_EQ(client.get("/").error_code, 1u);  // PROTOCOL_ERROR
+    EXPECT_TRUE(client.isConnected());
+    EXPECT_EQ(client.get("/").error_code, 1u);
+    EXPECT_FALSE(client.isConnected());
+    server.stop();
+
+    EXPECT_EQ(reset_code, 1u);
+}
+
+/**
+ * 测试发送窗口超过 2^31-1：流级重置该流，连接级是连接错误（FLOW_CONTROL_ERROR）
+ */
+TEST_F(Http2ClientTest, SendWindowOverflow) {
+    uint32_t reset_code = 0;
+    LoopbackServer server([&](LoopbackConnection& connection) {
+        connection.sendSettings();
+        Frame frame;
+        ASSERT_TRUE(connection.nextOfType(FRAME_TYPE_HEADERS, frame));
+        // 初始窗口 65535 加上最大增量
+        connection.send(FRAME_TYPE_WINDOW_UPDATE, 0, frame.header.stream_id, uint32Payload(MAX_WINDOW_SIZE));
+        ASSERT_TRUE(connection.nextOfType(FRAME_TYPE_RST_STREAM, frame));
+        reset_code = readUint32(frame.payload);
+
+        // 恰好到达上限的增量合法
+        ASSERT_TRUE(connection.nextOfType(FRAME_TYPE_HEADERS, frame));
+        connection.send(FRAME_TYPE_WINDOW_UPDATE, 0, 0, uint32Payload(MAX_WINDOW_SIZE - DEFAULT_WINDOW_SIZE));
+        connection.sendHeaders(frame.header.stream_id, 200, true);
+
+        ASSERT_TRUE(connection.nextOfType(FRAME_TYPE_HEADERS, frame));
+        connection.send(FRAME_TYPE_WINDOW_UPDATE, 0, 0, uint32Payload(1));
+        drain(connection);
+    });
+
+    Http2Client client("127.0.0.1", server.port());
+    configure(client);
+    ASSERT_TRUE(client.connect());
+    EXPECT_EQ(client.get("/").error_code, 3u);  // FLOW_CONTROL_ERROR
+    EXPECT_EQ(client.get("/").status_code, 200);
+    EXPECT_EQ(client.get("/").error_code, 3u);
+    EXPECT_FALSE(client.isConnected());
+    server.stop();
+
+    EXPECT_EQ(reset_code, 3u);
+}
+
+/**
+ * 测试窗口调整：一个往返内收到的字节达到窗口的 2/3 时扩大到估计值的两倍
+ */
+TEST_F(Http2ClientTest, TuneWindowGrowsAtTwoThirds) {
+    constexpr uint32_t BASE = DEFAULT_WINDOW_SIZE;
+    constexpr uint32_t MAX = 1u << 20;
+    // 65535 * 2/3 = 43690
+    EXPECT_EQ(Http2Client::tuneWindow(BASE, BASE, MAX, 43690), 87380u);
+    EXPECT_EQ(Http2Client::tuneWindow(BASE, BASE, MAX, 43689), BASE);
+    // 估计值的两倍小于当前窗口时不缩小
+    EXPECT_EQ(Http2Client::tuneWindow(200000, BASE, MAX, 140000), 280000u);
+}
+
+/**
+ * 测试窗口调整：扩大不超过上限，已达上限的窗口保持不变
+ */
+TEST_F(Http2ClientTest, TuneWindowCapsAtMax) {
+    constexpr uint32_t BASE = DEFAULT_WINDOW_SIZE;
+    constexpr uint32_t MAX = 1u << 20;
+    EXPECT_EQ(Http2Client::tuneWindow(BASE, BASE, MAX, 10u << 20), MAX);
+    EXPECT_EQ(Http2Client::tuneWindow(MAX, BASE, MAX, MAX), MAX);
+    // 上限低于当前窗口（setWindowAutoTuning 降低了上限）时也不会因为扩大而缩小
+    EXPECT_EQ(Http2Client::tuneWindow(MAX, BASE, MAX / 2, MAX), MAX);
+}
+
+/**
+ * 测试窗口调整：不到窗口的 1/4 时缩小，每次最多减半，不低于基准值
+ */
+TEST_F(Http2ClientTest, TuneWindowShrinksToBase) {
+    constexpr uint32_t BASE = DEFAULT_WINDOW_SIZE;
+    constexpr uint32_t MAX = 16u << 20;
+    constexpr uint32_t CURRENT = 1u << 20;
+    EXPECT_EQ(Http2Client::tuneWindow(CURRENT, BASE, MAX, CURRENT / 4), CURRENT);
+    EXPECT_EQ(Http2Client::tuneWindow(CURRENT, BASE, MAX, CURRENT / 4 - 1), CURRENT / 2);
+    EXPECT_EQ(Http2Client::tuneWindow(CURRENT, BASE, MAX, 1000), CURRENT / 2);
+    EXPECT_EQ(Http2Client::tuneWindow(CURRENT, BASE, MAX, 0), CURRENT / 2);
+    EXPECT_EQ(Http2Client::tuneWindow(100000, BASE, MAX, 0), BASE);
+    EXPECT_EQ(Http2Client::tuneWindow(BASE, BASE, MAX, 0), BASE);
+}
+
+/**
+ * 测试按测量的带宽时延积调整窗口：扩大后的额度随下一次归还通告；缩小后额度为负，
+ * 抵扣完缩小的部分才再次归还，对端看到的窗口回到新的大小
+ */
+TEST_F(Http2ClientTest, AutoTuningFollowsMeasuredBdp) {
+    constexpr uint32_t BASE = DEFAULT_WINDOW_SIZE;
+    constexpr uint32_t GROWN = 2 * (16384 + 40000);
+    int64_t grown_window = 0;
+    int64_t final_window = 0;
+    uint64_t grown_credit = 0;
+    uint64_t credit_at_shrink = 0;
+    uint64_t credit_before_repaid = 0;
+    uint64_t credit_after_repaid = 0;
+    LoopbackServer server([&](LoopbackConnection& connection) {
+        connection.auto_ping_ack = false;
+        connection.sendSettings();
+        Frame frame;
+        ASSERT_TRUE(connection.nextOfType(FRAME_TYPE_HEADERS, frame));
+        uint32_t stream_id = frame.header.stream_id;
+        connection.sendHeaders(stream_id, 200, false);
+
+        // 第一次测量：PING 往返期间收到 16384 + 40000 字节，超过窗口的 2/3
+        ASSERT_TRUE(connection.sendData(stream_id, 16384, false));
+        ASSERT_TRUE(awaitPing(connection, frame));
+        ASSERT_TRUE(connection.sendData(stream_id, 40000, false));
+        connection.send(FRAME_TYPE_PING, FLAG_ACK, 0, frame.payload);
+        ASSERT_TRUE(roundTrip(connection));
+        uint64_t before_growth = creditReturned(connection, stream_id);
+
+        // 第二次测量：只收到 10000 字节；这些字节让扩大的额度一起归还
+        ASSERT_TRUE(connection.sendData(stream_id, 10000, false));
+        ASSERT_TRUE(awaitPing(connection, frame));
+        connection.send(FRAME_TYPE_PING, FLAG_ACK, 0, frame.payload);
+        ASSERT_TRUE(roundTrip(connection));
+        grown_credit = creditReturned(connection, stream_id) - before_growth;
+        grown_window = connection.streamWindow(stream_id);
+
+        // 窗口缩回 65535：额度欠 GROWN - BASE，归还阈值是新窗口的一半
+        credit_at_shrink = creditReturned(connection, stream_id);
+        for (int i = 1; i <= 8; ++i) {
+            ASSERT_TRUE(connection.sendData(stream_id, 10000, false));
+            ASSERT_TRUE(roundTrip(connection));
+            if (i == 7) {
+                credit_before_repaid = creditReturned(connection, stream_id);
+            }
+        }
+        credit_after_repaid = creditReturned(connection, stream_id);
+        final_window = connection.streamWindow(stream_id);
+        ASSERT_TRUE(connection.sendData(stream_id, 0, true));
+        drain(connection);
+    });
+
+    Http2Client client("127.0.0.1", server.port());
+    client.setTimeout(5000);
+    client.setReceiveWindow(BASE, BASE);
+    client.setWindowAutoTuning(true, 1u << 20);
+    ASSERT_TRUE(client.connect());
+    Http2Client::FlowControlStats initial = client.flowControlStats();
+    EXPECT_EQ(initial.pings, 0u);
+    EXPECT_EQ(initial.stream_window, BASE);
+
+    Http2Client::Response response = client.get("/");
+    EXPECT_EQ(response.error_code, 0u);
+    EXPECT_EQ(response.body.size(), 16384u + 40000 + 10000 + 8 * 10000);
+    Http2Client::FlowControlStats stats = client.flowControlStats();
+    client.disconnect();
+    server.stop();
+
+    EXPECT_EQ(grown_credit, GROWN - BASE + 10000);
+    EXPECT_EQ(grown_window, GROWN);
+    EXPECT_EQ(credit_before_repaid, credit_at_shrink);
+    EXPECT_EQ(credit_after_repaid - credit_at_shrink, 80000 - (GROWN - BASE));
+    EXPECT_EQ(final_window, BASE);
+
+    EXPECT_GE(stats.pings, 2u);
+    EXPECT_EQ(stats.increases, 1u);
+    EXPECT_EQ(stats.decreases, 1u);
+    EXPECT_EQ(stats.bdp, 10000u);
+    EXPECT_GT(stats.rtt.count(), 0);
+    EXPECT_GT(stats.delivery_rate, 0u);
+    EXPECT_EQ(stats.stream_window, BASE);
+    EXPECT_EQ(stats.connection_window, BASE);
+}
+
+/**
+ * 测试消费驱动的流：未处理的数据达到上限时停止，其他流照常传输；
+ * consume() 之后恢复
+ */
+TEST_F(Http2ClientTest, ConsumerDrivenStreamStallsAtLimit) {
+    constexpr uint32_t LIMIT = 32768;
+    constexpr size_t BODY = 100000;
+    int64_t stalled_window = -1;
+    uint64_t stalled_credit = 1;
+    LoopbackServer server([&](LoopbackConnection& connection) {
+        connection.sendSettings();
+        Frame frame;
+        ASSERT_TRUE(connection.nextOfType(FRAME_TYPE_HEADERS, frame));
+        uint32_t slow = frame.header.stream_id;
+        ASSERT_TRUE(connection.nextOfType(FRAME_TYPE_HEADERS, frame));
+        uint32_t fast = frame.header.stream_id;
+        connection.sendHeaders(slow, 200, false);
+        connection.sendHeaders(fast, 200, false);
+
+        // 消费驱动的流只能收到一个窗口；另一个流依赖归还的额度传输多个窗口
+        ASSERT_TRUE(connection.sendData(slow, LIMIT, false));
+        ASSERT_TRUE(connection.sendData(fast, BODY, false));
+        ASSERT_TRUE(roundTrip(connection));
+        stalled_window = connection.streamWindow(slow);
+        stalled_credit = creditReturned(connection, slow);
+        ASSERT_TRUE(connection.sendData(fast, 0, true));
+
+        // 等待调用方 consume() 归还的额度
+        ASSERT_TRUE(connection.sendData(slow, BODY - LIMIT, true));
+        drain(connection);
+    });
+
+    EventLoop loop;
+    Http2Client client("127.0.0.1", server.port(), &loop);
+    configure(client);
+    client.setReceiveWindow(LIMIT, 1u << 20);
+    client.setStreamBufferLimit(LIMIT);
+    ASSERT_TRUE(client.connect());
+
+    Http2Client::StreamCredit credit;
+    size_t received = 0;
+    bool consume_immediately = false;
+    bool done = false;
+    Http2Client::StreamHandler handler;
+    handler.on_open = [&](Http2Client::StreamCredit stream_credit) { credit = stream_credit; };
+    handler.on_data = [&](const uint8_t*, size_t length) {
+        received += length;
+        if (consume_immediately) {
+            credit.consume(length);
+        }
+    };
+    client.submitAsync("GET", "/slow", {}, [&](Http2Client::Response&& response) {
+        EXPECT_EQ(response.error_code, 0u);
+        done = true;
+    }, handler);
+    uint32_t fast = client.submit("GET", "/fast");
+    ASSERT_NE(fast, 0u);
+
+    Http2Client::Response response = client.wait(fast);
+    EXPECT_EQ(response.error_code, 0u);
+    EXPECT_EQ(response.body.size(), BODY);
+    EXPECT_EQ(received, LIMIT);
+    EXPECT_FALSE(done);
+
+    consume_immediately = true;
+    credit.consume(received);
+    EXPECT_TRUE(runUntil(loop, [&] { return done; }));
+    EXPECT_EQ(received, BODY);
+    client.disconnect();
+    server.stop();
+
+    EXPECT_EQ(stalled_window, 0);
+    EXPECT_EQ(stalled_credit, 0u);
+}
+
+/**
+ * 测试重新连接之后，旧连接的 StreamCredit 不再影响新连接上同一ID的流
+ */
+TEST_F(Http2ClientTest, StreamCreditIgnoredAfterReconnect) {
+    std::atomic<int> connections{0};
+    uint64_t stale_credit = 1;
+    LoopbackServer server([&](LoopbackConnection& connection) {
+        int index = ++connections;
+        connection.sendSettings();
+        Frame frame;
+        ASSERT_TRUE(connection.nextOfType(FRAME_TYPE_HEADERS, frame));
+        uint32_t stream_id = frame.header.stream_id;
+        connection.sendHeaders(stream_id, 200, false);
+        ASSERT_TRUE(connection.sendData(stream_id, 16384, false));
+        if (index == 2) {
+            // 旧句柄的 consume() 若生效，WINDOW_UPDATE 会排在下一个请求之前
+            ASSERT_TRUE(connection.nextOfType(FRAME_TYPE_HEADERS, frame));
+            stale_credit = creditReturned(connection, stream_id);
+            connection.sendHeaders(frame.header.stream_id, 200, true);
+        }
+        drain(connection);
+    });
+
+    EventLoop loop;
+    Http2Client client("127.0.0.1", server.port(), &loop);
+    configure(client);
+    client.setReceiveWindow(32768, 1u << 20);
+    client.setStreamBufferLimit(32768);
+
+    std::vector<Http2Client::StreamCredit> credits;
+    size_t received = 0;
+    Http2Client::StreamHandler handler;
+    handler.on_open = [&](Http2Client::StreamCredit credit) { credits.push_back(credit); };
+    handler.on_data = [&](const uint8_t*, size_t length) { received += length; };
+
+    ASSERT_TRUE(client.connect());
+    client.submitAsync("GET", "/", {}, [](Http2Client::Response&&) {}, handler);
+    ASSERT_TRUE(runUntil(loop, [&] { return received == 16384; }));
+
+    ASSERT_TRUE(client.connect());
+    client.submitAsync("GET", "/", {}, [](Http2Client::Response&&) {}, handler);
+    ASSERT_TRUE(runUntil(loop, [&] { return received == 2 * 16384; }));
+    ASSERT_EQ(credits.size(), 2u);
+    credits[0].consume(16384);
+    EXPECT_EQ(client.get("/next").status_code, 200);
+    client.disconnect();
+    server.stop();
+
+    EXPECT_EQ(stale_credit, 0u);
+}
+
+/**
+ * 测试服务器的 SETTINGS_ENABLE_PUSH = 1 是 PROTOCOL_ERROR（第一个 SETTINGS 中连接失败）
+ */
+TEST_F(Http2ClientTest, SettingsEnablePushIsProtocolError) {
+    LoopbackServer server([](LoopbackConnection& connection) {
+        connection.sendSettings({{0x2, 1}});
+        drain(connection);
+    });
+    Http2Client client("127.0.0.1", server.port());
+    configure(client);
+    EXPECT_FALSE(client.connect());
+
+    EXPECT_EQ(violateAfterRequest([](LoopbackConnection& connection, uint32_t) {
+        connection.sendSettings({{0x2, 1}});
+    }), 1u);  // PROTOCOL_ERROR
+    EXPECT_EQ(violateAfterRequest([](LoopbackConnection& connection, uint32_t) {
+        connection.sendSettings({{0x2, 0}, {0x2, 2}});
+    }), 1u);
+}
+
+/**
+ * 测试 SETTINGS_MAX_FRAME_SIZE 超出 16384 ~ 16777215 是 PROTOCOL_ERROR
+ */
+TEST_F(Http2ClientTest, SettingsMaxFrameSizeOutOfRange) {
+    EXPECT_EQ(violateAfterRequest([](LoopbackConnection& connection, uint32_t) {
+        connection.sendSettings({{0x5, DEFAULT_MAX_FRAME_SIZE - 1}});
+    }), 1u);  // PROTOCOL_ERROR
+    EXPECT_EQ(violateAfterRequest([](LoopbackConnection& connection, uint32_t) {
+        connection.sendSettings({{0x5, MAX_ALLOWED_FRAME_SIZE + 1}});
+    }), 1u);
+
+    // 边界值合法
+    LoopbackServer server([](LoopbackConnection& connection) {
+        connection.sendSettings({{0x5, DEFAULT_MAX_FRAME_SIZE}, {0x5, MAX_ALLOWED_FRAME_SIZE}});
+        LoopbackServer::respondEmpty(connection);
+    });
+    Http2Client client("127.0.0.1", server.port());
+    configure(client);
+    ASSERT_TRUE(client.connect());
+    EXPECT_EQ(client.get("/").status_code, 200);
+}
+
+/**
+ * 测试 SETTINGS_INITIAL_WINDOW_SIZE 超过 2^31-1 是 FLOW_CONTROL_ERROR
+ */
+TEST_F(Http2ClientTest, SettingsInitialWindowTooLarge) {
+    EXPECT_EQ(violateAfterRequest([](LoopbackConnection& connection, uint32_t) {
+        connection.sendSettings({{0x4, MAX_WINDOW_SIZE + 1}});
+    }), 3u);  // FLOW_CONTROL_ERROR
+}
+
+/**
+ * 测试长度不是 6 的倍数的 SETTINGS 和带负载的 SETTINGS ACK 是 FRAME_SIZE_ERROR
+ */
+TEST_F(Http2ClientTest, MalformedSettingsLength) {
+    EXPECT_EQ(violateAfterRequest([](LoopbackConnection& connection, uint32_t) {
+        connection.send(FRAME_TYPE_SETTINGS, 0, 0, std::vector<uint8_t>{0, 0x3, 0, 0, 0});
+    }), 6u);  // FRAME_SIZE_ERROR
+    EXPECT_EQ(violateAfterRequest([](LoopbackConnection& connection, uint32_t) {
+        connection.send(FRAME_TYPE_SETTINGS, FLAG_ACK, 0, std::vector<uint8_t>{0, 0x3, 0, 0, 0, 1});
+    }), 6u);
+}
+
+/**
+ * 测试已通告 SETTINGS_ENABLE_PUSH = 0 后收到 PUSH_PROMISE 是 PROTOCOL_ERROR
+ */
+TEST_F(Http2ClientTest, PushPromiseRejected) {
+    uint32_t advertised_push = 1;
+    EXPECT_EQ(violateAfterRequest([&](LoopbackConnection& connection, uint32_t stream_id) {
+        advertised_push = connection.clientSettings().at(0x2);
+        std::vector<uint8_t> payload = uint32Payload(2);
+        payload.push_back(0x82);  // :method GET
+        connection.send(FRAME_TYPE_PUSH_PROMISE, FLAG_END_HEADERS, stream_id, payload);
+    }), 1u);  // PROTOCOL_ERROR
+    EXPECT_EQ(advertised_push, 0u);
+}
+
+/**
+ * 测试超过对端 SETTINGS_MAX_HEADER_LIST_SIZE 的请求在发出之前被拒绝，连接继续可用
+ */
+TEST_F(Http2ClientTest, HeaderListSizeCheckedBeforeSending) {
+    std::vector<std::string> paths;
+    LoopbackServer server([&](LoopbackConnection& connection) {
+        connection.sendSettings({{0x6, 512}});
+        Frame frame;
+        while (connection.nextOfType(FRAME_TYPE_HEADERS, frame)) {
+            for (const auto& [name, value] : frame.headers) {
+                if (name == ":path") {
+                    paths.push_back(value);
+                }
+            }
+            connection.sendHeaders(frame.header.stream_id, 200, true);
+        }
+    });
+
+    EventLoop loop;
+    Http2Client client("127.0.0.1", server.port(), &loop);
+    configure(client);
+    ASSERT_TRUE(client.connect());
+    const std::vector<std::pair<std::string, std::string>> large = {{"x-large", std::string(600, 'a')}};
+    EXPECT_EQ(client.submit("GET", "/sync", large), 0u);
+
+    uint32_t async_error = 0;
+    bool done = false;
+    client.submitAsync("GET", "/async", large, [&](Http2Client::Response&& response) {
+        async_error = response.error_code;
+        done = true;
+    });
+    EXPECT_TRUE(runUntil(loop, [&] { return done; }));
+    EXPECT_EQ(async_error, 7u);  // REFUSED_STREAM
+
+    EXPECT_EQ(client.get("/small", {{"x-small", "b"}}).status_code, 200);
+    EXPECT_TRUE(client.isConnected());
+    client.disconnect();
+    server.stop();
+
+    EXPECT_EQ(paths, std::vector<std::string>{"/small"});
+}
+
+/**
+ * 测试本端通告的 SETTINGS_MAX_FRAME_SIZE（默认 65536）：等于上限的 DATA 帧被接受，
+ * 更大的帧是 FRAME_SIZE_ERROR
+ */
+TEST_F(Http2ClientTest, LocalMaxFrameSizeEnforced) {
+    uint32_t advertised = 0;
+    LoopbackServer server([&](LoopbackConnection& connection) {
+        connection.sendSettings();
+        Frame frame;
+        ASSERT_TRUE(connection.nextOfType(FRAME_TYPE_HEADERS, frame));
+        advertised = connection.clientSettings().at(0x5);
+        connection.sendHeaders(frame.header.stream_id, 200, false);
+        connection.send(FRAME_TYPE_DATA, FLAG_END_STREAM, frame.header.stream_id,
+                        std::vector<uint8_t>(Http2Client::DEFAULT_LOCAL_MAX_FRAME_SIZE));
+        drain(connection);
+    });
+    Http2Client client("127.0.0.1", server.port());
+    configure(client);
+    ASSERT_TRUE(client.connect());
+    Http2Client::Response response = client.get("/");
+    EXPECT_EQ(response.error_code, 0u);
+    EXPECT_EQ(response.body.size(), Http2Client::DEFAULT_LOCAL_MAX_FRAME_SIZE);
+    client.disconnect();
+    server.stop();
+    EXPECT_EQ(advertised, Http2Client::DEFAULT_LOCAL_MAX_FRAME_SIZE);
+
+    EXPECT_EQ(violateAfterRequest([](LoopbackConnection& connection, uint32_t stream_id) {
+        connection.sendHeaders(stream_id, 200, false);
+        connection.send(FRAME_TYPE_DATA, FLAG_END_STREAM, stream_id,
+                        std::vector<uint8_t>(Http2Client::DEFAULT_LOCAL_MAX_FRAME_SIZE + 1));
+    }), 6u);  // FRAME_SIZE_ERROR
+}
+
+/**
+ * 测试多个流的 HEADERS、CONTINUATION、DATA 和尾部字段交错到达时按流ID分发
+ */
+TEST_F(Http2ClientTest, InterleavedStreams) {
+    LoopbackServer server([&](LoopbackConnection& connection) {
+        connection.sendSettings();
+        std::vector<uint32_t> ids;
+        Frame frame;
+        while (ids.size() < 3 && connection.nextOfType(FRAME_TYPE_HEADERS, frame)) {
+            ids.push_back(frame.header.stream_id);
+        }
+        ASSERT_EQ(ids.size(), 3u);
+        connection.sendHeaders(ids[1], 200, false, {{"x-id", "b"}});
+        connection.sendHeaders(ids[0], 201, false, {{"x-id", "a"}});
+        ASSERT_TRUE(connection.sendData(ids[1], 1000, false, 'b'));
+        ASSERT_TRUE(connection.sendData(ids[0], 500, false, 'a'));
+        // 跨 CONTINUATION 的头块之间不能插入其他帧
+        std::vector<uint8_t> block = connection.headerBlock({{":status", "202"}, {"x-id", "c"}});
+        std::vector<uint8_t> first(block.begin(), block.begin() + 2);
+        std::vector<uint8_t> rest(block.begin() + 2, block.end());
+        connection.send(FRAME_TYPE_HEADERS, 0, ids[2], first);
+        connection.send(FRAME_TYPE_CONTINUATION, FLAG_END_HEADERS, ids[2], rest);
+        ASSERT_TRUE(connection.sendData(ids[0], 500, true, 'a'));
+        ASSERT_TRUE(connection.sendData(ids[2], 300, true, 'c'));
+        ASSERT_TRUE(connection.sendData(ids[1], 1000, false, 'b'));
+        connection.send(FRAME_TYPE_HEADERS, FLAG_END_HEADERS | FLAG_END_STREAM, ids[1],
+                        connection.headerBlock({{"x-checksum", "ok"}}));
+        drain(connection);
+    });
+
+    Http2Client client("127.0.0.1", server.port());
+    configure(client);
+    ASSERT_TRUE(client.connect());
+    uint32_t a = client.submit("GET", "/a");
+    uint32_t b = client.submit("GET", "/b");
+    uint32_t c = client.submit("GET", "/c");
+
+    Http2Client::Response response_c = client.wait(c);
+    Http2Client::Response response_a = client.wait(a);
+    Http2Client::Response response_b = client.wait(b);
+    EXPECT_EQ(response_a.status_code, 201);
+    EXPECT_EQ(header(response_a, "x-id"), "a");
+    EXPECT_EQ(std::string(response_a.body.begin(), response_a.body.end()), std::string(1000, 'a'));
+    EXPECT_EQ(response_b.status_code, 200);
+    EXPECT_EQ(header(response_b, "x-id"), "b");
+    EXPECT_EQ(std::string(response_b.body.begin(), response_b.body.end()), std::string(2000, 'b'));
+    EXPECT_EQ(header(response_b, "x-checksum", true), "ok");
+    EXPECT_EQ(response_c.status_code, 202);
+    EXPECT_EQ(header(response_c, "x-id"), "c");
+    EXPECT_EQ(std::string(response_c.body.begin(), response_c.body.end()), std::string(300, 'c'));
+    EXPECT_EQ(client.activeStreams(), 0u);
+}
+
+/**
+ * 测试 RST_STREAM 只结束对应的流
+ */
+TEST_F(Http2ClientTest, RstStreamEndsOnlyThatStream) {
+    LoopbackServer server([&](LoopbackConnection& connection) {
+        connection.sendSettings();
+        Frame first;
+        Frame second;
+        ASSERT_TRUE(connection.nextOfType(FRAME_TYPE_HEADERS, first));
+        ASSERT_TRUE(connection.nextOfType(FRAME_TYPE_HEADERS, second));
+        connection.sendHeaders(first.header.stream_id, 200, false);
+        connection.sendHeaders(second.header.stream_id, 200, false);
+        ASSERT_TRUE(connection.sendData(first.header.stream_id, 100, false));
+        connection.send(FRAME_TYPE_RST_STREAM, 0, first.header.stream_id, uint32Payload(8));  // CANCEL
+        ASSERT_TRUE(connection.sendData(second.header.stream_id, 100, true));
+        LoopbackServer::respondEmpty(connection);
+    });
+
+    Http2Client client("127.0.0.1", server.port());
+    configure(client);
+    ASSERT_TRUE(client.connect());
+    uint32_t first = client.submit("GET", "/first");
+    uint32_t second = client.submit("GET", "/second");
+    EXPECT_EQ(client.wait(first).error_code, 8u);
+    Http2Client::Response response = client.wait(second);
+    EXPECT_EQ(response.error_code, 0u);
+    EXPECT_EQ(response.body.size(), 100u);
+    EXPECT_TRUE(client.isConnected());
+    EXPECT_EQ(client.get("/").status_code, 200);
+}
+
+/**
+ * 测试 GOAWAY：last_stream_id 之后的流以 REFUSED_STREAM 结束，之前的流继续完成，
+ * 之后不再发出新请求
+ */
+TEST_F(Http2ClientTest, GoawayRefusesLaterStreams) {
+    LoopbackServer server([&](LoopbackConnection& connection) {
+        connection.sendSettings();
+        std::vector<uint32_t> ids;
+        Frame frame;
+        while (ids.size() < 3 && connection.nextOfType(FRAME_TYPE_HEADERS, frame)) {
+            ids.push_back(frame.header.stream_id);
+        }
+        ASSERT_EQ(ids.size(), 3u);
+        std::vector<uint8_t> payload = uint32Payload(ids[1]);
+        std::vector<uint8_t> error = uint32Payload(0);  // NO_ERROR
+        payload.insert(payload.end(), error.begin(), error.end());
+        connection.send(FRAME_TYPE_GOAWAY, 0, 0, payload);
+        connection.sendHeaders(ids[0], 200, true);
+        connection.sendHeaders(ids[1], 200, true);
+        drain(connection);
+    });
+
+    Http2Client client("127.0.0.1", server.port());
+    configure(client);
+    ASSERT_TRUE(client.connect());
+    uint32_t ids[3];
+    for (uint32_t& id : ids) {
+        id = client.submit("GET", "/");
+    }
+    EXPECT_EQ(client.wait(ids[2]).error_code, 7u);  // REFUSED_STREAM
+    EXPECT_EQ(client.wait(ids[0]).status_code, 200);
+    Http2Client::Response response = client.wait(ids[1]);
+    EXPECT_EQ(response.error_code, 0u);
+    EXPECT_EQ(response.status_code, 200);
+    EXPECT_EQ(client.submit("GET", "/"), 0u);
+
+    uint32_t refused = 0;
+    client.submitAsync("GET", "/", {}, [&](Http2Client::Response&& late) { refused = late.error_code; });
+    EXPECT_EQ(refused, 7u);
+}
+
+/**
+ * 测试 SETTINGS_MAX_CONCURRENT_STREAMS：超出的异步请求排队，有流结束后按提交顺序发出
+ */
+TEST_F(Http2ClientTest, MaxConcurrentStreamsQueuesRequests) {
+    constexpr size_t REQUESTS = 5;
+    size_t max_open = 0;
+    std::vector<std::string> order;
+    LoopbackServer server([&](LoopbackConnection& connection) {
+        connection.sendSettings({{0x3, 2}});
+        std::deque<uint32_t> open;
+        size_t received = 0;
+        size_t responded = 0;
+        Frame frame;
+        while (responded < REQUESTS && connection.next(frame)) {
+            if (frame.header.type == FRAME_TYPE_HEADERS) {
+                open.push_back(frame.header.stream_id);
+                max_open = std::max(max_open, open.size());
+                ++received;
+                for (const auto& [name, value] : frame.headers) {
+                    if (name == ":path") {
+                        order.push_back(value);
+                    }
+                }
+                if (open.size() == 2) {
+                    // 等一个往返：客户端多发的请求会先于 PING ACK 到达
+                    connection.send(FRAME_TYPE_PING, 0, 0, std::vector<uint8_t>(8));
+                }
+            } else if (frame.header.type == FRAME_TYPE_PING && (frame.header.flags & FLAG_ACK)) {
+                connection.sendHeaders(open.front(), 200, true);
+                open.pop_front();
+                ++responded;
+                if (received == REQUESTS && !open.empty()) {
+                    // 不会再有新请求，剩下的流逐个应答
+                    connection.send(FRAME_TYPE_PING, 0, 0, std::vector<uint8_t>(8));
+                }
+            }
+        }
+        drain(connection);
+    });
+
+    EventLoop loop;
+    Http2Client client("127.0.0.1", server.port(), &loop);
+    configure(client);
+    ASSERT_TRUE(client.connect());
+    size_t completed = 0;
+    for (size_t i = 0; i < REQUESTS; ++i) {
+        client.submitAsync("GET", "/" + std::to_string(i), {}, [&](Http2Client::Response&& response) {
+            EXPECT_EQ(response.status_code, 200);
+            EXPECT_EQ(response.error_code, 0u);
+            ++completed;
+        });
+    }
+    EXPECT_TRUE(runUntil(loop, [&] { return completed == REQUESTS; }));
+    client.disconnect();
+    server.stop();
+
+    EXPECT_EQ(max_open, 2u);
+    EXPECT_EQ(order, (std::vector<std::string>{"/0", "/1", "/2", "/3", "/4"}));
+}
+
+/**
+ * 测试头块解码失败是连接错误：流以 COMPRESSION_ERROR 结束，并向对端发送 GOAWAY
+ */
+TEST_F(Http2ClientTest, HeaderDecodeFailureIsCompressionError) {
+    uint32_t goaway_error = 0;
+    EXPECT_EQ(violateAfterRequest([&](LoopbackConnection& connection, uint32_t stream_id) {
+        // 索引 70 超出静态表，动态表为空
+        connection.send(FRAME_TYPE_HEADERS, FLAG_END_HEADERS, stream_id, std::vector<uint8_t>{0xc6});
+        Frame frame;
+        ASSERT_TRUE(connection.nextOfType(FRAME_TYPE_GOAWAY, frame));
+        ASSERT_EQ(frame.payload.size(), 8u);
+        goaway_error = readUint32(frame.payload, 4);
+    }), 9u);  // COMPRESSION_ERROR
+    EXPECT_EQ(goaway_error, 9u);
+}
+
+/**
+ * 测试没有未结束头块时收到的 CONTINUATION 是连接错误 PROTOCOL_ERROR（RFC 9113 6.10）
+ */
+TEST_F(Http2ClientTest, ContinuationWithoutHeadersIsProtocolError) {
+    uint32_t goaway_error = 0;
+    EXPECT_EQ(violateAfterRequest([&](LoopbackConnection& connection, uint32_t stream_id) {
+        connection.send(FRAME_TYPE_CONTINUATION, FLAG_END_HEADERS, stream_id, std::vector<uint8_t>{0x88});
+        Frame frame;
+        ASSERT_TRUE(connection.nextOfType(FRAME_TYPE_GOAWAY, frame));
+        ASSERT_EQ(frame.payload.size(), 8u);
+        goaway_error = readUint32(frame.payload, 4);
+    }), 1u);  // PROTOCOL_ERROR
+    EXPECT_EQ(goaway_error, 1u);
+}
+
+/**
+ * 测试 CONTINUATION 洪泛：累计头块超过通告的 SETTINGS_MAX_HEADER_LIST_SIZE 时关闭连接
+ */
+TEST_F(Http2ClientTest, ContinuationFloodClosesConnection) {
+    uint32_t advertised = 0;
+    uint32_t goaway_error = 0;
+    EXPECT_EQ(violateAfterRequest([&](LoopbackConnection& connection, uint32_t stream_id) {
+        advertised = connection.clientSettings().at(0x6);
+        connection.send(FRAME_TYPE_HEADERS, 0, stream_id, std::vector<uint8_t>{0x88});
+        // 每帧 16384 字节，第 4 帧之后超过 65536
+        for (int i = 0; i < 5; ++i) {
+            connection.send(FRAME_TYPE_CONTINUATION, 0, stream_id, std::vector<uint8_t>(16384));
+        }
+        Frame frame;
+        ASSERT_TRUE(connection.nextOfType(FRAME_TYPE_GOAWAY, frame));
+        ASSERT_EQ(frame.payload.size(), 8u);
+        goaway_error = readUint32(frame.payload, 4);
+    }), 9u);  // COMPRESSION_ERROR：头块未被解码
+    EXPECT_EQ(advertised, Http2Client::DEFAULT_LOCAL_MAX_HEADER_LIST_SIZE);
+    EXPECT_EQ(goaway_error, 9u);
+}
+
+/**
+ * 测试请求头模板的命中次数通过 templateHits() 获取：首次请求填充动态表，
+ * 第二次按索引编码后才缓存，之后的请求命中
+ */
+TEST_F(Http2ClientTest, TemplateHitsExposedByAccessor) {
+    LoopbackServer server;
+    Http2Client client("127.0.0.1", server.port());
+    configure(client);
+    ASSERT_TRUE(client.connect());
+    EXPECT_EQ(client.templateHits(), 0u);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(client.get("/item/" + std::to_string(i)).status_code, 200);
+    }
+    EXPECT_EQ(client.templateHits(), 2u);
+    client.disconnect();
+    server.stop();
+}
+
+} // namespace http2
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include "task.h"
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#if HTTP2_HAVE_COROUTINES
+
+namespace http2 {
+
+/**
+ * Test cases for the coroutine task type
+ */
+class TaskTest : public ::testing::Test {
+protected:
+    void SetUp() override {}
+
+    // 模拟事件循环：保存挂起的协程，由测试手动恢复
+    struct Event {
+        std::coroutine_handle<> waiter;
+        int value = 0;
+
+        struct Awaiter {
+            Event* event;
+
+            bool await_ready() const noexcept {
+                return false;
+            }
+            void await_suspend(std::coroutine_handle<> handle) const noexcept {
+                event->waiter = handle;
+            }
+            int await_resume() const noexcept {
+                return event->value;
+            }
+        };
+
+        Awaiter next() {
+            return Awaiter{this};
+        }
+
+        void fire(int result) {
+            value = result;
+            std::exchange(waiter, nullptr).resume();
+        }
+    };
+};
+
+/**
+ * 测试任务惰性启动，嵌套 co_await 传递返回值
+ */
+TEST_F(TaskTest, NestedTasksReturnValues) {
+    bool started = false;
+    auto inner = [&](int x) -> Task<int> {
+        started = true;
+        co_return x * 2;
+    };
+    auto outer = [&]() -> Task<std::string> {
+        int a = co_await inner(1);
+        int b = co_await inner(20);
+        co_return std::to_string(a + b);
+    };
+
+    Task<std::string> task = outer();
+    EXPECT_FALSE(started);
+    EXPECT_FALSE(task.done());
+    task.start();
+    EXPECT_TRUE(task.done());
+    EXPECT_EQ(task.result(), "42");
+}
+
+/**
+ * 测试挂起的任务由外部事件恢复
+ */
+TEST_F(TaskTest, ResumesFromExternalEvent) {
+    Event event;
+    auto wait_twice = [&]() -> Task<int> {
+        int first = co_await event.next();
+        int second = co_await event.next();
+        co_return first + second;
+    };
+
+    Task<int> task = wait_twice();
+    task.start();
+    EXPECT_FALSE(task.done());
+    event.fire(3);
+    EXPECT_FALSE(task.done());
+    event.fire(4);
+    ASSERT_TRUE(task.done());
+    EXPECT_EQ(task.result(), 7);
+}
+
+/**
+ * 测试协程中的异常在等待者处重新抛出
+ */
+TEST_F(TaskTest, PropagatesExceptions) {
+    auto failing = []() -> Task<void> {
+        throw std::runtime_error("stream reset");
+        co_return;
+    };
+    auto caller = [&]() -> Task<bool> {
+        try {
+            co_await failing();
+        } catch (const std::runtime_error&) {
+            co_return true;
+        }
+        co_return false;
+    };
+
+    Task<bool> task = caller();
+    task.start();
+    ASSERT_TRUE(task.done());
+    EXPECT_TRUE(task.result());
+
+    Task<void> direct = failing();
+    direct.start();
+    EXPECT_THROW(direct.result(), std::runtime_error);
+}
+
+} // namespace http2
+
+#endif // HTTP2_HAVE_COROUTINES
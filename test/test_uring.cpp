@@ -0,0 +1,186 @@
+#include <gtest/gtest.h>
+#include "uring.h"
+#include "event_loop.h"
+#include <linux/io_uring.h>
+#include <sys/epoll.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+#include <string>
+
+namespace http2 {
+
+/**
+ * Test cases for the io_uring transport primitives
+ */
+class IoUringTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        if (!IoUring::supported()) {
+            GTEST_SKIP() << "io_uring is not available";
+        }
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sockets_), 0);
+    }
+
+    void TearDown() override {
+        if (sockets_[0] >= 0) {
+            close(sockets_[0]);
+            close(sockets_[1]);
+        }
+    }
+
+    int sockets_[2] = {-1, -1};
+};
+
+/**
+ * 测试多次接收：每次到达的数据各产生一个带缓冲区的完成事件
+ */
+TEST_F(IoUringTest, MultishotReceive) {
+    IoUring ring(16);
+    std::string received;
+    int completions = 0;
+    ring.recvMultishot(sockets_[0], [&](int32_t result, uint32_t flags) {
+        ASSERT_GT(result, 0);
+        ASSERT_TRUE(flags & IORING_CQE_F_BUFFER);
+        EXPECT_TRUE(flags & IORING_CQE_F_MORE);
+        uint16_t id = static_cast<uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT);
+        received.append(reinterpret_cast<const char*>(ring.receiveBuffer(id)), result);
+        ring.recycleReceiveBuffer(id);
+        ++completions;
+    });
+
+    EXPECT_EQ(ring.submitAndWait(0), 0);
+    ASSERT_EQ(write(sockets_[1], "hello", 5), 5);
+    EXPECT_EQ(ring.submitAndWait(1000), 1);
+    ASSERT_EQ(write(sockets_[1], " world", 6), 6);
+    EXPECT_EQ(ring.submitAndWait(1000), 1);
+
+    EXPECT_EQ(received, "hello world");
+    EXPECT_EQ(completions, 2);
+    EXPECT_EQ(ring.pending(), 1);
+}
+
+/**
+ * 测试链接的固定缓冲区写按顺序完成，并在一次 io_uring_enter 中提交
+ */
+TEST_F(IoUringTest, LinkedFixedWrites) {
+    IoUring ring(16);
+    int first = ring.acquireSendSlot();
+    int second = ring.acquireSendSlot();
+    ASSERT_GE(first, 0);
+    ASSERT_GE(second, 0);
+    std::memcpy(ring.sendSlot(first), "xxabc", 5);
+    std::memcpy(ring.sendSlot(second), "def", 3);
+
+    std::vector<int32_t> results;
+    ring.writeFixed(sockets_[0], first, 2, 3, true, [&](int32_t result, uint32_t) {
+        results.push_back(result);
+    });
+    ring.writeFixed(sockets_[0], second, 0, 3, false, [&](int32_t result, uint32_t) {
+        results.push_back(result);
+    });
+
+    uint64_t enters = ring.enterCalls();
+    while (results.size() < 2) {
+        ring.submitAndWait(1000);
+    }
+    EXPECT_LE(ring.enterCalls() - enters, 2);
+    EXPECT_EQ(results, (std::vector<int32_t>{3, 3}));
+
+    char buffer[16];
+    ASSERT_EQ(read(sockets_[1], buffer, sizeof(buffer)), 6);
+    EXPECT_EQ(std::string(buffer, 6), "abcdef");
+    ring.releaseSendSlot(first);
+    ring.releaseSendSlot(second);
+}
+
+/**
+ * 测试取消多次接收后回调不再被调用，操作最终完成
+ */
+TEST_F(IoUringTest, CancelReceive) {
+    IoUring ring(16);
+    int calls = 0;
+    uint64_t id = ring.recvMultishot(sockets_[0], [&](int32_t, uint32_t) { ++calls; });
+    ring.submitAndWait(0);
+    ring.cancel(id);
+    for (int i = 0; i < 10 && ring.pending() > 0; ++i) {
+        ring.submitAndWait(100);
+    }
+    EXPECT_EQ(ring.pending(), 0);
+
+    ASSERT_EQ(write(sockets_[1], "x", 1), 1);
+    ring.submitAndWait(0);
+    EXPECT_EQ(calls, 0);
+}
+
+/**
+ * 测试 IO_URING 后端的事件循环仍然分发 epoll 描述符
+ */
+TEST_F(IoUringTest, EventLoopDispatchesWatches) {
+    EventLoop loop(EventLoop::Backend::IO_URING);
+    ASSERT_NE(loop.uring(), nullptr);
+    int events = 0;
+    ASSERT_TRUE(loop.add(sockets_[0], EPOLLIN, [&](uint32_t) {
+        char c;
+        while (read(sockets_[0], &c, 1) == 1) {
+        }
+        ++events;
+    }));
+
+    loop.runOnce(0);
+    EXPECT_EQ(events, 0);
+    ASSERT_EQ(write(sockets_[1], "x", 1), 1);
+    for (int i = 0; i < 10 && events == 0; ++i) {
+        loop.runOnce(100);
+    }
+    EXPECT_EQ(events, 1);
+
+    ASSERT_EQ(write(sockets_[1], "y", 1), 1);
+    for (int i = 0; i < 10 && events == 1; ++i) {
+        loop.runOnce(100);
+    }
+    EXPECT_EQ(events, 2);
+
+    loop.remove(sockets_[0]);
+    loop.run();  // 只剩常驻的 epoll poll，立即返回
+}
+
+/**
+ * 测试完成回调中嵌套分发：已被嵌套一轮取走的完成事件不再重复分发
+ */
+TEST_F(IoUringTest, NestedDispatchSkipsConsumedCompletions) {
+    IoUring ring(16);
+    int other[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, other), 0);
+    ASSERT_EQ(write(sockets_[1], "x", 1), 1);
+    ASSERT_EQ(write(other[1], "x", 1), 1);
+
+    int first = 0;
+    int second = 0;
+    // 两个描述符都已可读，两个完成事件在同一次等待中到达；先分发的一个嵌套分发另一个
+    auto handler = [&](int& calls) {
+        return [&, counter = &calls](int32_t, uint32_t) {
+            ++*counter;
+            if (first + second == 1) {
+                EXPECT_EQ(ring.submitAndWait(0), 1);
+            }
+        };
+    };
+    ring.pollMultishot(sockets_[0], POLLIN, handler(first));
+    ring.pollMultishot(other[0], POLLIN, handler(second));
+
+    size_t outer = 0;
+    for (int i = 0; i < 10 && first + second < 2; ++i) {
+        outer += ring.submitAndWait(100);
+    }
+    EXPECT_EQ(first, 1);
+    EXPECT_EQ(second, 1);
+    EXPECT_EQ(outer, 1);
+
+    close(other[0]);
+    close(other[1]);
+}
+
+} // namespace http2